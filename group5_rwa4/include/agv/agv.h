@@ -1,6 +1,8 @@
 #ifndef AGV_H
 #define AGV_H
 #include "../util/util.h"
+#include <functional>
+#include <mutex>
 
 namespace motioncontrol {
     class Agv {
@@ -18,6 +20,24 @@ namespace motioncontrol {
          */
         bool shipAgv(std::string shipment_type, std::string station);
         bool getAGVStatus();
+        /**
+         * @brief Last state published on /ariac/agvN/state
+         *
+         * @return std::string e.g. "ready_to_deliver", empty before the first message
+         */
+        std::string getState();
+        /**
+         * @brief Last station published on /ariac/agvN/station
+         *
+         * @return std::string e.g. "ks1", "as2", empty before the first message
+         */
+        std::string getStation();
+        /**
+         * @brief Register a function called from the subscriber thread on every state or station message
+         *
+         * @param listener Called with (state, station)
+         */
+        void setUpdateListener(std::function<void(const std::string&, const std::string&)> listener);
 
 
     private:
@@ -27,11 +47,23 @@ namespace motioncontrol {
          * @param msg
          */
         void agv_state_callback(const std_msgs::String& msg);
+        /**
+         * @brief Station the AGV is currently at
+         *
+         * @param msg
+         */
+        void agv_station_callback(const std_msgs::String& msg);
+        void notify_listener();
         std::string agv_name_;
         ros::ServiceClient agv_client_;
         ros::Subscriber agv_state_subscriber_;
-        bool agv_ready_;
+        ros::Subscriber agv_station_subscriber_;
+        bool agv_ready_{false};
+        std::string state_;
+        std::string station_;
+        std::mutex mutex_;
+        std::function<void(const std::string&, const std::string&)> listener_;
     };//class
 }//namespace
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,97 @@
+#ifndef AGV_FLEET_H
+#define AGV_FLEET_H
+#include "agv.h"
+#include "../util/worker_threads.h"
+#include <condition_variable>
+#include <future>
+#include <memory>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Long-lived manager for agv1..agv4
+     *
+     * Created once at startup so each AGV has a single service client and
+     * its state/station subscriptions are running well before the first
+     * shipment. Shipments are submitted from a worker thread so the robots
+     * can keep working while the AGV becomes ready and the service returns.
+     */
+    class AgvFleet {
+        public:
+        /**
+         * @brief Called from the subscriber thread when an AGV reaches an assembly station
+         *
+         * Arguments are (agv_id, station).
+         */
+        using ArrivalCallback = std::function<void(const std::string&, const std::string&)>;
+
+        explicit AgvFleet(ros::NodeHandle& node);
+        ~AgvFleet();
+
+        /**
+         * @brief Submit an AGV shipment without blocking the caller
+         *
+         * The worker waits (up to @p ready_timeout) for the AGV to report
+         * "ready_to_deliver" before calling the service.
+         *
+         * @param agv_id agv1..agv4
+         * @param shipment_type Shipment type which should match the order
+         * @param station Assembly station
+         * @param ready_timeout Maximum time to wait for the AGV to be ready
+         * @return std::future<bool> Resolves to the service result
+         */
+        std::future<bool> shipAsync(const std::string& agv_id, const std::string& shipment_type,
+            const std::string& station, ros::Duration ready_timeout = ros::Duration(10.0));
+        /**
+         * @brief Register a callback fired on every arrival at an assembly station
+         *
+         * @param callback Called with (agv_id, station)
+         */
+        void onArrival(ArrivalCallback callback);
+        /**
+         * @brief Block until every AGV shipped to @p station has arrived there
+         *
+         * Returns immediately when no shipment to the station is pending.
+         *
+         * @param station as1..as4
+         * @param timeout Maximum time to wait
+         * @return true All pending deliveries arrived
+         * @return false Timed out
+         */
+        bool waitForDeliveries(const std::string& station, ros::Duration timeout);
+        /**
+         * @brief Is the AGV currently ready to deliver
+         *
+         * @param agv_id agv1..agv4
+         */
+        bool isReady(const std::string& agv_id);
+        /**
+         * @brief Last station reported by the AGV
+         *
+         * @param agv_id agv1..agv4
+         * @return std::string Empty if unknown
+         */
+        std::string getStation(const std::string& agv_id);
+
+        private:
+        struct AgvStatus {
+            std::string state;
+            std::string station;
+            std::string destination;  // assembly station a shipment was sent to, empty when none is pending
+        };
+
+        void update(const std::string& agv_id, const std::string& state, const std::string& station);
+        bool wait_until_ready(const std::string& agv_id, ros::Duration timeout);
+        // wait on status_changed_ until @p done or @p deadline, in ROS time so it follows /use_sim_time
+        bool waitUntil(std::unique_lock<std::mutex>& lock, const ros::Time& deadline, std::function<bool()> done);
+
+        std::map<std::string, std::unique_ptr<Agv> > agvs_;
+        std::map<std::string, AgvStatus> status_;
+        std::vector<ArrivalCallback> arrival_callbacks_;
+        WorkerThreads workers_;
+        std::mutex mutex_;
+        std::condition_variable status_changed_;
+    };
+}//namespace
+
+#endif
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <memory>
 #include <cstdarg>
 // nist
 #include <nist_gear/VacuumGripperState.h>
@@ -20,6 +21,23 @@
 // custom
 #include "../util/util.h"
 #include "../comp/comp_class.h"
+#include "trajectory_cache.h"
+#include "ik_table.h"
+#include "motion_pipeline.h"
+#include "gripper.h"
+#include "grasp.h"
+#include "grasp_offsets.h"
+#include "manipulator.h"
+#include "preset_graph.h"
+#include "joint_streamer.h"
+#include "motion_profile.h"
+#include "joint_state_cache.h"
+#include "planning_scene_manager.h"
+#include "tray_locks.h"
+#include "execution_monitor.h"
+#include "sweep_checker.h"
+#include "../camera/conveyor_tracker.h"
+#include "../planner/bin_stager.h"
 
 namespace motioncontrol {
 
@@ -61,6 +79,24 @@ namespace motioncontrol {
          * @return false 
          */
         bool pickfaulty(std::string part_type, geometry_msgs::Pose part_pose);
+        /**
+         * @brief Replace a faulty part on the agv with a spare in one motion sequence
+         *
+         * The faulty part is dropped where the arm stands (wrist turned away
+         * as in home2) instead of travelling to home2. The drop and the rail
+         * move to the spare run as one MotionPipeline, then the spare is
+         * picked and placed at the faulty part's slot. Spares are only
+         * reserved in the bins of the kitting arm, see SparePartPool.
+         *
+         * @param part_type Type of part
+         * @param faulty_pose Pose of the faulty part in world
+         * @param spare_pose Pose of the spare part in world
+         * @param goal_in_tray_frame Target pose of the part in the tray frame
+         * @param agv Agv_id
+         * @return true
+         * @return false
+         */
+        bool replaceFaultyPart(std::string part_type, geometry_msgs::Pose faulty_pose, geometry_msgs::Pose spare_pose, geometry_msgs::Pose goal_in_tray_frame, std::string agv);
         /**
          * @brief Place the part on the agv
          * 
@@ -79,10 +115,11 @@ namespace motioncontrol {
          * @param pose_in_world_frame Initial pose of the part in world
          * @param goal_in_tray_frame Target pose of the part in world
          * @param agv Agv_id
+         * @return true The part was placed on the tray
          */
-        void movePart(std::string part_type, geometry_msgs::Pose pose_in_world_frame, geometry_msgs::Pose goal_in_tray_frame, std::string agv);
+        bool movePart(std::string part_type, geometry_msgs::Pose pose_in_world_frame, geometry_msgs::Pose goal_in_tray_frame, std::string agv);
         /**
-         * @brief Activate kitting arm gripper
+         * @brief Activate kitting arm gripper, without waiting for it to be enabled
          * 
          */
         void activateGripper();
@@ -91,13 +128,31 @@ namespace motioncontrol {
          * 
          */
         void deactivateGripper();
+        /**
+         * @brief Bring the collision objects of the planning scene and the bin occupancy up to date
+         *
+         * @param parts Parts seen by the logical cameras
+         */
+        void updateScene(const std::vector<Product>& parts);
+        /**
+         * @brief Share the bin occupancy with the other robot, so both stage parts in the same free space
+         */
+        void setBinStager(const std::shared_ptr<BinStager>& stager);
+        std::shared_ptr<BinStager> binStager() const;
+        /**
+         * @brief Share the tray locks with the other robot, so only one works over a tray at a time
+         */
+        void setTrayLocks(const std::shared_ptr<TrayLocks>& trays);
+        std::shared_ptr<TrayLocks> trayLocks() const;
         /**
          * @brief Get the pose of the part to be place in empty bin 
          * 
-         * @param bin_number bin number, value in between 1-8
-         * @return geometry_msgs::Pose Pose in world frame
+         * @param bins Bins to try, in order, values in between 1-8
+         * @param pose Pose in world frame, the center of the first bin when none has room
+         * @param bin_number Bin the pose is in
+         * @return false No room left for the held part in any of @p bins
          */
-        geometry_msgs::Pose get_part_pose_in_empty_bin(int bin_number);
+        bool get_part_pose_in_empty_bin(const std::vector<int>& bins, geometry_msgs::Pose& pose, int& bin_number);
         /**
          * @brief Move the joint linear_arm_actuator_joint only
          *
@@ -108,6 +163,17 @@ namespace motioncontrol {
          * @param location A preset location
          */
         void moveBaseTo(double linear_arm_actuator_joint_position);
+        /**
+         * @brief Start moving the base along the rail while the arm has nothing to do
+         *
+         * Only the linear actuator moves, from the home postures with an empty
+         * gripper, so the motion is streamed without planning. The call does
+         * not wait: the next motion of the arm stops the base where it is if
+         * it is still far from @p linear_arm_actuator_joint_position.
+         *
+         * @return false The arm is busy, holds a part or is already there
+         */
+        bool prepositionBase(double linear_arm_actuator_joint_position);
         /**
          * @brief Get the Gripper State
          * 
@@ -119,10 +185,12 @@ namespace motioncontrol {
 
         /**
          * @brief Send command message to robot controller
-         * 
-         * @param command_msg 
-         * @return true 
-         * @return false 
+         *
+         * Published as is, nothing is planned or checked for collisions.
+         *
+         * @param command_msg Joints of the kitting arm, all of them when joint_names is empty
+         * @return true
+         * @return false A joint of the controller is missing from @p command_msg
          */
         bool sendJointPosition(trajectory_msgs::JointTrajectory command_msg);
         /**
@@ -133,12 +201,17 @@ namespace motioncontrol {
         void goToPresetLocation(std::string location_name);
         /**
          * @brief Pick part from conveyor
+         *
+         * Parts tracked by the belt camera are intercepted on the move, the
+         * arm waits parked over the belt only when the camera is silent.
          * 
          * @param ebin empty bin number
          * @param int number of parts to be picked
+         * @param wanted Part types to pick, any type when empty
          * @return std::vector<int> 
          */
-        std::vector<int> pick_from_conveyor(std::vector<int> ebin, unsigned short int);
+        std::vector<int> pick_from_conveyor(std::vector<int> ebin, unsigned short int,
+            const std::vector<std::string>& wanted = std::vector<std::string>());
         /**
          * @brief Flips the part(pump)
          * 
@@ -146,8 +219,9 @@ namespace motioncontrol {
          * @param rbin empty bins
          * @param part_pose_in_frame Pose in world frame 
          * @param agv Agv_id
+         * @return true The part was placed on the tray, turned over
          */
-        void flippart(Product part, std::vector<int> rbin, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool);
+        bool flippart(Product part, std::vector<int> rbin, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool);
 
         //--preset locations;
         start home1_, home2_;
@@ -163,30 +237,99 @@ namespace motioncontrol {
         std::array<double,3> bin6_origin_ { -1.898, -2.56, 0.751 };
         std::array<double,3> bin7_origin_ { -2.651, -2.56, 0.751 };
         std::array<double,3> bin8_origin_ { -2.651, -3.37, 0.751 };
-        int empty_bin_place_count = 0;
         std::vector<double> joint_group_positions_;
         std::vector<double> joint_arm_positions_;
         ros::NodeHandle node_;
         std::string planning_group_;
         moveit::planning_interface::MoveGroupInterface::Options arm_options_;
         moveit::planning_interface::MoveGroupInterface arm_group_;
-        sensor_msgs::JointState current_joint_states_;
-        control_msgs::JointTrajectoryControllerState arm_controller_state_;
+        // preset-to-preset trajectories, replanned only when the start differs
+        motioncontrol::TrajectoryCache preset_cache_;
+        motioncontrol::IkTable ik_table_;
+        // latest joint states, read without waiting on the MoveIt state monitor
+        JointStateCache joint_states_;
+        // workcell collision objects, the held part attached to the gripper
+        PlanningSceneManager scene_;
+        // parts on the belt and how far ahead they are intercepted
+        ConveyorTracker conveyor_;
+        double conveyor_lead_{ 4.0 };                           // time to reach the hover pose (s)
+        std::array<double,2> conveyor_reach_ { -4.0, 4.0 };     // belt y the gripper reaches from the rail
+        // free space in the bins for conveyor and flipped parts
+        std::shared_ptr<BinStager> stager_;
+        // kit trays and stations, held while the gripper works over them
+        std::shared_ptr<TrayLocks> trays_;
+        // tracking error of the arm controller: end of motions, stalls and collisions
+        ExecutionMonitor monitor_;
+        // end of the base motion started by prepositionBase(), zero when none
+        ros::Time preposition_until_;
 
-        nist_gear::VacuumGripperState gripper_state_;
-        // gripper state subscriber
-        ros::Subscriber gripper_state_subscriber_;
-        // service client
-        ros::ServiceClient gripper_control_client_;
+        Gripper gripper_;
         // publishers
         ros::Publisher arm_joint_trajectory_publisher_;
+        motioncontrol::JointStreamer streamer_;
+        // speeds per motion phase, see config/motion_profiles.yaml
+        motioncontrol::MotionProfiles profiles_;
+        // gripper heights over the parts, see config/grasp_offsets.yaml
+        GraspOffsets offsets_;
+        // type of the part picked last, sets the speeds while it is held
+        std::string held_type_;
         // joint states subscribers
         ros::Subscriber arm_joint_states_subscriber_;
         // controller state subscribers
         ros::Subscriber arm_controller_state_subscriber_;
 
+        /**
+         * @brief Move to a gripper pose, with a joint target solved from the IK table when it covers the pose
+         *
+         * @param pose Gripper pose in world
+         * @return true The motion succeeded
+         */
+        bool moveToPose(const geometry_msgs::Pose& pose);
+        /**
+         * @brief Pick a tracked part off the moving belt
+         *
+         * The part leaving the reach of the rail first is chosen, the gripper
+         * waits over its predicted track and rides along with it at contact.
+         *
+         * @param wanted Part types to pick, any type when empty
+         * @return false Nothing picked by @p deadline, or no belt camera messages
+         */
+        bool interceptFromBelt(const std::vector<std::string>& wanted, const ros::Time& deadline);
+        class Adapter;
+        /**
+         * @brief Top-down picks and places of the kitting arm
+         */
+        Manipulator<Adapter> manipulator();
+        /**
+         * @brief Transit profile for what the gripper holds right now
+         */
+        MotionProfile transitProfile() const;
+        /**
+         * @brief Robot state at the latest joint states, from MoveIt when none arrived recently
+         */
+        moveit::core::RobotStatePtr currentState();
+        /**
+         * @brief End effector pose in world, by forward kinematics on the latest joint states
+         */
+        geometry_msgs::Pose currentPose();
+        /**
+         * @brief Attach the held part to the gripper in the planning scene, after a top-down pick
+         */
+        void attachHeldPart();
+        /**
+         * @brief Wait for the last motion to come to rest, at most as long as the fixed pause it replaces
+         *
+         * @return false It stalled, faulted or is still moving
+         */
+        bool settle();
+        /**
+         * @brief Stop a base motion started by prepositionBase() before the arm moves again
+         *
+         * A motion about to end is let finish, a longer one is held at the current position.
+         */
+        void finishPreposition();
+
         // callbacks
-        void gripper_state_callback(const nist_gear::VacuumGripperState::ConstPtr& gripper_state_msg);
         void arm_joint_states_callback_(const sensor_msgs::JointState::ConstPtr& joint_state_msg);
         void arm_controller_state_callback(const control_msgs::JointTrajectoryControllerState::ConstPtr& msg);
     };
@@ -212,6 +355,7 @@ namespace gantry_motioncontrol {
             std::vector<double> gantry_full_preset;  //3 joints
             std::vector<double> gantry_torso_preset; //6 joints
             std::vector<double> gantry_arm_preset;   //9 joints
+            std::string name;                        //key in the preset graph
         } start, bin, agv, grasp, near_as, as;
 
         Gantry(ros::NodeHandle& node);
@@ -226,10 +370,11 @@ namespace gantry_motioncontrol {
          * @brief Picks the part using gantry arm
          * 
          * @param part_init_pose Initial pose in world
+         * @param part_type Type of the part, sets the grasp height and the speeds
          * @return true 
          * @return false 
          */
-        bool pickPart(geometry_msgs::Pose part_init_pose);
+        bool pickPart(geometry_msgs::Pose part_init_pose, const std::string& part_type = "");
         /**
          * @brief Places the part
          * 
@@ -267,6 +412,16 @@ namespace gantry_motioncontrol {
          * @param bin 
          */
         void move_gantry_to_bin(unsigned short int bin);
+        /**
+         * @brief Moves the gantry to the preset near bin with the arm already over a part to pick
+         *
+         * The arm takes the pregrasp pose while the torso travels.
+         *
+         * @param bin 
+         * @param part_type Type of the part, sets the pregrasp height
+         * @param part Pose of the part in world
+         */
+        void move_gantry_to_bin(unsigned short int bin, const std::string& part_type, const geometry_msgs::Pose& part);
         /**
          * @brief Moves the gantry to preset location near assembly station
          * 
@@ -280,14 +435,44 @@ namespace gantry_motioncontrol {
          * @param rbin empty bin
          * @param part_pose_in_frame Initial pose in world
          * @param agv Agv_id
+         * @param arm_required Pick the part from its bin first, otherwise it is already held
+         * @return false The flipped part could not be placed on @p agv
          */
-        void flippart(Product part, std::vector<int> rbin, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool);
+        bool flippart(Product part, std::vector<int> rbin, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool arm_required);
 
-        // Send command message to robot controller
+        /**
+         * @brief Send command message to the torso and arm controllers, without planning
+         *
+         * @param command_msg Joints of the full gantry, all of them when joint_names is empty
+         */
         bool sendJointPosition(trajectory_msgs::JointTrajectory command_msg);
         void goToPresetLocation(GantryPresetLocation location, bool full_robot=true);
+        /**
+         * @brief Move the whole gantry to a named preset along the fastest known route
+         *
+         * The route starts at the preset closest to the current joints and
+         * goes through the preset graph loaded from ~gantry_presets. From a
+         * preset the whole route is streamed to the controllers as one
+         * motion (see ~stream_presets), otherwise it is planned with MoveIt.
+         *
+         * @param name Preset name, e.g. "at_bin3" or "near_as2"
+         * @return false No route to @p name, or a move failed
+         */
+        bool goToLocation(const std::string& name);
         void activateGripper();
         void deactivateGripper();
+        /**
+         * @brief See motioncontrol::Arm::updateScene
+         */
+        void updateScene(const std::vector<Product>& parts);
+        /**
+         * @brief See motioncontrol::Arm::setBinStager
+         */
+        void setBinStager(const std::shared_ptr<motioncontrol::BinStager>& stager);
+        /**
+         * @brief See motioncontrol::Arm::setTrayLocks
+         */
+        void setTrayLocks(const std::shared_ptr<motioncontrol::TrayLocks>& trays);
         nist_gear::VacuumGripperState getGripperState();
         //--preset locations;
         start home_, home2_;
@@ -316,32 +501,125 @@ namespace gantry_motioncontrol {
         moveit::planning_interface::MoveGroupInterface full_gantry_group_;
         moveit::planning_interface::MoveGroupInterface arm_gantry_group_;
         moveit::planning_interface::MoveGroupInterface torso_gantry_group_;
-        sensor_msgs::JointState current_joint_states_;
-        nist_gear::VacuumGripperState gantry_gripper_state_;
-        control_msgs::JointTrajectoryControllerState gantry_torso_controller_state_;
-        control_msgs::JointTrajectoryControllerState gantry_arm_controller_state_;
+        motioncontrol::TrajectoryCache preset_cache_;
+        motioncontrol::PresetGraph presets_;
+        motioncontrol::IkTable ik_table_;
+        // latest joint states, read without waiting on the MoveIt state monitor
+        motioncontrol::JointStateCache joint_states_;
+        // workcell collision objects, the held part attached to the gripper
+        motioncontrol::PlanningSceneManager scene_;
+        // free space in the bins for flipped parts
+        std::shared_ptr<motioncontrol::BinStager> stager_;
+        std::shared_ptr<motioncontrol::TrayLocks> trays_;
+        motioncontrol::Gripper gripper_;
+        // tracking error of the torso and arm controllers: end of motions, stalls and collisions
+        motioncontrol::ExecutionMonitor monitor_;
 
         // publishers
         ros::Publisher gantry_torso_joint_trajectory_publisher_;
         ros::Publisher gantry_arm_joint_trajectory_publisher_;
+        // preset routes sent straight to both controllers as one blended motion
+        motioncontrol::JointStreamer streamer_;
+        bool stream_presets_{ true };
+        // collision check of streamed moves that leave the preset edges
+        motioncontrol::SweepChecker sweep_;
+        // speeds per motion phase, see config/motion_profiles.yaml
+        motioncontrol::MotionProfiles profiles_;
+        // gripper heights over the parts, see config/grasp_offsets.yaml
+        motioncontrol::GraspOffsets offsets_;
+        // type of the part picked last, sets the speeds while it is held
+        std::string held_type_;
 
         // joint states subscribers
         ros::Subscriber gantry_full_joint_states_subscriber_;
-        // gripper state subscriber
-        ros::Subscriber gantry_gripper_state_subscriber_;
         // controller state subscribers
         ros::Subscriber gantry_controller_state_subscriber_;
         ros::Subscriber gantry_arm_controller_state_subscriber_;
 
-        // service client
-        ros::ServiceClient gantry_gripper_control_client_;
-
         // For visualizing things in rviz
         moveit_visual_tools::MoveItVisualToolsPtr visual_tools_;
 
+        /**
+         * @brief Move the gantry arm to a gripper pose, see motioncontrol::Arm::moveToPose
+         */
+        bool moveToPose(const geometry_msgs::Pose& pose);
+        /**
+         * @brief Transit profile for what the gripper holds right now
+         */
+        motioncontrol::MotionProfile transitProfile() const;
+        /**
+         * @brief See motioncontrol::Arm::currentState
+         */
+        moveit::core::RobotStatePtr currentState();
+        /**
+         * @brief See motioncontrol::Arm::currentPose
+         */
+        geometry_msgs::Pose currentPose();
+        /**
+         * @brief Attach the held part to the gripper in the planning scene, after a top-down pick
+         */
+        void attachHeldPart();
+        /**
+         * @brief Wait for the last motion to come to rest, at most as long as the fixed pause it replaces
+         *
+         * @return false It stalled, faulted or is still moving
+         */
+        bool settle();
+        class Adapter;
+        /**
+         * @brief Top-down picks and places of the gantry arm
+         */
+        motioncontrol::Manipulator<Adapter> manipulator();
+        /**
+         * @brief Pick a part from above, lift it and go back to a rest pose
+         *
+         * @param part Pose of the part in world
+         * @param lift Height of the lift over the contact once the part is attached (m)
+         * @param rest Pose the arm goes back to with the part
+         * @return false Nothing attached
+         */
+        bool graspFromAbove(const std::string& part_type, const geometry_msgs::Pose& part, double lift,
+            const geometry_msgs::Pose& rest);
+        /**
+         * @brief Append the preset moves from the current joints to @p to
+         *
+         * Each move records its duration in the preset graph once executed.
+         *
+         * @return false @p to is unknown or cannot be reached
+         */
+        bool addRoute(motioncontrol::MotionPipeline& pipeline, const std::string& to);
+        /**
+         * @brief Presets from the current joints to @p to
+         *
+         * @param from Filled with the preset the gantry is on, empty when it is off every preset
+         * @param path Filled with the presets to go through, ending with @p to
+         */
+        bool routeFromHere(const std::string& to, std::string& from, std::vector<std::string>& path);
+        /**
+         * @brief Go through @p path without stopping at its presets
+         *
+         * The blends leave the preset edges around each preset passed, so
+         * the streamed trajectory is checked for collisions before it is sent.
+         *
+         * @return false The sweep collides, or the gantry did not reach the end of @p path
+         */
+        bool streamRoute(const std::string& from, const std::vector<std::string>& path);
+        /**
+         * @brief Drive to the preset @p to with the arm taking the gripper pose @p pose on the way
+         *
+         * Torso and arm move as one streamed trajectory: the arm leaves the
+         * preset posture on the last leg of the route, so it is at @p pose
+         * when the torso stops. The whole sweep is checked for collisions
+         * first, the blends at the presets passed included. When it collides or has no IK, the
+         * arm moves once the torso is there, as a planned motion.
+         *
+         * @param pose Gripper pose in world, reachable with the torso at @p to
+         * @return false @p to cannot be reached
+         */
+        bool travelPreshaped(const std::string& to, const geometry_msgs::Pose& pose);
+
         // callbacks
         void gantry_full_joint_states_callback_(const sensor_msgs::JointState::ConstPtr& joint_state_msg);
-        void gantry_gripper_state_callback(const nist_gear::VacuumGripperState::ConstPtr& msg);
         void gantry_controller_state_callback(const control_msgs::JointTrajectoryControllerState::ConstPtr& msg);
         void gantry_arm_controller_state_callback(const control_msgs::JointTrajectoryControllerState::ConstPtr& msg);
     };
@@ -0,0 +1,88 @@
+#ifndef EXECUTION_MONITOR_H
+#define EXECUTION_MONITOR_H
+#include <ros/ros.h>
+#include <control_msgs/JointTrajectoryControllerState.h>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Thresholds of an ExecutionMonitor
+     */
+    struct MonitorOptions {
+        double settle_error{ 0.01 };      // largest |desired - actual| of a joint at rest (rad or m)
+        double settle_velocity{ 0.01 };   // largest |velocity| of a joint at rest
+        double fault_error{ 0.5 };        // tracking error a free motion never reaches: collision or stuck joint
+        double stall_velocity{ 0.005 };   // a joint slower than this does not move
+        double stall_time{ 0.5 };         // commanded to move without moving for this long is a stall (s)
+        double max_age{ 0.2 };            // controller states older than this are not used (s)
+    };
+
+    /**
+     * @brief Follows trajectory execution through the controller state topics
+     *
+     * The joint trajectory controllers publish the desired and actual joint
+     * positions and their difference. A motion is over once the desired
+     * point stopped and the actual one caught up with it, which is usually
+     * well before a fixed pause would end. A tracking error beyond
+     * fault_error, or joints commanded to move that do not for stall_time,
+     * is reported as soon as the controller shows it, through the fault
+     * callback, so the caller can stop the motion and recover.
+     *
+     * A robot may have several controllers (gantry torso and arm), their
+     * states are combined.
+     */
+    class ExecutionMonitor {
+        public:
+        // from best to worst, the worst controller gives the combined status
+        enum class Status { NO_STATE, SETTLED, MOVING, STALLED, FAULT };
+
+        void init(const MonitorOptions& options = MonitorOptions());
+        /**
+         * @brief Called once per motion that stalls or faults, from the subscriber thread
+         *
+         * The argument describes the fault.
+         */
+        void onFault(std::function<void(const std::string&)> callback);
+        /**
+         * @brief Store the state of @p controller, from its subscriber callback
+         */
+        void update(const std::string& controller, const control_msgs::JointTrajectoryControllerState& state);
+        /**
+         * @brief Combined status of the controllers
+         */
+        Status status() const;
+        /**
+         * @brief Wait until every controller is at rest on its goal
+         *
+         * Without controller state this only waits for @p deadline, as a fixed pause would.
+         *
+         * @return false The motion stalled or faulted, or is still going at @p deadline
+         */
+        bool waitSettled(const ros::Time& deadline);
+
+        private:
+        struct Controller {
+            ros::Time stamp;
+            double error{ 0.0 };              // largest |error| of the joints
+            double velocity{ 0.0 };           // largest |actual velocity|
+            double desired_velocity{ 0.0 };   // largest |desired velocity|
+            ros::Time still_since;            // commanded to move and not moving since, zero when moving
+            bool reported{ false };           // a fault of the current motion was already reported
+        };
+
+        Status classify(const Controller& controller, const ros::Time& now) const;
+
+        MonitorOptions options_;
+        std::function<void(const std::string&)> fault_callback_;
+        std::map<std::string, Controller> controllers_;
+        mutable std::mutex mutex_;
+        std::condition_variable changed_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef GRASP_H
+#define GRASP_H
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <geometry_msgs/Pose.h>
+#include <Eigen/Geometry>
+#include <vector>
+#include "gripper.h"
+#include "joint_state_cache.h"
+#include "motion_profile.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Speeds and tolerances of a GraspPrimitive
+     */
+    struct GraspOptions {
+        MotionProfile approach;                   // to the pregrasp pose
+        MotionProfile descent{ 0.05, 0.05 };      // below the pregrasp pose
+        MotionProfile retreat;                    // lift once the part is attached
+        double eef_step{ 0.005 };         // Cartesian interpolation step (m)
+        double attach_timeout{ 0.5 };     // wait for the gripper state after the descent ends (s)
+        double stream_speed{ 0.02 };      // gripper speed of a streamed guarded move (m/s)
+        double stream_period{ 0.02 };     // time between two streamed joint commands (s)
+        double track_hover{ 0.08 };       // height above the contact a moving pick starts from (m)
+        double track_descent{ 1.0 };      // time to come down onto a moving part (s)
+        double track_dwell{ 0.3 };        // time riding along at contact, for the suction to take (s)
+        double track_lift{ 0.15 };        // height of the lift off a moving part (m)
+        double track_lift_time{ 0.8 };    // time of that lift (s)
+        double track_period{ 0.05 };      // time between two points of a moving pick (s)
+    };
+
+    /**
+     * @brief Grasp speeds of @p part_type taken from @p profiles
+     *
+     * @param descent Phase of the motion below the pregrasp pose, MotionPhase::PLACE when placing
+     */
+    GraspOptions graspOptions(const MotionProfiles& profiles, const std::string& part_type,
+        MotionPhase descent = MotionPhase::CONTACT);
+
+    /**
+     * @brief Approach, descend and lift of a vacuum gripper as straight-line motions
+     *
+     * The approach and the descent are joined into one time-parameterised
+     * trajectory and sent as a single goal. During a pick the descent is
+     * guarded: the motion is stopped as soon as the gripper reports the part
+     * attached, then the arm lifts along @p retreat.
+     */
+    class GraspPrimitive {
+        public:
+        /**
+         * @param group Group whose end effector carries the gripper
+         * @param gripper Gripper on the end effector of @p group
+         * @param joint_states Start states of the motions, MoveIt is asked when null or stale
+         */
+        GraspPrimitive(moveit::planning_interface::MoveGroupInterface& group,
+            Gripper& gripper, const GraspOptions& options = GraspOptions(),
+            const JointStateCache* joint_states = nullptr);
+
+        /**
+         * @brief Pick a part, enabling the gripper on the way
+         *
+         * @param pregrasp Pose above the part, reached at approach speed
+         * @param bottom Lowest pose of the descent, under the expected contact
+         * @param retreat Poses to go through once the part is attached
+         * @return false The part is not attached at the end of the descent, the arm is left there
+         */
+        bool pick(const geometry_msgs::Pose& pregrasp, const geometry_msgs::Pose& bottom,
+            const std::vector<geometry_msgs::Pose>& retreat);
+        /**
+         * @brief Bring a held part down to where it is released
+         *
+         * @param above Pose above the release pose, reached at approach speed
+         * @param release Pose where the caller turns the gripper off
+         * @return false The motion could not be computed or executed
+         */
+        bool place(const geometry_msgs::Pose& above, const geometry_msgs::Pose& release);
+        /**
+         * @brief Move the gripper in a straight line until a part is attached
+         *
+         * Joint positions solved a small step ahead are published straight to
+         * the trajectory controller, without planning, one every
+         * GraspOptions::stream_period.
+         *
+         * @param command Command topic of the controller of the group
+         * @param direction Direction of the motion in the world frame
+         * @param max_distance Distance after which the move gives up (m)
+         * @return false Nothing attached within @p max_distance
+         */
+        bool guardedMove(const ros::Publisher& command, const Eigen::Vector3d& direction, double max_distance);
+        /**
+         * @brief Pose a moving pick starts from, see trackingPick
+         */
+        geometry_msgs::Pose trackingHover(const geometry_msgs::Pose& contact, const Eigen::Vector3d& velocity) const;
+        /**
+         * @brief Pick a part moving at constant velocity, riding along with it at contact
+         *
+         * The gripper follows the part the whole time: it comes down onto it,
+         * stays on it at the same speed while the suction takes, then lifts
+         * off. The joint positions are solved ahead and sent as a single
+         * trajectory stamped to start on time. The group must be waiting at
+         * trackingHover() and the gripper enabled.
+         *
+         * @param command Command topic of the controller of the group
+         * @param contact Gripper pose touching the part at @p contact_time
+         * @param velocity Velocity of the part in the world frame (m/s)
+         * @return false Too late to start, no IK along the way, or nothing attached after the lift
+         */
+        bool trackingPick(const ros::Publisher& command, const geometry_msgs::Pose& contact,
+            const Eigen::Vector3d& velocity, const ros::Time& contact_time);
+
+        private:
+        bool approach(const geometry_msgs::Pose& above, const geometry_msgs::Pose& target,
+            robot_trajectory::RobotTrajectory& trajectory);
+        bool cartesian(const moveit::core::RobotState& start, const std::vector<geometry_msgs::Pose>& waypoints,
+            const MotionProfile& profile, robot_trajectory::RobotTrajectory& trajectory);
+        bool execute(const robot_trajectory::RobotTrajectory& trajectory, bool stop_on_attach);
+
+        moveit::planning_interface::MoveGroupInterface& group_;
+        Gripper& gripper_;
+        GraspOptions options_;
+        const JointStateCache* joint_states_;
+    };
+}//namespace
+
+#endif
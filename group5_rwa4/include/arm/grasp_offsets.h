@@ -0,0 +1,63 @@
+#ifndef GRASP_OFFSETS_H
+#define GRASP_OFFSETS_H
+#include <map>
+#include <string>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Gripper heights of a top-down pick, relative to the part origin (m)
+     */
+    struct GraspOffset {
+        double contact{ 0.03 };   // gripper over the part origin when it touches
+        double hover{ 0.03 };     // pregrasp pose over the contact
+        double search{ 0.03 };    // bottom of the planned descent under the contact
+        double guard{ 0.05 };     // further streamed descent when nothing is attached
+    };
+
+    /**
+     * @brief Where a held part is released
+     */
+    enum class ReleaseSite {
+        TRAY,       // kit tray on an AGV
+        BRIEFCASE,  // briefcase of an assembly station
+        BIN         // bin floor
+    };
+
+    /**
+     * @brief Grasp offsets per part type and release heights per site
+     *
+     * Loaded from a YAML file (config/grasp_offsets.yaml), used by both
+     * robots. A part type matches an override when it contains its key,
+     * as in MotionProfiles.
+     */
+    class GraspOffsets {
+        public:
+        GraspOffsets();
+
+        /**
+         * @return false The file could not be read, the built-in offsets are kept
+         */
+        bool load(const std::string& path);
+        /**
+         * @brief Offsets of @p part_type, the defaults for an unknown type
+         */
+        GraspOffset select(const std::string& part_type) const;
+        /**
+         * @brief Gripper height over the target of the part origin when the part is let go (m)
+         */
+        double release(ReleaseSite site) const;
+        /**
+         * @brief Site of a placePart/movePart location: agv1..agv4 or as1..as4
+         */
+        static ReleaseSite site(const std::string& location);
+
+        private:
+        GraspOffset default_;
+        // part type key -> offsets
+        std::map<std::string, GraspOffset> parts_;
+        std::map<ReleaseSite, double> release_;
+    };
+}//namespace
+
+#endif
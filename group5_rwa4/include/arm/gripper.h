@@ -0,0 +1,74 @@
+#ifndef GRIPPER_H
+#define GRIPPER_H
+#include <ros/ros.h>
+#include <nist_gear/VacuumGripperState.h>
+#include <nist_gear/VacuumGripperControl.h>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Vacuum gripper of one robot, driven by its state topic
+     *
+     * The state subscription wakes up whoever waits on the gripper, so
+     * callers block on enabled/attached instead of polling the state and
+     * calling the control service in a loop. At most one enable request is
+     * in flight at a time.
+     */
+    class Gripper {
+        public:
+        /**
+         * @brief Subscribe to @p prefix/state and connect to @p prefix/control
+         *
+         * @param prefix e.g. "/ariac/kitting/arm/gripper"
+         */
+        void init(ros::NodeHandle& node, const std::string& prefix);
+
+        nist_gear::VacuumGripperState state() const;
+        bool enabled() const;
+        bool attached() const;
+
+        /**
+         * @brief Ask for suction without waiting for the answer
+         *
+         * Does nothing when the gripper is already enabled or a request is pending.
+         */
+        void enableAsync();
+        void disable();
+        /**
+         * @brief Wait until the gripper is enabled, asking again when a request did not take
+         *
+         * @return false Still disabled at @p deadline
+         */
+        bool waitEnabled(const ros::Time& deadline);
+        /**
+         * @return false Nothing attached at @p deadline
+         */
+        bool waitAttached(const ros::Time& deadline);
+        /**
+         * @brief Wait until the state topic reports the part gone after the last disable()
+         *
+         * @return false Still attached, or no report since the disable, at @p deadline
+         */
+        bool waitReleased(const ros::Time& deadline);
+
+        private:
+        bool call(bool enable);
+        void state_callback(const nist_gear::VacuumGripperState::ConstPtr& msg);
+
+        mutable std::mutex mutex_;
+        std::condition_variable changed_;
+        nist_gear::VacuumGripperState state_;
+        unsigned long reports_{ 0 };            // state messages received
+        unsigned long reports_at_disable_{ 0 };
+        std::future<bool> request_;
+        ros::Time requested_;
+        ros::Subscriber state_subscriber_;
+        ros::ServiceClient control_client_;
+    };
+}//namespace
+
+#endif
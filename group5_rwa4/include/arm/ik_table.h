@@ -0,0 +1,73 @@
+#ifndef IK_TABLE_H
+#define IK_TABLE_H
+#include <moveit/robot_state/robot_state.h>
+#include <geometry_msgs/Pose.h>
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Precomputed arm joint values over a grid of wrist-down gripper poses
+     *
+     * Poses are expressed in the arm base frame, the parent link of the first
+     * revolute joint of the group, so one table covers every position of the
+     * kitting rail or of the gantry torso. The grid is x, y, z in @p cell
+     * steps and the gripper yaw in @p yaw_step steps. Only the revolute
+     * joints are stored, the rail/torso keep their current values.
+     *
+     * The table is built offline by build_ik_table and loaded at startup.
+     */
+    class IkTable {
+        public:
+        explicit IkTable(double cell = 0.05, double yaw_step = M_PI / 4);
+
+        /**
+         * @brief Load a table written by save()
+         *
+         * @return false The file could not be read, the table is left empty
+         */
+        bool load(const std::string& path);
+        bool save(const std::string& path) const;
+        bool empty() const { return entries_.empty(); }
+        std::size_t size() const { return entries_.size(); }
+
+        /**
+         * @brief Base frame of @p group, the parent link of its first revolute joint
+         */
+        static const moveit::core::LinkModel* baseLink(const moveit::core::JointModelGroup* group);
+        /**
+         * @brief Stored arm joints for the grid cell of a gripper pose
+         *
+         * @param pose Gripper pose in the arm base frame
+         * @param joints Filled with the revolute joint values of the group
+         * @return false The pose is not wrist-down or its cell is empty
+         */
+        bool lookup(const geometry_msgs::Pose& pose, std::vector<double>& joints) const;
+        void insert(const geometry_msgs::Pose& pose, const std::vector<double>& joints);
+        /**
+         * @brief Solve IK for @p pose starting from the table entry of its cell
+         *
+         * @param current Current state of the robot, the rail/torso joints are kept
+         * @param group Planning group, e.g. "kitting_arm"
+         * @param pose Gripper pose in the world frame
+         * @param joints Filled with the joint values of the whole group
+         * @param timeout Time given to the IK solver
+         * @return false No table entry for the pose or IK failed, plan from the pose instead
+         */
+        bool solve(const moveit::core::RobotState& current, const std::string& group,
+            const geometry_msgs::Pose& pose, std::vector<double>& joints, double timeout = 0.05) const;
+
+        private:
+        typedef std::array<long, 4> Key;
+        bool make_key(const geometry_msgs::Pose& pose, Key& key) const;
+
+        double cell_;
+        double yaw_step_;
+        std::map<Key, std::vector<double> > entries_;
+    };
+}//namespace
+
+#endif
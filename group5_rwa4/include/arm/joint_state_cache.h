@@ -0,0 +1,97 @@
+#ifndef JOINT_STATE_CACHE_H
+#define JOINT_STATE_CACHE_H
+#include <ros/ros.h>
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <sensor_msgs/JointState.h>
+#include <geometry_msgs/Pose.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Latest joint state of a robot, filled from its joint_states topic
+     *
+     * MoveGroupInterface::getCurrentState() and getCurrentPose() wait on the
+     * MoveIt current state monitor for a state newer than the call. The
+     * joint_states callback already receives every state, so this keeps the
+     * last one and computes the end effector pose from it locally.
+     *
+     * One writer (the subscriber callback) and any number of readers. The
+     * positions are guarded by a sequence counter instead of a mutex: the
+     * writer makes it odd while it copies, readers retry when it was odd or
+     * changed during their read. Neither side ever blocks.
+     */
+    class JointStateCache {
+        public:
+        /**
+         * @param model Model of the robot publishing the joint states
+         * @param end_effector Link whose pose pose() returns
+         * @param max_age States older than this are not used (s)
+         */
+        void init(const moveit::core::RobotModelConstPtr& model, const std::string& end_effector, double max_age = 0.1);
+        /**
+         * @brief Store a joint state, from the subscriber callback only
+         */
+        void update(const sensor_msgs::JointState& joint_state);
+
+        /**
+         * @brief Position of every variable of the model, in model order
+         *
+         * @return false No state yet, or the last one is older than the maximum age
+         */
+        bool positions(std::vector<double>& positions) const;
+        /**
+         * @brief Positions of @p joints, in that order
+         */
+        bool positions(const std::vector<std::string>& joints, std::vector<double>& positions) const;
+        /**
+         * @brief New robot state at the latest joint positions, nullptr when there is no recent one
+         */
+        moveit::core::RobotStatePtr state() const;
+        /**
+         * @brief Pose of the end effector in the model frame, by forward kinematics
+         *
+         * Not thread safe: it reuses one robot state, call it from the thread moving the robot.
+         */
+        bool pose(geometry_msgs::Pose& pose);
+
+        private:
+        bool read(std::vector<double>& positions, double& stamp) const;
+
+        moveit::core::RobotModelConstPtr model_;
+        std::string end_effector_;
+        double max_age_{ 0.1 };
+        std::size_t size_{ 0 };
+        // even when positions_ is consistent, odd while update() writes it
+        std::atomic<std::uint64_t> sequence_{ 0 };
+        std::unique_ptr<std::atomic<double>[]> positions_;
+        std::atomic<double> stamp_{ 0.0 };
+        // writer side: message index -> model variable index, rebuilt when the names change
+        std::vector<std::string> names_;
+        std::vector<int> index_;
+        // forward kinematics for pose()
+        std::unique_ptr<moveit::core::RobotState> kinematics_;
+        std::vector<double> scratch_;
+    };
+
+    /**
+     * @brief Robot state from @p joint_states, from @p group's MoveIt state monitor when it is null or stale
+     *
+     * @p joint_states must hold the robot of @p group.
+     */
+    moveit::core::RobotStatePtr latestState(const JointStateCache* joint_states,
+        moveit::planning_interface::MoveGroupInterface& group);
+    /**
+     * @brief Joint values of @p group in the group order, from the same sources as latestState
+     */
+    std::vector<double> latestJointValues(const JointStateCache* joint_states,
+        moveit::planning_interface::MoveGroupInterface& group);
+}//namespace
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef JOINT_STREAMER_H
+#define JOINT_STREAMER_H
+#include <ros/ros.h>
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <trajectory_msgs/JointTrajectory.h>
+#include <string>
+#include <vector>
+#include "motion_profile.h"
+#include "joint_state_cache.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Limits and timing of a JointStreamer
+     */
+    struct StreamOptions {
+        double velocity_scaling{ 1.0 };   // fraction of the joint velocity limits
+        double acceleration{ 1.0 };       // used for joints without an acceleration limit (rad/s^2 or m/s^2)
+        double sample_period{ 0.05 };     // time between two points sent to the controller (s)
+        double goal_tolerance{ 0.02 };    // largest joint error once the motion is over
+        double settle_timeout{ 1.0 };     // wait for the goal tolerance after the motion ends (s)
+    };
+
+    /**
+     * @brief Joint-space motions sent straight to the trajectory controllers, without planning
+     *
+     * Nothing is checked against the scene here. The blends leave the
+     * straight joint-space line between waypoints, so a trajectory through
+     * several waypoints has to be checked by the caller (SweepChecker) even
+     * when every edge between them is known to be collision free.
+     *
+     * A chain of waypoints is timed as linear segments with parabolic blends.
+     * Each segment lasts as long as its slowest joint needs under the
+     * velocity and acceleration limits of the robot model, so the joints
+     * start and stop together. Interior waypoints are blended rather than
+     * stopped at: the motion passes close to them at speed.
+     */
+    class JointStreamer {
+        public:
+        /**
+         * @param group Group whose active joints, in order, are the joints of every waypoint
+         */
+        void init(const moveit::core::RobotModelConstPtr& model, const std::string& group,
+            const StreamOptions& options = StreamOptions());
+        /**
+         * @brief Controller taking part of the joints of the group
+         *
+         * @param command Command topic of the controller
+         * @param joints Joints it drives
+         */
+        void addController(const ros::Publisher& command, const std::vector<std::string>& joints);
+
+        /**
+         * @brief Time a motion through @p waypoints, starting and ending at rest
+         *
+         * @param durations Filled with the time between two consecutive waypoints (s)
+         * @param profile Scaling of the joint limits, on top of StreamOptions::velocity_scaling
+         * @return false Wrong number of joints, or no timing respects the limits
+         */
+        bool plan(const std::vector<double>& start, const std::vector<std::vector<double> >& waypoints,
+            trajectory_msgs::JointTrajectory& trajectory, std::vector<double>& durations,
+            const MotionProfile& profile = MotionProfile()) const;
+        /**
+         * @brief Send @p trajectory to the controllers without waiting
+         *
+         * Each controller gets its own joints, all starting at the same time.
+         */
+        bool send(trajectory_msgs::JointTrajectory trajectory) const;
+        /**
+         * @brief Send @p trajectory and wait until the joints are at its last point
+         *
+         * @param joint_states Polled for the joints, @p group only when it has no recent state
+         * @return false The joints are not within the goal tolerance in time
+         */
+        bool execute(const trajectory_msgs::JointTrajectory& trajectory, const JointStateCache& joint_states,
+            moveit::planning_interface::MoveGroupInterface& group) const;
+
+        private:
+        struct Controller {
+            ros::Publisher command;
+            std::vector<std::string> joints;
+        };
+
+        bool blend(const std::vector<double>& points, const std::vector<double>& durations,
+            double acceleration, std::vector<double>& phases, std::vector<double>& accelerations) const;
+
+        StreamOptions options_;
+        std::vector<std::string> joint_names_;
+        std::vector<double> max_velocity_;
+        std::vector<double> max_acceleration_;
+        std::vector<Controller> controllers_;
+    };
+}//namespace
+
+#endif
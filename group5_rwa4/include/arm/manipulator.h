@@ -0,0 +1,167 @@
+#ifndef MANIPULATOR_H
+#define MANIPULATOR_H
+#include <ros/ros.h>
+#include <geometry_msgs/Pose.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <Eigen/Geometry>
+#include <string>
+#include <vector>
+#include "grasp.h"
+#include "grasp_offsets.h"
+#include "motion_profile.h"
+#include "../trace/trace.h"
+#include "../util/util.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Top-down pick and place of a vacuum gripper, for any robot
+     *
+     * The offsets come from the robot's GraspOffsets table, the speeds from
+     * its MotionProfiles, so both robots pick and place the same way and a
+     * change here reaches both. @p Robot is a small adapter held by value,
+     * giving access to the robot's parts:
+     *
+     *   moveit::planning_interface::MoveGroupInterface& group()   group carrying the gripper
+     *   Gripper& gripper()
+     *   const JointStateCache& jointStates()    latest states of the robot of group()
+     *   const ros::Publisher& command()          trajectory command topic of group()
+     *   const MotionProfiles& profiles()
+     *   const GraspOffsets& offsets()
+     *   bool moveToPose(const geometry_msgs::Pose& pose)
+     *   void hold(const std::string& part_type, const geometry_msgs::Pose& part)   part about to be picked
+     *   void attach()                           part attached, into the planning scene
+     *   void letGo()                            gripper off, part out of the planning scene
+     *   bool settle()                           wait for the last motion to come to rest
+     */
+    template <typename Robot>
+    class Manipulator {
+        public:
+        explicit Manipulator(Robot robot) : robot_(robot) {}
+
+        /**
+         * @brief Gripper pose pointing down at @p position
+         */
+        static geometry_msgs::Pose wristDown(const geometry_msgs::Point& position)
+        {
+            auto flat_orientation = quaternionFromEuler(0, 1.57, 0);
+            geometry_msgs::Pose pose;
+            pose.position = position;
+            pose.orientation.x = flat_orientation.getX();
+            pose.orientation.y = flat_orientation.getY();
+            pose.orientation.z = flat_orientation.getZ();
+            pose.orientation.w = flat_orientation.getW();
+            return pose;
+        }
+        /**
+         * @brief Gripper pose pointing down, @p height over the contact with @p part
+         */
+        geometry_msgs::Pose above(const std::string& part_type, const geometry_msgs::Pose& part, double height) const
+        {
+            auto pose = wristDown(part.position);
+            pose.position.z += robot_.offsets().select(part_type).contact + height;
+            return pose;
+        }
+        /**
+         * @brief Pick @p part from above and lift it through @p retreat
+         *
+         * The planned descent stops as soon as the part is attached. When it
+         * ends with nothing attached, a streamed guarded descent goes on for
+         * GraspOffset::guard.
+         *
+         * @param part Pose of the part origin in world
+         * @param retreat Poses to go through once the part is attached
+         * @return false Nothing attached, the gripper is left where the search ended
+         */
+        bool pick(const std::string& part_type, const geometry_msgs::Pose& part,
+            const std::vector<geometry_msgs::Pose>& retreat)
+        {
+            tracing::Span span("manipulator", "pick");
+            span.arg("type", part_type);
+            robot_.hold(part_type, part);
+            auto offset = robot_.offsets().select(part_type);
+            GraspPrimitive grasp(robot_.group(), robot_.gripper(), graspOptions(robot_.profiles(), part_type), &robot_.jointStates());
+            if (grasp.pick(above(part_type, part, offset.hover), above(part_type, part, -offset.search), retreat)) {
+                ROS_INFO_STREAM("[Gripper] = object attached");
+                robot_.attach();
+                return true;
+            }
+
+            // the part sits lower than expected, keep going down until it is attached
+            if (!robot_.gripper().waitEnabled(ros::Time::now() + ros::Duration(2.0)) ||
+                !grasp.guardedMove(robot_.command(), Eigen::Vector3d(0, 0, -1), offset.guard)) {
+                ROS_ERROR_STREAM("[Manipulator][pick] Could not attach " << part_type);
+                return false;
+            }
+            ROS_INFO_STREAM("[Gripper] = object attached");
+            robot_.attach();
+            robot_.profiles().select(MotionPhase::LOADED_TRANSIT, part_type).apply(robot_.group());
+            for (auto& pose : retreat)
+                robot_.moveToPose(pose);
+            return true;
+        }
+        /**
+         * @brief Gripper pose releasing a part picked at @p part_init so that it lands at @p target
+         *
+         * The gripper turns by the rotation of the part from @p part_init to @p target.
+         *
+         * @param part_init Pose of the part when it was picked, in world
+         * @param target Pose of the part once placed, in world
+         */
+        geometry_msgs::Pose releasePose(const geometry_msgs::Pose& part_init, const geometry_msgs::Pose& target,
+            ReleaseSite site) const
+        {
+            auto gripper = wristDown(target.position);
+            tf2::Quaternion q_init_part(part_init.orientation.x, part_init.orientation.y,
+                part_init.orientation.z, part_init.orientation.w);
+            tf2::Quaternion q_target_part(target.orientation.x, target.orientation.y,
+                target.orientation.z, target.orientation.w);
+            tf2::Quaternion q_current(gripper.orientation.x, gripper.orientation.y,
+                gripper.orientation.z, gripper.orientation.w);
+            // relative rotation between init and target, applied to the gripper
+            tf2::Quaternion q_rslt = q_target_part * q_init_part.inverse() * q_current;
+            q_rslt.normalize();
+            gripper.orientation.x = q_rslt.x();
+            gripper.orientation.y = q_rslt.y();
+            gripper.orientation.z = q_rslt.z();
+            gripper.orientation.w = q_rslt.w();
+            gripper.position.z += robot_.offsets().release(site);
+            return gripper;
+        }
+        /**
+         * @brief Bring the held part down through @p above to @p release and let it go
+         *
+         * @return false The gripper still holds a part
+         */
+        bool place(const std::string& part_type, const geometry_msgs::Pose& above, const geometry_msgs::Pose& release)
+        {
+            tracing::Span span("manipulator", "place");
+            span.arg("type", part_type);
+            auto options = graspOptions(robot_.profiles(), part_type, MotionPhase::PLACE);
+            GraspPrimitive grasp(robot_.group(), robot_.gripper(), options, &robot_.jointStates());
+            if (!grasp.place(above, release)) {
+                options.approach.apply(robot_.group());
+                robot_.moveToPose(above);
+                options.descent.apply(robot_.group());
+                robot_.moveToPose(release);
+            }
+            return letGo();
+        }
+        /**
+         * @brief Release the held part once the gripper is at rest
+         *
+         * @return false The gripper still holds a part
+         */
+        bool letGo()
+        {
+            robot_.settle();
+            robot_.letGo();
+            return !robot_.gripper().attached();
+        }
+
+        private:
+        Robot robot_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef MOTION_PIPELINE_H
+#define MOTION_PIPELINE_H
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <functional>
+#include <vector>
+#include "joint_state_cache.h"
+#include "trajectory_cache.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief One motion of a MotionPipeline
+     */
+    struct MotionSegment {
+        enum Type { JOINT, POSE, CARTESIAN };
+
+        moveit::planning_interface::MoveGroupInterface* group;
+        Type type;
+        // goal joint values computed from the joint values the segment starts from
+        std::function<std::vector<double>(std::vector<double>)> joints;
+        geometry_msgs::Pose pose;
+        std::vector<geometry_msgs::Pose> waypoints;
+        MotionProfile profile;
+        // run once the segment is executed, before the next one starts (gripper, ...)
+        std::function<void()> after;
+
+        static MotionSegment joint(moveit::planning_interface::MoveGroupInterface& group,
+            const std::vector<double>& goal, const MotionProfile& profile = MotionProfile());
+        /**
+         * @brief Joint goal derived from the start of the segment, e.g. only move the rail
+         */
+        static MotionSegment jointFromStart(moveit::planning_interface::MoveGroupInterface& group,
+            std::function<std::vector<double>(std::vector<double>)> goal, const MotionProfile& profile = MotionProfile());
+        static MotionSegment poseTarget(moveit::planning_interface::MoveGroupInterface& group,
+            const geometry_msgs::Pose& pose, const MotionProfile& profile = MotionProfile());
+        static MotionSegment cartesian(moveit::planning_interface::MoveGroupInterface& group,
+            const std::vector<geometry_msgs::Pose>& waypoints, const MotionProfile& profile = MotionProfile());
+    };
+
+    /**
+     * @brief Runs a chain of motions, planning segment N+1 while segment N executes
+     *
+     * Segment N+1 is planned from the state at the end of the trajectory of
+     * segment N. At the handover the robot must be within
+     * @p handover_tolerance of that state, otherwise the segment is planned
+     * again from where the robot actually is. Segments may use different
+     * groups of the same robot.
+     */
+    class MotionPipeline {
+        public:
+        /**
+         * @param joint_states States the segments are checked and replanned against, MoveIt is asked when null or stale
+         * @param cache Cache consulted and filled for joint segments, may be null
+         * @param handover_tolerance Largest joint difference to the planned start
+         */
+        explicit MotionPipeline(const JointStateCache* joint_states = nullptr, TrajectoryCache* cache = nullptr,
+            double handover_tolerance = 0.01);
+
+        MotionPipeline& add(const MotionSegment& segment);
+        /**
+         * @brief Plan and execute every segment added so far
+         *
+         * @return false A segment could not be planned or executed, the rest is dropped
+         */
+        bool run();
+
+        private:
+        struct Step {
+            moveit::planning_interface::MoveGroupInterface::Plan plan;
+            moveit::core::RobotStatePtr start_state;
+            std::vector<double> start;   // group joint values at start_state, for the cache
+            std::vector<double> goal;
+            bool planned{ false };
+        };
+        bool plan_step(const MotionSegment& segment, const moveit::core::RobotState& start, Step& step);
+        bool starts_at(const Step& step, const moveit::core::RobotState& state) const;
+        moveit::core::RobotState end_state(const Step& step) const;
+
+        const JointStateCache* joint_states_;
+        TrajectoryCache* cache_;
+        double handover_tolerance_;
+        std::vector<MotionSegment> segments_;
+    };
+}//namespace
+
+#endif
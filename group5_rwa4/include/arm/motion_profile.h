@@ -0,0 +1,66 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <map>
+#include <string>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Velocity and acceleration scaling of a motion, fractions of the joint limits
+     */
+    struct MotionProfile {
+        double velocity{ 1.0 };
+        double acceleration{ 1.0 };
+
+        void apply(moveit::planning_interface::MoveGroupInterface& group) const
+        {
+            group.setMaxVelocityScalingFactor(velocity);
+            group.setMaxAccelerationScalingFactor(acceleration);
+        }
+    };
+
+    /**
+     * @brief What the robot is doing during a motion
+     */
+    enum class MotionPhase {
+        EMPTY_TRANSIT,   // moving without a part
+        LOADED_TRANSIT,  // moving with a part in the gripper
+        APPROACH,        // down to the pose above a part
+        CONTACT,         // guarded descent onto a part
+        PLACE,           // down to where a held part is released
+        FLIP             // turning a held part over
+    };
+
+    /**
+     * @brief Scaling per motion phase, with overrides per part type
+     *
+     * Loaded from a YAML file (config/motion_profiles.yaml). A part type
+     * matches an override when it contains its key, e.g. "pump" for
+     * "assembly_pump_red". Every profile handed out is logged on the
+     * motion_profile rosconsole logger and recorded in the trace, so runs
+     * can be compared for throughput against dropped parts.
+     */
+    class MotionProfiles {
+        public:
+        MotionProfiles();
+
+        /**
+         * @return false The file could not be read, the built-in profiles are kept
+         */
+        bool load(const std::string& path);
+        /**
+         * @brief Profile of the next motion in @p phase, carrying @p part_type when loaded
+         */
+        MotionProfile select(MotionPhase phase, const std::string& part_type = "") const;
+
+        static const char* name(MotionPhase phase);
+
+        private:
+        std::map<MotionPhase, MotionProfile> phases_;
+        // part type key -> phases it overrides
+        std::map<std::string, std::map<MotionPhase, MotionProfile> > parts_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef PLANNING_SCENE_MANAGER_H
+#define PLANNING_SCENE_MANAGER_H
+#include <ros/ros.h>
+#include <moveit/planning_scene_interface/planning_scene_interface.h>
+#include <moveit_msgs/CollisionObject.h>
+#include <tf2_ros/transform_listener.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../util/util.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Collision objects of the workcell in the planning scene of one robot
+     *
+     * The static geometry (bins, conveyor) is inserted once by init(). AGV
+     * trays and briefcases follow their tf frames and the parts seen by the
+     * cameras are matched with the ones already in the scene, so update()
+     * only sends what moved, appeared or disappeared. The held part is
+     * attached to the end effector so plans account for it.
+     *
+     * The geometry comes from a YAML file, see config/planning_scene.yaml.
+     */
+    class PlanningSceneManager {
+        public:
+        /**
+         * @param ns Namespace of the move group, e.g. "/ariac/kitting"
+         * @param path YAML geometry file
+         * @return false The file could not be read, the scene stays empty
+         */
+        bool init(const std::string& ns, const std::string& path);
+        /**
+         * @brief Bring the trays, briefcases and parts up to date
+         *
+         * @param parts Parts seen by the cameras, in world. Parts on the belt are left out.
+         * @return true Something moved where the robots travel: a tray, a briefcase or a part
+         * outside the bins. Parts in the bins stay below the rims the routes pass over.
+         */
+        bool update(const std::vector<Product>& parts);
+        /**
+         * @brief Take the part about to be picked out of the scene, so the gripper can reach it
+         *
+         * @param part_type Type of the part, empty for any type
+         * @param pose Pose of the part in world, only x and y are compared
+         */
+        void clearPart(const std::string& part_type, const geometry_msgs::Pose& pose);
+        /**
+         * @brief Attach a box for the held part right under the end effector
+         *
+         * @param link End effector link
+         * @param link_pose Pose of @p link in world, wrist down
+         */
+        bool attach(const std::string& link, const std::string& part_type, const geometry_msgs::Pose& link_pose);
+        /**
+         * @brief Remove the held part, the cameras report where it landed
+         */
+        bool detach();
+
+        private:
+        struct SceneObject {
+            std::string type;
+            geometry_msgs::Pose pose;
+        };
+        struct FramedBox {
+            std::string frame;
+            std::vector<double> size;
+            std::vector<double> offset;
+            bool inserted;
+            geometry_msgs::Pose pose;
+        };
+
+        std::vector<double> partSize(const std::string& part_type) const;
+        bool inBin(const geometry_msgs::Pose& pose) const;
+        moveit_msgs::CollisionObject box(const std::string& id, const std::vector<double>& size,
+            const geometry_msgs::Pose& pose) const;
+        void updateFrames(std::vector<moveit_msgs::CollisionObject>& changes);
+        bool apply(const std::vector<moveit_msgs::CollisionObject>& changes);
+
+        std::unique_ptr<moveit::planning_interface::PlanningSceneInterface> scene_;
+        std::map<std::string, FramedBox> frames_;
+        std::map<std::string, std::vector<double> > part_sizes_;
+        // bin centers and the bin footprint, in world
+        std::vector<geometry_msgs::Pose> bins_;
+        std::vector<double> bin_size_;
+        // parts in the scene by object id
+        std::map<std::string, SceneObject> parts_;
+        unsigned int next_part_{ 0 };
+        std::string held_id_;
+        std::string held_link_;
+        std::unique_ptr<tf2_ros::Buffer> tf_buffer_;
+        std::unique_ptr<tf2_ros::TransformListener> tf_listener_;
+    };
+}//namespace
+
+#endif
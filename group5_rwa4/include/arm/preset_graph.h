@@ -0,0 +1,77 @@
+#ifndef PRESET_GRAPH_H
+#define PRESET_GRAPH_H
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Named gantry presets and the collision-free moves between them
+     *
+     * Loaded from a YAML file (config/gantry_presets.yaml). Edges carry a
+     * traversal time, given in the file or estimated from the joint
+     * distances, and replaced by measured durations as moves are recorded.
+     * route() returns the fastest sequence of presets between two of them.
+     */
+    class PresetGraph {
+        public:
+        struct Preset {
+            std::vector<double> torso;  // small_long_joint, torso_rail_joint, torso_base_main_joint
+            std::vector<double> arm;    // 6 arm joints
+
+            // joints of the full gantry, torso then arm
+            std::vector<double> full() const
+            {
+                std::vector<double> joints(torso);
+                joints.insert(joints.end(), arm.begin(), arm.end());
+                return joints;
+            }
+        };
+
+        /**
+         * @return false The file could not be read, the graph is left empty
+         */
+        bool load(const std::string& path);
+        bool empty() const { return presets_.empty(); }
+        bool has(const std::string& name) const { return presets_.count(name) > 0; }
+        const Preset& preset(const std::string& name) const { return presets_.at(name); }
+        /**
+         * @brief Preset closest to @p joints (torso then arm), by largest joint difference
+         *
+         * @param distance Filled with that difference
+         */
+        std::string nearest(const std::vector<double>& joints, double& distance) const;
+        /**
+         * @brief Fastest sequence of presets from @p from to @p to
+         *
+         * @param path Filled with the presets after @p from, ending with @p to
+         * @return false @p to cannot be reached from @p from
+         */
+        bool route(const std::string& from, const std::string& to, std::vector<std::string>& path) const;
+        /**
+         * @brief Time of a move measured while running, replaces the estimate of the edge
+         */
+        void record(const std::string& from, const std::string& to, double seconds);
+        double time(const std::string& from, const std::string& to) const;
+
+        private:
+        typedef std::pair<std::string, std::string> Edge;
+        double estimate(const Preset& a, const Preset& b) const;
+        void add_edge(const std::string& a, const std::string& b, double seconds);
+
+        double linear_speed_{ 0.8 };
+        double angular_speed_{ 1.2 };
+        double settle_{ 0.5 };
+        std::map<std::string, Preset> presets_;
+        std::map<std::string, std::vector<std::string> > neighbours_;
+        // both directions, guarded as record() runs on the motion thread
+        std::map<Edge, double> times_;
+        std::map<Edge, bool> measured_;
+        mutable std::mutex mutex_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef ROBOT_MODELS_H
+#define ROBOT_MODELS_H
+#include <ros/ros.h>
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <moveit/robot_model/robot_model.h>
+#include <string>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Robot model of @p description, loaded once and shared
+     *
+     * MoveIt loads the model of a MoveGroupInterface built without one under
+     * a single lock for all descriptions, so the kitting arm and the gantry
+     * would load theirs one after the other. Here each description is loaded
+     * on the first call for it, callers asking for another description do not
+     * wait, callers asking for the same one wait for that load.
+     *
+     * @param description Robot description parameter, e.g. /ariac/gantry/robot_description
+     * @return moveit::core::RobotModelConstPtr null if the description could not be loaded
+     * @throw std::exception What the load threw, rethrown to every caller of the description
+     */
+    moveit::core::RobotModelConstPtr sharedRobotModel(const std::string& description);
+
+    /**
+     * @brief Options of the move group @p group carrying the shared model of @p description
+     */
+    moveit::planning_interface::MoveGroupInterface::Options groupOptions(const std::string& group,
+        const std::string& description, const ros::NodeHandle& node);
+}//namespace
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SWEEP_CHECKER_H
+#define SWEEP_CHECKER_H
+#include <ros/ros.h>
+#include <trajectory_msgs/JointTrajectory.h>
+#include <string>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Collision check of a streamed trajectory through the move group
+     *
+     * Trajectories sent straight to the controllers skip the planner, so
+     * nothing checks them against the workcell. This samples a trajectory,
+     * at most @p step apart in every joint, and asks move_group whether each
+     * sample is valid in its planning scene, held part included.
+     */
+    class SweepChecker {
+        public:
+        /**
+         * @param node Node handle in the namespace of the move group
+         * @param group Group the trajectory joints belong to
+         * @param step Largest joint motion between two checked samples (rad or m)
+         */
+        void init(const ros::NodeHandle& node, const std::string& group, double step = 0.1);
+        /**
+         * @brief Check the points of @p trajectory
+         *
+         * @return false A sample is in collision or the service did not answer
+         */
+        bool check(const trajectory_msgs::JointTrajectory& trajectory);
+
+        private:
+        ros::NodeHandle node_;
+        ros::ServiceClient client_;
+        std::string group_;
+        double step_{ 0.1 };
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef TRAJECTORY_CACHE_H
+#define TRAJECTORY_CACHE_H
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <moveit_msgs/RobotTrajectory.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "joint_state_cache.h"
+#include "motion_profile.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Planned preset motions, reused while the robot starts where they start
+     *
+     * Entries are keyed on the start joint values rounded to @p bucket, the
+     * goal joint values, the motion profile and the held part, as the
+     * collision checks of a plan depend on what hangs under the gripper.
+     * The owner clears the cache when the scene changes along the routes.
+     * A stored trajectory is only
+     * handed back when every joint of the current state is within
+     * @p tolerance of the state it was planned from, otherwise the caller
+     * plans again and overwrites the entry.
+     */
+    class TrajectoryCache {
+        public:
+        /**
+         * @param tolerance Largest joint difference (rad or m) to the cached start
+         * @param bucket Rounding of the start joint values in the key
+         */
+        explicit TrajectoryCache(double tolerance = 0.01, double bucket = 0.05);
+
+        /**
+         * @brief Look up a trajectory from @p start to @p goal
+         *
+         * @return true @p trajectory was filled from the cache
+         */
+        bool find(const std::vector<double>& start, const std::vector<double>& goal, const MotionProfile& profile,
+            moveit_msgs::RobotTrajectory& trajectory);
+        /**
+         * @brief Keep a trajectory that was planned and executed from @p start
+         */
+        void store(const std::vector<double>& start, const std::vector<double>& goal, const MotionProfile& profile,
+            const moveit_msgs::RobotTrajectory& trajectory);
+        /**
+         * @brief Drop the entry for this motion, e.g. after its execution failed
+         */
+        void erase(const std::vector<double>& start, const std::vector<double>& goal, const MotionProfile& profile);
+
+        /**
+         * @brief Move @p group to the joint values @p goal, from the cache when possible
+         *
+         * A cached trajectory that fails to execute is dropped and the motion
+         * is planned again from where the robot stopped.
+         *
+         * @param group Planning group to move
+         * @param goal Joint values of the target, in the group order
+         * @param profile Scaling applied to the group, part of the key
+         * @param joint_states Start of the motion, MoveIt is asked when null or stale
+         * @return true The robot reached @p goal
+         */
+        bool moveTo(moveit::planning_interface::MoveGroupInterface& group, const std::vector<double>& goal, const MotionProfile& profile,
+            const JointStateCache* joint_states = nullptr);
+        /**
+         * @brief Key the next lookups on the part now held, empty when the gripper is empty
+         */
+        void hold(const std::string& part_type) { held_ = part_type; }
+        /**
+         * @brief Drop every entry, the trajectories were checked against an older scene
+         */
+        void clear() { entries_.clear(); }
+
+        std::size_t hits() const { return hits_; }
+        std::size_t misses() const { return misses_; }
+
+        private:
+        struct Entry {
+            std::vector<double> start;
+            moveit_msgs::RobotTrajectory trajectory;
+        };
+        std::string make_key(const std::vector<double>& start, const std::vector<double>& goal, const MotionProfile& profile) const;
+
+        double tolerance_;
+        double bucket_;
+        std::string held_;
+        std::map<std::string, Entry> entries_;
+        std::size_t hits_{ 0 };
+        std::size_t misses_{ 0 };
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef TRAY_LOCKS_H
+#define TRAY_LOCKS_H
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "../trace/trace.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief One lock per kit tray or assembly station, shared by both robots
+     *
+     * The motions of one robot are not checked against the other robot. A
+     * flip may end on a worker thread while the main sequence loads the
+     * same tray with the other robot, so a robot holds the lock of a tray
+     * from the moment it heads over it until it is clear of it again.
+     */
+    class TrayLocks {
+        public:
+        /**
+         * @brief Wait until no other robot works over @p site and take it
+         *
+         * @param site agv1..agv4 or as1..as4
+         */
+        std::unique_lock<std::mutex> lock(const std::string& site)
+        {
+            std::mutex* site_mutex;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto& entry = sites_[site];
+                if (!entry)
+                    entry.reset(new std::mutex);
+                site_mutex = entry.get();
+            }
+            tracing::Span span("wait", "tray");
+            span.arg("site", site);
+            return std::unique_lock<std::mutex>(*site_mutex);
+        }
+
+        private:
+        std::mutex mutex_;
+        // entries are never removed, the pointers handed out stay valid
+        std::map<std::string, std::unique_ptr<std::mutex> > sites_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CONVEYOR_TRACKER_H
+#define CONVEYOR_TRACKER_H
+#include <ros/ros.h>
+#include <nist_gear/LogicalCameraImage.h>
+#include <geometry_msgs/Pose.h>
+#include <Eigen/Geometry>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace motioncontrol {
+
+    /**
+     * @brief A part riding the conveyor, with its velocity
+     */
+    struct ConveyorTrack {
+        unsigned int id{ 0 };
+        std::string type;
+        geometry_msgs::Pose pose;             // in world, at stamp
+        Eigen::Vector3d velocity{ 0, 0, 0 };  // in world (m/s)
+        ros::Time stamp;
+        int sightings{ 0 };
+
+        /**
+         * @brief Pose of the part at @p time, assuming the belt keeps its speed
+         */
+        geometry_msgs::Pose predict(const ros::Time& time) const;
+    };
+
+    /**
+     * @brief Tracks of the parts seen by the belt logical camera
+     *
+     * Every camera message is matched against the predicted positions of
+     * the known tracks, a detection close to a prediction of the same type
+     * updates that track and its velocity estimate, anything else starts a
+     * new track. Tracks keep being predicted once they leave the camera, as
+     * the belt does not stop, and are dropped after max_age or when removed
+     * by the robot that picked them.
+     *
+     * The camera message carries the camera pose, so detections are put in
+     * world without TF lookups.
+     */
+    class ConveyorTracker {
+        public:
+        /**
+         * @param topic Logical camera looking at the belt
+         * @param max_age Tracks not seen for this long are dropped (s)
+         */
+        void init(ros::NodeHandle& node, const std::string& topic = "/ariac/logical_camera_belt", double max_age = 30.0);
+        /**
+         * @brief Tracks seen at least twice, so with a velocity
+         */
+        std::vector<ConveyorTrack> tracks() const;
+        /**
+         * @brief Wait for the next camera message that changed the tracks
+         *
+         * @return false Nothing changed before @p deadline
+         */
+        bool waitForUpdate(const ros::Time& deadline) const;
+        /**
+         * @brief Forget a track, once its part is picked or out of reach
+         */
+        void remove(unsigned int id);
+
+        private:
+        void callback(const nist_gear::LogicalCameraImage::ConstPtr& msg);
+
+        mutable std::mutex mutex_;
+        mutable std::condition_variable changed_;
+        std::vector<ConveyorTrack> tracks_;
+        unsigned int next_id_{ 0 };
+        unsigned long updates_{ 0 };
+        double max_age_{ 30.0 };
+        ros::Subscriber subscriber_;
+    };
+}//namespace
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef LOGICAL_CAMERA_H
 #define LOGICAL_CAMERA_H
 #include "../util/util.h"
+#include <ros/topic.h>
 
 class LogicalCamera
 {
@@ -140,6 +141,18 @@ class LogicalCamera
 
     std::array<std::vector<Product>,8> get_bin_list();
 
+    /**
+     * @brief Take one snapshot of an assembly station camera
+     *
+     * Only the model types and poses in the camera frame are filled in,
+     * no TF lookups are made so this is cheap enough to call before every submission.
+     *
+     * @param station Assembly station, as1..as4
+     * @param timeout Maximum time to wait for a camera message
+     * @return std::vector<Product> Parts seen at the station, empty on timeout
+     */
+    std::vector<Product> get_station_parts(std::string station, ros::Duration timeout);
+
     std::vector<int> get_ebin_list();
 
     private:
@@ -0,0 +1,107 @@
+#ifndef FLIP_SCHEDULER_H
+#define FLIP_SCHEDULER_H
+#include "../arm/arm.h"
+#include "../util/worker_threads.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Ways of turning a pump over before it goes on a tray
+     */
+    enum class FlipStrategy {
+        ARM_REGRASP,     // the kitting arm turns it over in a bin it reaches
+        GANTRY_REGRASP,  // the gantry turns it over in a bin and places it itself
+        HANDOVER         // the gantry moves it to a bin the arm reaches, the arm turns it over
+    };
+
+    const char* toString(FlipStrategy strategy);
+
+    /**
+     * @brief Chooses a flip strategy per pump and runs it beside the rest of the kit
+     *
+     * A strategy is a sequence of robot stages. The one chosen ends first:
+     * a robot is free when the flip stages already given to it are expected
+     * to be over, and each stage lasts as long as it took on the previous
+     * flips (a default until one was measured). Work the caller gives the
+     * robots directly is not counted.
+     *
+     * The flip runs on a worker thread. The caller goes on with the other
+     * robot and calls waitFor() before using a robot itself. In a handover
+     * the gantry is released as soon as the part is in the arm's bin. A
+     * stage that fails or throws ends the flip, the stages after it are not
+     * run and the flip reports the part as not placed.
+     */
+    class FlipScheduler {
+        public:
+        FlipScheduler(Arm& arm, gantry_motioncontrol::Gantry& gantry);
+        /**
+         * @brief Waits for the flips still running
+         */
+        ~FlipScheduler();
+
+        /**
+         * @brief Strategy that would have @p part on its tray first
+         *
+         * @param part Pump to flip, in a bin
+         */
+        FlipStrategy choose(const Product& part) const;
+        /**
+         * @brief Flip @p part and place it on @p agv without blocking the caller
+         *
+         * @param part Pump to flip, in a bin
+         * @param target_in_frame Pose of the part in the tray frame
+         * @param agv agv1..agv4
+         * @param empty_bins Bins free at the start of the order
+         * @return std::shared_future<bool> true once @p part is on @p agv, false if the flip failed
+         */
+        std::shared_future<bool> start(const Product& part, const geometry_msgs::Pose& target_in_frame, const std::string& agv,
+            const std::vector<int>& empty_bins);
+        /**
+         * @brief Block until @p robot ("kitting_arm" or "gantry") has no flip stage left
+         */
+        void waitFor(const std::string& robot);
+        /**
+         * @brief @p robot has no flip stage given to it and not over
+         */
+        bool idle(const std::string& robot) const;
+        /**
+         * @brief Block until every flip is over
+         */
+        void waitAll();
+
+        private:
+        struct Stage {
+            std::string robot;
+            const char* name;
+            std::function<bool()> run;
+        };
+
+        void run(const std::vector<Stage>& stages, std::promise<bool>& placed);
+        double estimate(const char* stage) const;
+        ros::Time readyAt(const std::string& robot, const ros::Time& now) const;
+
+        Arm& arm_;
+        gantry_motioncontrol::Gantry& gantry_;
+        // stage -> duration (s), defaults replaced by measured ones
+        std::map<std::string, double> durations_;
+        std::map<std::string, bool> measured_;
+        // robot -> stages given and not over, expected end of the last one
+        std::map<std::string, int> pending_;
+        std::map<std::string, ros::Time> free_at_;
+        // robot -> a stage is running on it
+        std::map<std::string, bool> running_;
+        WorkerThreads workers_;
+        mutable std::mutex mutex_;
+        std::condition_variable changed_;
+    };
+}//namespace
+
+#endif
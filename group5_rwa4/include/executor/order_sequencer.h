@@ -0,0 +1,430 @@
+#ifndef ORDER_SEQUENCER_H
+#define ORDER_SEQUENCER_H
+#include <ros/ros.h>
+#include <geometry_msgs/Pose.h>
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+#include "preemption.h"
+#include "../planner/feasibility.h"
+#include "../planner/spare_parts.h"
+#include "../trace/trace.h"
+#include "../util/util.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Policies of an OrderSequencer, all on for the competition
+     */
+    struct SequencerOptions {
+        bool spares{ true };    // swap a faulty part for a reserved spare
+        bool partial{ true };   // ship a kit with the products the inventory cannot supply left out
+    };
+
+    /**
+     * @brief Kitting and assembly sequence of an order, for any workcell
+     *
+     * The node runs it on the robots and the workcell simulator on its
+     * models, so a scheduling change made here is what the simulator scores.
+     * @p Cell is a small adapter held by reference, giving the workcell's
+     * moves and sensors:
+     *
+     *   std::vector<Order> orders()                          orders announced so far
+     *   PartMap& parts()                                     camera map the kits are built from
+     *   bool placeWithArm(const Product& part, const Product& product, const std::string& agv)
+     *   bool placeWithGantry(const Product& part, const Product& product, const std::string& agv)
+     *   std::shared_future<bool> startFlip(const Product& part, const Product& product, const std::string& agv)
+     *   void waitFor(const std::string& robot)               flips given to "kitting_arm" or "gantry" are over
+     *   bool idle(const std::string& robot)                  no flip given to @p robot and not over
+     *   void waitAll()                                       every flip is over
+     *   void prepositionArm(const geometry_msgs::Pose& pick) rail towards the next pick, beside other work
+     *   bool blackout()                                      quality control sensors down
+     *   std::vector<Product> faultyParts()                   quality control report, once it is ready
+     *   geometry_msgs::Pose slot(const Product& product, const std::string& agv)   world pose of the product's slot
+     *   bool replaceFaulty(const Product& product, const geometry_msgs::Pose& faulty,
+     *       const geometry_msgs::Pose& spare, const std::string& agv)
+     *   void discardFaulty(const Product& product, const geometry_msgs::Pose& faulty)
+     *   void ship(const Kitting& kit)
+     *   bool waitForDeliveries(const std::string& station)   AGVs shipped to @p station are there, false if one is not
+     *   PartMap scan()                                       fresh camera map, once the AGVs moved
+     *   bool placeInBriefcase(const Product& part, const Product& product, const std::string& station)
+     *   std::vector<std::string> checkBriefcase(const Assembly& assembly)   product types the station camera does not see
+     *   void submit(const Assembly& assembly)
+     *
+     * The robot taking a part follows its bin: the kitting arm reaches bins
+     * 1, 2, 5 and 6, the gantry the others. A pump to turn over is handed to
+     * the cell's flips and the kit goes on with the other parts; it is only
+     * counted once the flip reports it on the tray and it passed its check.
+     * Each part is checked at its own slot before the next checkpoint.
+     */
+    template <typename Cell>
+    class OrderSequencer {
+        public:
+        OrderSequencer(Cell& cell, PreemptionManager& preemption, SequencerOptions options = SequencerOptions())
+            : cell_(cell), preemption_(preemption), options_(options)
+        {
+        }
+
+        /**
+         * @brief Set a spare aside per part type the announced orders need
+         */
+        void reserveSpares()
+        {
+            if (options_.spares)
+                spares_.reserve(cell_.orders(), cell_.parts());
+        }
+        /**
+         * @brief Feasibility of the shipments not shipped yet
+         */
+        FeasibilityPlan analyse() const
+        {
+            return feasibility_.analyse(cell_.orders(), cell_.parts());
+        }
+        /**
+         * @brief Build and ship the kits of @p order, then its assemblies
+         */
+        void processOrder(const Order& order)
+        {
+            for (auto& kit : order.kitting)
+                buildKit(kit);
+            assemble(order.assembly);
+        }
+        /**
+         * @brief Place the parts of @p kit on its AGV, check them and ship it
+         */
+        void buildKit(const Kitting& kit)
+        {
+            tracing::Span span("sequencer", "kit");
+            span.arg("shipment", kit.shipment_type);
+            ROS_INFO_STREAM("[OrderSequencer][buildKit] " << kit.shipment_type << " on " << kit.agv_id);
+            std::vector<Product> products = kit.products;
+            for (auto& product : products)
+                product.processed = false;
+
+            // Checkpoint: nothing of this kit is placed yet
+            preemption_.checkpoint(makeContext("kitting_arm", kit.shipment_type, kit.agv_id, products));
+
+            // products the inventory cannot supply are left out up front
+            auto plan = analyse();
+            shortfall_ = plan.shortfall;
+            auto kit_plan = plan.find(kit.shipment_type);
+            if (kit_plan != nullptr) {
+                if (!kit_plan->ship || (kit_plan->partial && !options_.partial)) {
+                    ROS_WARN_STREAM("[OrderSequencer][buildKit] " << kit.shipment_type << " cannot be built, skipping it");
+                    feasibility_.markShipped(kit.shipment_type);
+                    return;
+                }
+                for (std::size_t k{ 0 }; k < products.size(); k++) {
+                    if (!kit_plan->available.at(k)) {
+                        ROS_WARN_STREAM("[OrderSequencer][buildKit] Not enough " << products.at(k).type
+                            << ", shipping " << kit.shipment_type << " without it");
+                        products.at(k).processed = true;
+                    }
+                }
+            }
+
+            while (true) {
+                std::vector<Pending> flips;
+                std::vector<Product*> unchecked;
+                for (auto& product : products) {
+                    if (product.processed)
+                        continue;
+                    if (!placeProduct(product, kit, products, flips, unchecked)) {
+                        ROS_WARN_STREAM("[OrderSequencer][buildKit] No " << product.type << " left, shipping "
+                            << kit.shipment_type << " without it");
+                        product.processed = true;
+                    }
+                    else
+                        replan(kit, products);
+                }
+
+                // the last flips of the kit end before the tray is checked and shipped
+                cell_.waitAll();
+                for (auto& flip : flips) {
+                    if (!flip.placed.get()) {
+                        ROS_WARN_STREAM("[OrderSequencer][buildKit] Flip of " << flip.product->type << " failed, taking another one");
+                        flip.product->processed = false;
+                    }
+                    else
+                        unchecked.push_back(flip.product);
+                }
+                // flipped parts and parts placed during a sensor blackout
+                for (auto product : unchecked) {
+                    if (!inspect(*product, kit.agv_id))
+                        product->processed = false;
+                }
+
+                bool done{ true };
+                for (auto& product : products)
+                    done = done && product.processed;
+                if (done)
+                    break;
+            }
+
+            cell_.ship(kit);
+            feasibility_.markShipped(kit.shipment_type);
+            ROS_INFO_STREAM("[OrderSequencer][buildKit] " << kit.shipment_type << " shipped on " << kit.agv_id);
+        }
+        /**
+         * @brief Put the parts brought by the AGVs into the briefcases of @p assemblies and submit them
+         *
+         * Before a submission the briefcase is checked with the station
+         * camera, a part it does not see is placed again once.
+         */
+        void assemble(const std::vector<Assembly>& assemblies)
+        {
+            if (assemblies.empty())
+                return;
+            // Checkpoint: serve a pending high-priority order instead of waiting for the AGVs
+            preemption_.checkpoint(makeContext("gantry", "", "", {}));
+            for (auto& assembly : assemblies) {
+                if (!cell_.waitForDeliveries(assembly.stations))
+                    ROS_ERROR_STREAM("[OrderSequencer][assemble] A kit for " << assembly.stations
+                        << " did not arrive, assembling " << assembly.shipment_type << " from what is there");
+            }
+            auto station_parts = cell_.scan();
+
+            for (auto& assembly : assemblies) {
+                tracing::Span span("sequencer", "assembly");
+                span.arg("shipment", assembly.shipment_type);
+                ROS_INFO_STREAM("[OrderSequencer][assemble] " << assembly.shipment_type << " at " << assembly.stations);
+                std::vector<Product> products = assembly.products;
+                for (auto& product : products) {
+                    product.processed = false;
+                    placeInBriefcase(product, station_parts, assembly, products);
+                }
+
+                // a part dropped on the way is not in the briefcase, another one of its type goes in
+                for (auto& type : cell_.checkBriefcase(assembly)) {
+                    auto product = std::find_if(products.begin(), products.end(),
+                        [&type](const Product& product) { return product.type == type && product.processed; });
+                    if (product == products.end())
+                        continue;
+                    ROS_WARN_STREAM("[OrderSequencer][assemble] " << type << " is not in the briefcase at "
+                        << assembly.stations << ", placing another one");
+                    product->processed = false;
+                    placeInBriefcase(*product, station_parts, assembly, products);
+                }
+                cell_.submit(assembly);
+            }
+        }
+
+        private:
+        // a flip handed to the cell, for the product it places
+        struct Pending {
+            Product* product;
+            std::shared_future<bool> placed;
+        };
+
+        static bool armBin(int bin)
+        {
+            return bin == 1 || bin == 2 || bin == 5 || bin == 6;
+        }
+        static bool upsideDown(const geometry_msgs::Pose& pose)
+        {
+            auto& q = pose.orientation;
+            double roll = std::atan2(2.0 * (q.w * q.x + q.y * q.z), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+            return std::abs(std::abs(roll) - M_PI) < 0.5;
+        }
+        /**
+         * @brief Index of the faulty part reported on @p agv at @p slot, -1 if none
+         */
+        static int findFaulty(const std::vector<Product>& faulty_parts, const std::string& agv, const geometry_msgs::Pose& slot)
+        {
+            for (std::size_t i{ 0 }; i < faulty_parts.size(); i++) {
+                auto& position = faulty_parts.at(i).world_pose.position;
+                if (faulty_parts.at(i).faulty_cam_agv.compare(agv) == 0 && std::abs(position.x - slot.position.x) < 0.1
+                    && std::abs(position.y - slot.position.y) < 0.1)
+                    return static_cast<int>(i);
+            }
+            return -1;
+        }
+
+        /**
+         * @brief Place one part of the type of @p product, check it and yield at the checkpoint
+         *
+         * A part that does not reach the tray or fails its check makes way for
+         * the next free part of the type.
+         *
+         * @return false No free part of the type is left in the bins
+         */
+        bool placeProduct(Product& product, const Kitting& kit, const std::vector<Product>& products,
+            std::vector<Pending>& flips, std::vector<Product*>& unchecked)
+        {
+            auto found = cell_.parts().find(product.type);
+            for (std::size_t i{ 0 }; found != cell_.parts().end() && i < found->second.size(); i++) {
+                auto& part = found->second.at(i);
+                if (part.status.compare("free") != 0 || part.camera.rfind("logical_camera_bins", 0) != 0)
+                    continue;
+                part.status = "processed";
+                std::string robot = armBin(part.bin_number) ? "kitting_arm" : "gantry";
+
+                if (product.type.find("pump") != std::string::npos && upsideDown(product.frame_pose)
+                    && !upsideDown(part.world_pose)) {
+                    // not on the tray yet: left out of this pass, checked at its own slot once the flip is over
+                    flips.push_back(Pending{ &product, cell_.startFlip(part, product, kit.agv_id) });
+                    product.processed = true;
+                }
+                else {
+                    cell_.waitFor(robot);
+                    if (robot == "gantry") {
+                        // the arm has nothing to do while the gantry works, it heads for its next pick
+                        prepositionArm(products, &product);
+                    }
+                    bool placed = robot == "kitting_arm" ? cell_.placeWithArm(part, product, kit.agv_id)
+                                                         : cell_.placeWithGantry(part, product, kit.agv_id);
+                    if (!placed)
+                        continue;
+                    if (cell_.blackout()) {
+                        // checked once the flips of the pass are over, the sensors may be back
+                        unchecked.push_back(&product);
+                    }
+                    else {
+                        // rail travel to the next pick overlaps the quality control delay, a faulty part stops it
+                        prepositionArm(products, &product);
+                        if (!inspect(product, kit.agv_id))
+                            continue;
+                    }
+                    product.processed = true;
+                }
+
+                // Checkpoint: the part is placed and checked, yield to a pending high-priority order
+                preemption_.checkpoint(makeContext(robot, kit.shipment_type, kit.agv_id, products));
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Rerun the allocation with the products of @p kit placed so far
+         *
+         * Run after every part taken from the bins, on the thread that owns
+         * the camera map, so a part used up or an order announced meanwhile
+         * shows before the next pick rather than at the next kit. A product
+         * of @p kit whose part now goes to a shipment of a higher priority
+         * order is left out, as it would have been at the start of the kit.
+         */
+        void replan(const Kitting& kit, std::vector<Product>& products)
+        {
+            auto orders = cell_.orders();
+            for (auto& order : orders) {
+                for (auto& other : order.kitting) {
+                    if (other.shipment_type == kit.shipment_type)
+                        other.products = products;
+                }
+            }
+            auto plan = feasibility_.analyse(orders, cell_.parts());
+            if (plan.shortfall != shortfall_) {
+                for (auto& shortfall : plan.shortfall)
+                    ROS_WARN_STREAM("[OrderSequencer][replan] missing " << shortfall.second << " x " << shortfall.first);
+                shortfall_ = plan.shortfall;
+            }
+            auto kit_plan = plan.find(kit.shipment_type);
+            for (std::size_t k{ 0 }; kit_plan != nullptr && k < products.size(); k++) {
+                if (!products.at(k).processed && !kit_plan->available.at(k)) {
+                    ROS_WARN_STREAM("[OrderSequencer][replan] " << products.at(k).type << " goes to a higher priority shipment, shipping "
+                        << kit.shipment_type << " without it");
+                    products.at(k).processed = true;
+                }
+            }
+        }
+
+        /**
+         * @brief Put a part of the type of @p product from an AGV at the station into the briefcase
+         *
+         * @param station_parts Camera map of the stations, the part taken is marked in it
+         * @return false No part of the type made it into the briefcase
+         */
+        bool placeInBriefcase(Product& product, PartMap& station_parts, const Assembly& assembly,
+            const std::vector<Product>& products)
+        {
+            auto found = station_parts.find(product.type);
+            for (std::size_t i{ 0 }; found != station_parts.end() && i < found->second.size(); i++) {
+                auto& part = found->second.at(i);
+                // on an AGV parked at the station, not already in a briefcase
+                if (part.status.compare("free") != 0 || part.camera.find(assembly.stations) == std::string::npos
+                    || part.camera.find("station") != std::string::npos)
+                    continue;
+                part.status = "processed";
+                if (!cell_.placeInBriefcase(part, product, assembly.stations))
+                    continue;
+                product.processed = true;
+                // Checkpoint: the part is in the briefcase
+                preemption_.checkpoint(makeContext("gantry", assembly.shipment_type, assembly.stations, products));
+                return true;
+            }
+            ROS_WARN_STREAM("[OrderSequencer][assemble] No " << product.type << " at " << assembly.stations);
+            return false;
+        }
+
+        /**
+         * @brief Quality control of @p product once it is on @p agv
+         *
+         * Only the part at its own slot is looked at, so a part placed meanwhile
+         * by the other robot is left to its own check. A faulty part is swapped
+         * for a reserved spare of its type while there is one, otherwise it is
+         * taken off the tray.
+         *
+         * @return false The slot is empty again, another part of the type is needed
+         */
+        bool inspect(const Product& product, const std::string& agv)
+        {
+            auto slot = cell_.slot(product, agv);
+            auto faulty = cell_.faultyParts();
+            int faulty_id = findFaulty(faulty, agv, slot);
+            Product spare;
+            while (faulty_id >= 0 && options_.spares
+                && spares_.take(product.type, faulty.at(faulty_id).world_pose, spare, cell_.parts())) {
+                ROS_INFO_STREAM("[OrderSequencer][inspect] " << product.type << " is faulty, replacing it with the reserved spare");
+                cell_.replaceFaulty(product, faulty.at(faulty_id).world_pose, spare.world_pose, agv);
+                faulty = cell_.faultyParts();
+                faulty_id = findFaulty(faulty, agv, slot);
+            }
+            if (faulty_id < 0)
+                return true;
+            ROS_INFO_STREAM("[OrderSequencer][inspect] " << product.type << " is faulty, removing it from the tray");
+            cell_.discardFaulty(product, faulty.at(faulty_id).world_pose);
+            return false;
+        }
+
+        /**
+         * @brief Start the rail towards the next part of @p products the arm will pick
+         *
+         * Nothing is done while a flip holds the arm, or when the parts left
+         * are all out of the arm's bins.
+         *
+         * @param current Part being processed, not counted
+         */
+        void prepositionArm(const std::vector<Product>& products, const Product* current)
+        {
+            if (!cell_.idle("kitting_arm"))
+                return;
+            for (auto& product : products) {
+                if (product.processed || &product == current)
+                    continue;
+                auto found = cell_.parts().find(product.type);
+                if (found == cell_.parts().end())
+                    continue;
+                for (auto& candidate : found->second) {
+                    if (candidate.status.compare("free") == 0 && armBin(candidate.bin_number)) {
+                        cell_.prepositionArm(candidate.world_pose);
+                        return;
+                    }
+                }
+            }
+        }
+
+        Cell& cell_;
+        PreemptionManager& preemption_;
+        SequencerOptions options_;
+        SparePartPool spares_;
+        FeasibilityAnalyzer feasibility_;
+        // last shortfall logged, per part type
+        std::map<std::string, int> shortfall_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef PREEMPTION_H
+#define PREEMPTION_H
+#include "../util/util.h"
+#include <functional>
+#include <mutex>
+
+namespace motioncontrol {
+
+    /**
+     * @brief What a robot executor was doing when it reached a checkpoint
+     *
+     */
+    struct ExecutorContext {
+        std::string robot;              // "kitting_arm" or "gantry"
+        std::string shipment_type;      // shipment being built, empty when idle
+        std::string destination;        // AGV or assembly station being loaded
+        std::vector<Product> placed;    // parts already in the shipment
+        std::vector<Product> pending;   // parts still reserved for the shipment
+    };
+
+    /**
+     * @brief Build a context from the shipment's part list, split on Product::processed
+     *
+     */
+    ExecutorContext makeContext(const std::string& robot, const std::string& shipment_type,
+        const std::string& destination, const std::vector<Product>& parts);
+
+    /**
+     * @brief Checkpoint/resume layer for the robot executors
+     *
+     * Executors call checkpoint() each time an atomic phase is over (a part
+     * placed and checked, a shipment started). When a high-priority order is
+     * pending the high-priority handler runs to completion on the calling
+     * thread, then the executor carries on from its own locals, which are
+     * left as they were. The context given is only reported. The interrupt is
+     * thus served within one pick cycle wherever it lands.
+     */
+    class PreemptionManager {
+        public:
+        using Trigger = std::function<bool()>;
+        using Handler = std::function<void()>;
+
+        /**
+         * @brief Construct a new Preemption Manager
+         *
+         * @param trigger True while a high-priority order is waiting
+         * @param handler Processes the high-priority order
+         */
+        PreemptionManager(Trigger trigger, Handler handler);
+
+        /**
+         * @brief Yield to the high-priority order if one is waiting
+         *
+         * Does nothing when called from inside the handler.
+         *
+         * @param context State of the calling executor
+         * @return true The high-priority order was processed, carry on
+         * @return false Nothing to do
+         */
+        bool checkpoint(const ExecutorContext& context);
+
+        private:
+        Trigger trigger_;
+        Handler handler_;
+        bool running_{false};
+        std::mutex mutex_;
+    };
+}//namespace
+
+#endif
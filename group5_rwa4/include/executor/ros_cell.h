@@ -0,0 +1,107 @@
+#ifndef ROS_CELL_H
+#define ROS_CELL_H
+#include <array>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+#include "flip_scheduler.h"
+#include "../agv/agv_fleet.h"
+#include "../arm/arm.h"
+#include "../camera/logical_camera.h"
+#include "../comp/comp_class.h"
+#include "../planner/spare_parts.h"
+#include "../station/assembly_station.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Give both robots' planning scenes the parts the cameras just saw
+     */
+    void updatePlanningScenes(const std::array<std::vector<Product>, 19>& list, Arm& arm, gantry_motioncontrol::Gantry& gantry);
+
+    /**
+     * @brief The ARIAC workcell, as the cell of an OrderSequencer
+     *
+     * Holds references to the robots, sensors and managers built by the
+     * node; the camera map the kits are built from and the empty bins are
+     * the node's, kept up to date by it.
+     */
+    class RosCell {
+        public:
+        RosCell(MyCompetitionClass& competition, LogicalCamera& cam, Arm& arm, gantry_motioncontrol::Gantry& gantry,
+            FlipScheduler& flips, AgvFleet& fleet, AssemblyStationManager& stations, PartMap& parts,
+            std::vector<int>& empty_bins);
+
+        std::vector<Order> orders();
+        PartMap& parts() { return parts_; }
+
+        bool placeWithArm(const Product& part, const Product& product, const std::string& agv);
+        /**
+         * @brief From the preset over the bin's row, then back home
+         */
+        bool placeWithGantry(const Product& part, const Product& product, const std::string& agv);
+        std::shared_future<bool> startFlip(const Product& part, const Product& product, const std::string& agv);
+        void waitFor(const std::string& robot) { flips_.waitFor(robot); }
+        bool idle(const std::string& robot) const { return flips_.idle(robot); }
+        void waitAll() { flips_.waitAll(); }
+        void prepositionArm(const geometry_msgs::Pose& pick);
+
+        /**
+         * @brief No quality control message for more than 2 s
+         */
+        bool blackout();
+        /**
+         * @brief Quality control report, after the delay the sensors need to build it
+         */
+        std::vector<Product> faultyParts();
+        geometry_msgs::Pose slot(const Product& product, const std::string& agv);
+        bool replaceFaulty(const Product& product, const geometry_msgs::Pose& faulty, const geometry_msgs::Pose& spare,
+            const std::string& agv);
+        void discardFaulty(const Product& product, const geometry_msgs::Pose& faulty);
+        /**
+         * @brief Submit on the fleet's worker, the service result is checked by waitForDeliveries
+         */
+        void ship(const Kitting& kit);
+
+        /**
+         * @brief Ship again a kit the service rejected, then wait for the AGVs at @p station
+         *
+         * @return false A kit for @p station could not be shipped, or did not arrive in time
+         */
+        bool waitForDeliveries(const std::string& station);
+        /**
+         * @brief Read all cameras again, into the planning scenes and a new map
+         */
+        PartMap scan();
+        bool placeInBriefcase(const Product& part, const Product& product, const std::string& station);
+        /**
+         * @brief Station camera check, once the last part settled in the briefcase
+         */
+        std::vector<std::string> checkBriefcase(const Assembly& assembly);
+        /**
+         * @brief Submit on the station manager's thread, the gantry heads home meanwhile
+         */
+        void submit(const Assembly& assembly);
+
+        private:
+        struct Shipment {
+            Kitting kit;
+            std::shared_future<bool> shipped;
+        };
+
+        MyCompetitionClass& competition_;
+        LogicalCamera& cam_;
+        Arm& arm_;
+        gantry_motioncontrol::Gantry& gantry_;
+        FlipScheduler& flips_;
+        AgvFleet& fleet_;
+        AssemblyStationManager& stations_;
+        PartMap& parts_;
+        std::vector<int>& empty_bins_;
+        // per station, the shipments whose service result is not checked yet
+        std::map<std::string, std::vector<Shipment> > shipments_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+#include <ros/ros.h>
+#include <future>
+#include <string>
+#include "../trace/trace.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Builds the slow components of the node side by side
+     *
+     * A robot spends most of its startup waiting: for its robot model, for
+     * move_group and for its gripper and controller services. Each component
+     * given to launch() is built on its own thread while the caller starts the
+     * competition and scans the workcell, and the caller only blocks in
+     * std::future::get() once it needs that component. An exception thrown
+     * while building is rethrown there.
+     */
+    class Startup {
+        public:
+        Startup() : begin_(ros::WallTime::now()) {}
+
+        /**
+         * @brief Run @p build on its own thread
+         *
+         * @param name Component name, for the log and the trace
+         * @param build Returns the component ready to use, e.g. a std::unique_ptr
+         */
+        template <typename Build>
+        auto launch(const std::string& name, Build build) -> std::future<decltype(build())>
+        {
+            ros::WallTime begin = begin_;
+            return std::async(std::launch::async, [name, build, begin]() {
+                tracing::Span span("startup", "launch");
+                span.arg("component", name);
+                auto component = build();
+                ROS_INFO_STREAM("[Startup][launch] " << name << " ready after "
+                    << (ros::WallTime::now() - begin).toSec() << " s");
+                return component;
+            });
+        }
+        /**
+         * @brief Wall time since the startup began (s)
+         */
+        double elapsed() const
+        {
+            return (ros::WallTime::now() - begin_).toSec();
+        }
+
+        private:
+        ros::WallTime begin_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef BIN_STAGER_H
+#define BIN_STAGER_H
+#include <ros/ros.h>
+#include <geometry_msgs/Pose.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../util/util.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Robots that drop parts in the bins and pick them back
+     */
+    enum class StagingRobot { KITTING, GANTRY };
+
+    /**
+     * @brief Where BinStager puts one part
+     */
+    struct StagingSlot {
+        int bin{ 0 };
+        geometry_msgs::Pose pose;  // center of the part on the bin floor, in world
+        bool kitting{ false };     // the kitting arm reaches it
+        bool gantry{ false };      // the gantry reaches it
+    };
+
+    /**
+     * @brief Room a drop needs along y on top of the part footprint
+     *
+     * A flip puts the part down and grasps it again from its side, so its
+     * slot also keeps the space of the first drop and of the gripper.
+     */
+    struct StagingMargin {
+        double below_y{ 0.0 };
+        double above_y{ 0.0 };
+    };
+
+    /**
+     * @brief Packs parts dropped in the bins so they do not overlap
+     *
+     * Every part is a square of its longer side, as the drop yaw is not
+     * controlled, grown by a clearance so the gripper can come down on it
+     * without touching its neighbours. Free space is searched corner first:
+     * a new part goes against the wall or a part already there, starting
+     * from the +x, -y corner of the bin, which is the side of the rail.
+     *
+     * Occupancy is what the cameras last saw in the bin plus the slots
+     * handed out since, until a part shows up on them or they expire.
+     * Bin and part sizes come from the planning scene file, see
+     * config/planning_scene.yaml.
+     *
+     * Both robots stage through one instance, possibly from different
+     * threads: the occupancy is guarded by a mutex, the geometry is only
+     * written by load(), before the instance is shared.
+     */
+    class BinStager {
+        public:
+        /**
+         * @brief Built with the ARIAC 2021 bins, load() overrides them
+         */
+        BinStager();
+        /**
+         * @param path YAML file with the bins, parts and staging sections
+         * @return false The file could not be read, the built-in geometry is kept
+         */
+        bool load(const std::string& path);
+        /**
+         * @brief Replace the parts in the bins with what the cameras saw
+         *
+         * @param parts Parts seen by the cameras, in world. Parts outside the bins are left out.
+         */
+        void observe(const std::vector<Product>& parts);
+        /**
+         * @brief Find and reserve room for one part in the first of @p bins that has some
+         *
+         * @param part_type Type of the part, empty for the largest one
+         * @param bins Candidate bins, in order of preference
+         * @param robot Robot that has to reach the slot
+         * @param slot Filled with the bin and the pose of the part
+         * @param margin Room needed along y besides the part
+         * @return false None of the bins has room left within reach of @p robot
+         */
+        bool stage(const std::string& part_type, const std::vector<int>& bins, StagingRobot robot, StagingSlot& slot,
+            const StagingMargin& margin = StagingMargin());
+        /**
+         * @brief Number of parts of @p part_type that still fit in @p bin within reach of @p robot
+         */
+        int capacity(int bin, const std::string& part_type, StagingRobot robot) const;
+        /**
+         * @brief Whether @p robot reaches a part at @p pose, in world
+         */
+        bool reachable(StagingRobot robot, const geometry_msgs::Pose& pose) const;
+        /**
+         * @brief Center of the floor of @p bin, in world
+         *
+         * @return false No such bin
+         */
+        bool center(int bin, geometry_msgs::Pose& pose) const;
+
+        private:
+        struct Box {
+            double min_x, min_y, max_x, max_y;
+        };
+        struct Reservation {
+            int bin;
+            Box box;
+            ros::Time stamp;
+        };
+
+        double footprint(const std::string& part_type) const;
+        std::vector<Box> occupied(int bin) const;
+        bool fit(int bin, double size_x, double size_y, StagingRobot robot, const std::vector<Box>& taken, Box& box) const;
+
+        std::map<int, std::vector<double> > centers_;  // bin number -> x, y in world
+        std::vector<double> size_{ 0.62, 0.62 };
+        double wall_{ 0.02 };
+        std::map<std::string, std::vector<double> > part_sizes_;
+        double clearance_{ 0.04 };
+        double wall_margin_{ 0.03 };
+        double height_{ 0.751 };
+        double hold_time_{ 60.0 };
+        std::map<StagingRobot, std::vector<double> > reach_;  // robot -> min x, max x in world
+        std::map<int, std::vector<Box> > seen_;
+        std::vector<Reservation> reserved_;
+        mutable std::mutex mutex_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef FEASIBILITY_H
+#define FEASIBILITY_H
+#include "../util/util.h"
+#include <set>
+
+namespace motioncontrol {
+
+    /**
+     * @brief What can be built of one kitting shipment
+     *
+     */
+    struct ShipmentPlan {
+        std::string order_id;
+        std::string shipment_type;
+        std::vector<bool> available;   // one entry per product of the shipment
+        std::size_t missing{ 0 };      // products with no part allocated
+        bool ship{ false };            // at least one product can be placed
+        bool partial{ false };         // ship with missing products
+    };
+
+    /**
+     * @brief Result of a feasibility analysis
+     *
+     */
+    struct FeasibilityPlan {
+        std::map<std::string, int> shortfall;   // part type -> parts missing over all orders
+        std::vector<ShipmentPlan> shipments;    // in allocation order
+        /**
+         * @brief Plan of a shipment, nullptr if it is not part of the analysis
+         */
+        const ShipmentPlan* find(const std::string& shipment_type) const;
+    };
+
+    /**
+     * @brief Order feasibility analysis against the current inventory
+     *
+     * Only the parts the kit loop can take are counted: the "free" parts in
+     * the bins of the camera map. Spares held by SparePartPool ("reserved")
+     * and parts on the belt are not, the conveyor is only emptied into the
+     * bins before the map is built, so a belt part would be promised to a
+     * shipment that never gets it.
+     * Products flagged processed are already on their AGV and need nothing,
+     * shipments marked shipped are left out.
+     * They are allocated to kitting shipments by order priority; inside an
+     * order the shipments that can be completed are served first so scarce
+     * parts go where they earn the completion bonus. A shipment that cannot
+     * be completed is still shipped with what is available (partial credit).
+     *
+     * The analysis only counts, so it can be rerun on every inventory change.
+     */
+    class FeasibilityAnalyzer {
+        public:
+        /**
+         * @brief Leave a shipment out of later analyses, its parts are already used
+         *
+         * @param shipment_type Shipment type
+         */
+        void markShipped(const std::string& shipment_type);
+        /**
+         * @brief Allocate the inventory to the kitting shipments of @p orders
+         *
+         * @param orders Orders announced so far
+         * @param inventory Map of parts
+         * @return FeasibilityPlan
+         */
+        FeasibilityPlan analyse(const std::vector<Order>& orders, const std::map<std::string, std::vector<Product> >& inventory) const;
+
+        private:
+        std::set<std::string> shipped_;
+    };
+}//namespace
+
+#endif
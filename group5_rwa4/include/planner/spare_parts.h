@@ -0,0 +1,54 @@
+#ifndef SPARE_PARTS_H
+#define SPARE_PARTS_H
+#include "../util/util.h"
+
+namespace motioncontrol {
+
+    using PartMap = std::map<std::string, std::vector<Product> >;
+
+    /**
+     * @brief Spare parts set aside for faulty-part replacement
+     *
+     * One surplus instance per required part type is marked "reserved" in
+     * the camera map when an order arrives, so the normal scan (which only
+     * takes "free" parts) never picks it and a QC fault can be answered
+     * without searching the map again.
+     */
+    class SparePartPool {
+        public:
+        /**
+         * @brief Reserve one spare per part type needed by the kitting shipments of @p orders
+         *
+         * Spares reserved by a previous call are released first. A type is only
+         * reserved when the bins hold more free parts than the orders need, and
+         * only in the bins the kitting arm reaches (1, 2, 5, 6).
+         *
+         * @param orders Orders announced so far
+         * @param cam_map Map of parts, statuses are updated in place
+         * @return int Number of spares reserved
+         */
+        int reserve(const std::vector<Order>& orders, PartMap& cam_map);
+        /**
+         * @brief Take the reserved spare of @p part_type closest to @p near along the rail
+         *
+         * @param part_type Type of part
+         * @param near Pose of the faulty part in world
+         * @param spare Filled with the spare
+         * @param cam_map Map of parts, the spare is marked "processed"
+         * @return true A spare was available
+         * @return false None left for this type
+         */
+        bool take(const std::string& part_type, const geometry_msgs::Pose& near, Product& spare, PartMap& cam_map);
+        /**
+         * @brief Give every reserved spare back to the free pool
+         *
+         * @param cam_map Map of parts
+         */
+        void release(PartMap& cam_map);
+
+        private:
+        std::map<std::string, std::vector<std::size_t> > reserved_;  // part type -> indices in cam_map
+    };
+}//namespace
+
+#endif
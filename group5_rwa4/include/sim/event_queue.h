@@ -0,0 +1,56 @@
+#ifndef SIM_EVENT_QUEUE_H
+#define SIM_EVENT_QUEUE_H
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace sim {
+
+    /**
+     * @brief Discrete-event queue driving the simulated clock
+     *
+     * Events at the same time run in the order they were scheduled, so a
+     * trial replays identically for a given seed.
+     */
+    class EventQueue {
+        public:
+        using Action = std::function<void()>;
+
+        /**
+         * @brief Run @p action at simulated time @p time (clamped to now)
+         */
+        void schedule(double time, Action action);
+        /**
+         * @brief Run every event up to @p time and move the clock there
+         */
+        void runUntil(double time);
+        /**
+         * @brief Run every pending event, the clock ends at the last one
+         */
+        void runAll();
+        /**
+         * @brief Current simulated time in seconds
+         */
+        double now() const { return now_; }
+        bool empty() const { return events_.empty(); }
+
+        private:
+        struct Event {
+            double time;
+            unsigned long sequence;
+            Action action;
+        };
+        struct Later {
+            bool operator()(const Event& a, const Event& b) const
+            {
+                return a.time > b.time || (a.time == b.time && a.sequence > b.sequence);
+            }
+        };
+
+        std::priority_queue<Event, std::vector<Event>, Later> events_;
+        double now_{ 0 };
+        unsigned long sequence_{ 0 };
+    };
+}//namespace
+
+#endif
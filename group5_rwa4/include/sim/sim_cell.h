@@ -0,0 +1,87 @@
+#ifndef SIM_CELL_H
+#define SIM_CELL_H
+#include "sim_workcell.h"
+#include <future>
+#include <memory>
+
+namespace sim {
+
+    /**
+     * @brief The simulated workcell, as the cell of a motioncontrol::OrderSequencer
+     *
+     * Same moves as motioncontrol::RosCell, on the simulated robots. The
+     * clock runs one robot at a time, so a flip is deferred: it runs when a
+     * robot it uses is needed again (waitFor, waitAll), and the time since
+     * it was started is credited to it as work done beside the other robot.
+     */
+    class SimCell {
+        public:
+        SimCell(SimWorld& world, SimArm& arm, SimGantry& gantry, SimLogicalCamera& cam,
+            std::map<std::string, SimAgv>& agvs, std::map<std::string, std::vector<Product> >& parts,
+            std::vector<int>& empty_bins);
+
+        std::vector<Order> orders() { return world_.announcedOrders(); }
+        std::map<std::string, std::vector<Product> >& parts() { return parts_; }
+
+        bool placeWithArm(const Product& part, const Product& product, const std::string& agv);
+        bool placeWithGantry(const Product& part, const Product& product, const std::string& agv);
+        /**
+         * @brief Defer the flip, by the arm alone from its bins, else handed over by the gantry
+         */
+        std::shared_future<bool> startFlip(const Product& part, const Product& product, const std::string& agv);
+        void waitFor(const std::string& robot);
+        bool idle(const std::string& robot) const;
+        void waitAll();
+        void prepositionArm(const geometry_msgs::Pose& pick);
+
+        bool blackout() { return world_.blackout(); }
+        std::vector<Product> faultyParts();
+        geometry_msgs::Pose slot(const Product& product, const std::string& agv);
+        bool replaceFaulty(const Product& product, const geometry_msgs::Pose& faulty, const geometry_msgs::Pose& spare,
+            const std::string& agv);
+        void discardFaulty(const Product& product, const geometry_msgs::Pose& faulty);
+        void ship(const Kitting& kit);
+
+        /**
+         * @brief Same as motioncontrol::RosCell: ship a rejected kit again, then wait for the AGVs shipped to @p station
+         */
+        bool waitForDeliveries(const std::string& station);
+        std::map<std::string, std::vector<Product> > scan();
+        bool placeInBriefcase(const Product& part, const Product& product, const std::string& station);
+        std::vector<std::string> checkBriefcase(const Assembly& assembly);
+        void submit(const Assembly& assembly);
+
+        private:
+        struct Shipment {
+            Kitting kit;
+            bool shipped;
+        };
+        struct Flip {
+            Product part;
+            Product product;
+            std::string agv;
+            bool handover;      // the gantry brings the part to a bin of the arm
+            double started;
+            std::shared_ptr<std::promise<bool> > placed;
+        };
+
+        /**
+         * @brief Run the deferred flips in order, up to the last one using @p robot (all when empty)
+         */
+        void run_flips(const std::string& robot);
+
+        SimWorld& world_;
+        SimArm& arm_;
+        SimGantry& gantry_;
+        SimLogicalCamera& cam_;
+        std::map<std::string, SimAgv>& agvs_;
+        std::map<std::string, std::vector<Product> >& parts_;
+        std::vector<int>& empty_bins_;
+        std::vector<Flip> flips_;
+        // per station, the shipments not waited for yet
+        std::map<std::string, std::vector<Shipment> > shipments_;
+        double flips_free_{ 0 };    // end of the last flip run
+    };
+}//namespace
+
+#endif
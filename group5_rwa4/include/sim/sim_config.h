@@ -0,0 +1,81 @@
+#ifndef SIM_CONFIG_H
+#define SIM_CONFIG_H
+#include "../util/util.h"
+
+namespace sim {
+
+    /**
+     * @brief Durations of the workcell operations, in seconds unless noted
+     *
+     * Defaults are the values in config/sim_timing.yaml.
+     */
+    struct SimTiming {
+        double arm_rail_speed{ 1.0 };       // m/s along the linear actuator
+        double arm_pick{ 9.0 };             // pregrasp, descent until attached, retreat
+        double arm_place{ 6.5 };            // over the tray, lower, release, back to home2
+        double arm_preset{ 1.5 };
+        double arm_discard{ 2.0 };
+        double arm_flip{ 25.0 };            // full flip sequence through the staging bin
+        double gantry_speed{ 0.8 };         // m/s on the rails
+        double gantry_pick{ 9.0 };
+        double gantry_place{ 8.0 };
+        double gantry_preset{ 2.5 };
+        double gantry_pregrasp{ 2.0 };      // of gantry_pick, taken during the travel to the bin
+        double agv_transit{ 12.0 };         // kitting station to assembly station
+        double qc_delay{ 4.0 };             // wait for the quality control list
+        double camera_refresh{ 6.0 };       // findparts + segregate_parts + map
+        double station_submit{ 1.0 };
+        double conveyor_pick{ 10.0 };
+        double jitter{ 0.1 };               // +/- fraction applied to every duration
+        double fault_rate{ 0.0 };           // probability a part not listed faulty is faulty
+
+        /**
+         * @brief Load the timing from a YAML file, missing keys keep their defaults
+         *
+         * @return false The file could not be read
+         */
+        bool load(const std::string& path);
+    };
+
+    /**
+     * @brief Part spawned in the workcell by the trial
+     */
+    struct TrialPart {
+        std::string name;       // <type>_<index> as in faulty_products
+        std::string type;
+        int bin_number{ 0 };    // 0 when not in a bin
+        std::string agv;        // set for parts preloaded on an AGV
+        geometry_msgs::Pose world_pose;
+        double belt_time{ -1 }; // time the part shows up on the belt, -1 otherwise
+    };
+
+    /**
+     * @brief Order of the trial with its announcement condition
+     */
+    struct TrialOrder {
+        Order order;
+        std::string condition;        // time, wanted_products, unwanted_products, agv_station_reached
+        std::string condition_value;
+    };
+
+    /**
+     * @brief Contents of an ARIAC trial configuration file
+     */
+    struct TrialConfig {
+        std::vector<TrialPart> parts;
+        std::vector<TrialOrder> orders;
+        std::map<std::string, std::string> agv_locations;
+        std::vector<std::string> faulty_products;
+        int blackout_product_count{ -1 };
+        double blackout_duration{ 0 };
+
+        /**
+         * @brief Parse a trial file of config/trial_config
+         *
+         * @return false The file could not be read
+         */
+        bool load(const std::string& path);
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SIM_TRIAL_H
+#define SIM_TRIAL_H
+#include "sim_config.h"
+#include "../executor/order_sequencer.h"
+
+namespace sim {
+
+    /**
+     * @brief Scheduling policies compared by workcell_sim, all on for the competition
+     */
+    struct Policy {
+        motioncontrol::SequencerOptions sequencer;
+        bool preemption{ true };    // serve a high-priority order at the next checkpoint
+    };
+
+    struct TrialResult {
+        double score{ 0 };
+        double makespan{ 0 };
+        bool completed{ false };    // every shipment of every order went out
+    };
+
+    /**
+     * @brief My_node's startup on the simulated workcell, then its orders through OrderSequencer<SimCell>
+     *
+     * Orders are taken in announcement order, a high-priority one jumps in
+     * at the checkpoints. The run gives up after an hour of simulated time.
+     *
+     * @param seed Duration jitter and random faults
+     */
+    TrialResult runTrial(const TrialConfig& trial, const SimTiming& timing, unsigned int seed, const Policy& policy);
+}//namespace
+
+#endif
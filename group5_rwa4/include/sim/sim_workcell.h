@@ -0,0 +1,222 @@
+#ifndef SIM_WORKCELL_H
+#define SIM_WORKCELL_H
+#include "event_queue.h"
+#include "sim_config.h"
+#include <array>
+#include <random>
+
+namespace sim {
+
+    /**
+     * @brief State of the simulated workcell: parts, AGVs, orders and score
+     *
+     * Robot calls are blocking like their MoveIt counterparts: each one
+     * advances the clock by its (jittered) duration, and every event due in
+     * the meantime (order announcements, belt spawns, AGV arrivals, end of a
+     * sensor blackout) runs on the way.
+     */
+    class SimWorld {
+        public:
+        struct PartState {
+            TrialPart part;
+            bool faulty{ false };
+            std::string location;   // bin, belt, agv, station, gripper, discarded
+            std::string holder;     // agv id or station when on a tray or in a briefcase
+            geometry_msgs::Pose world_pose;
+            geometry_msgs::Pose frame_pose;
+        };
+
+        SimWorld(const TrialConfig& trial, const SimTiming& timing, unsigned int seed);
+
+        const SimTiming& timing() const { return timing_; }
+        double now() const { return events_.now(); }
+        /**
+         * @brief Let @p seconds (jittered) of simulated time pass
+         */
+        void spend(double seconds);
+        /**
+         * @brief Let the next spend() calls take their time from @p seconds first
+         *
+         * For work that ran beside the clock, while it counted the other
+         * robot: a deferred flip is credited the time since it was started.
+         * @return double Credit left over from the previous call
+         */
+        double overlap(double seconds);
+        /**
+         * @brief Let time pass until @p condition holds or @p timeout elapses
+         *
+         * @return true @p condition held before the timeout
+         */
+        bool waitFor(std::function<bool()> condition, double timeout);
+
+        std::vector<Order> announcedOrders() const { return announced_; }
+        bool highPriorityAnnounced() const;
+
+        std::vector<PartState>& parts() { return parts_; }
+        /**
+         * @brief Index of the part at @p location closest to @p pose, -1 if none
+         */
+        int partNear(const geometry_msgs::Pose& pose, const std::string& location, const std::string& holder = "") const;
+        /**
+         * @brief Put a part on an AGV tray or in a briefcase
+         */
+        void place(int index, const std::string& location, const std::string& holder,
+            const geometry_msgs::Pose& frame_pose, const geometry_msgs::Pose& world_pose);
+        bool blackout() const { return now() < blackout_end_; }
+
+        std::string agvLocation(const std::string& agv) const;
+        /**
+         * @brief World pose of @p frame_pose on the tray of @p agv, where the AGV is now
+         */
+        geometry_msgs::Pose trayPose(const std::string& agv, const geometry_msgs::Pose& frame_pose) const;
+        /**
+         * @brief Score the kit on @p agv and send it to @p station
+         */
+        bool shipAgv(const std::string& agv, const std::string& shipment_type, const std::string& station);
+        /**
+         * @brief Score the briefcase at @p station
+         */
+        bool submitAssembly(const std::string& station, const std::string& shipment_type);
+
+        double score() const { return score_; }
+        double makespan() const { return makespan_; }
+        bool allSubmitted() const;
+
+        private:
+        void announce(const TrialOrder& order);
+        void check_conditions();
+        double shipment_score(const std::vector<Product>& products, const std::string& location, const std::string& holder, unsigned short priority) const;
+        const TrialOrder* find_order(const std::string& shipment_type) const;
+
+        SimTiming timing_;
+        EventQueue events_;
+        double overlap_{ 0 };
+        std::mt19937 rng_;
+        std::vector<TrialOrder> pending_;
+        std::vector<TrialOrder> trial_orders_;
+        std::vector<Order> announced_;
+        std::vector<PartState> parts_;
+        std::map<std::string, std::string> agv_locations_;
+        std::map<std::string, std::string> agv_arrivals_;   // "agv3_at_as3" conditions met
+        int placed_count_{ 0 };
+        int blackout_product_count_{ -1 };
+        double blackout_duration_{ 0 };
+        double blackout_end_{ -1 };
+        double score_{ 0 };
+        double makespan_{ 0 };
+        std::size_t submitted_{ 0 };
+    };
+
+    /**
+     * @brief Simulated kitting arm, same calls as motioncontrol::Arm
+     */
+    class SimArm {
+        public:
+        explicit SimArm(SimWorld& world) : world_(world) {}
+        void init() {}
+        bool pickPart(std::string part_type, geometry_msgs::Pose part_pose);
+        bool pickfaulty(std::string part_type, geometry_msgs::Pose part_pose);
+        bool placePart(geometry_msgs::Pose part_init_pose, geometry_msgs::Pose part_goal_pose, std::string agv);
+        bool replaceFaultyPart(std::string part_type, geometry_msgs::Pose faulty_pose, geometry_msgs::Pose spare_pose, geometry_msgs::Pose goal_in_tray_frame, std::string agv);
+        bool movePart(std::string part_type, geometry_msgs::Pose pose_in_world_frame, geometry_msgs::Pose goal_in_tray_frame, std::string agv);
+        void activateGripper() {}
+        void deactivateGripper();
+        void moveBaseTo(double linear_arm_actuator_joint_position);
+        /**
+         * @brief Start the base towards @p linear_arm_actuator_joint_position, the clock does not wait
+         *
+         * The next move of the arm finds the base where it got to by then.
+         * @return false A part is held
+         */
+        bool prepositionBase(double linear_arm_actuator_joint_position);
+        void goToPresetLocation(std::string location_name);
+        std::vector<int> pick_from_conveyor(std::vector<int> ebin, unsigned short int count,
+            const std::vector<std::string>& wanted = std::vector<std::string>());
+        bool flippart(Product part, std::vector<int> rbin, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool pick);
+
+        private:
+        // the part of the preposition done by now
+        void finishPreposition();
+        /**
+         * @brief Pick the first part of a @p wanted type on the belt, on the move
+         */
+        bool interceptFromBelt(const std::vector<std::string>& wanted);
+
+        SimWorld& world_;
+        double rail_y_{ 0 };
+        double preposition_y_{ 0 };
+        double preposition_start_{ -1 };
+        int held_{ -1 };
+    };
+
+    /**
+     * @brief Simulated gantry, same calls as gantry_motioncontrol::Gantry
+     *
+     * Preset locations are passed by name.
+     */
+    class SimGantry {
+        public:
+        explicit SimGantry(SimWorld& world) : world_(world) {}
+        void init() {}
+        void goToPresetLocation(std::string location_name);
+        bool goToLocation(const std::string& name);
+        void move_gantry_to_bin(unsigned short int bin);
+        /**
+         * @brief To the bin with the arm taking the pregrasp on the way
+         *
+         * The next pick is shorter by gantry_pregrasp if it is the part at @p part.
+         */
+        void move_gantry_to_bin(unsigned short int bin, const std::string& part_type, const geometry_msgs::Pose& part);
+        void move_gantry_to_assembly_station(std::string camera);
+        bool movePart(geometry_msgs::Pose part_init_pose, geometry_msgs::Pose target_pose, std::string location, std::string part_type);
+        bool movePartfrombin(geometry_msgs::Pose part_init_pose, std::string part_type, unsigned short int bin);
+
+        private:
+        void travel_to(double x, double y);
+        // pick time at @p part_pose, less the pregrasp taken on the way
+        double pick_time(const geometry_msgs::Pose& part_pose);
+
+        SimWorld& world_;
+        double x_{ -2.5 };
+        double y_{ 0 };
+        bool preshaped_{ false };
+        geometry_msgs::Pose preshaped_for_;
+    };
+
+    /**
+     * @brief Simulated AGV, same calls as motioncontrol::Agv
+     */
+    class SimAgv {
+        public:
+        SimAgv(SimWorld& world, std::string agv_name) : world_(world), agv_name_(agv_name) {}
+        bool shipAgv(std::string shipment_type, std::string station);
+        bool getAGVStatus();
+
+        private:
+        SimWorld& world_;
+        std::string agv_name_;
+    };
+
+    /**
+     * @brief Simulated logical cameras and quality control sensors, same calls as LogicalCamera
+     */
+    class SimLogicalCamera {
+        public:
+        explicit SimLogicalCamera(SimWorld& world) : world_(world) {}
+        std::array<std::vector<Product>, 19> findparts();
+        void segregate_parts(std::array<std::vector<Product>, 19> list);
+        std::map<std::string, std::vector<Product> >& get_camera_map() { return camera_map_; }
+        std::vector<int> get_ebin_list();
+        void query_faulty_cam();
+        std::vector<Product> get_faulty_part_list() { return faulty_part_list_; }
+        std::vector<Product> get_station_parts(std::string station);
+
+        std::vector<Product> faulty_part_list_;
+
+        private:
+        SimWorld& world_;
+        std::map<std::string, std::vector<Product> > camera_map_;
+    };
+}//namespace
+
+#endif
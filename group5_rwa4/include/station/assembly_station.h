@@ -0,0 +1,57 @@
+#ifndef ASSEMBLY_STATION_H
+#define ASSEMBLY_STATION_H
+#include "../util/util.h"
+#include "../camera/logical_camera.h"
+#include "../util/worker_threads.h"
+#include <future>
+#include <memory>
+#include <mutex>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Owns one persistent submit_shipment client per assembly station
+     *
+     * The briefcase is checked against the shipment with the station camera
+     * by the caller, before it submits. Submissions run on a worker thread,
+     * so the gantry can start the next assembly during the round trip.
+     */
+    class AssemblyStationManager {
+        public:
+        AssemblyStationManager(ros::NodeHandle& node, LogicalCamera& camera);
+        ~AssemblyStationManager();
+
+        /**
+         * @brief Check the briefcase contents against the shipment
+         *
+         * @param shipment Assembly shipment to check
+         * @param missing Filled with the product types not seen at the station
+         * @return true Every product type of the shipment is in the briefcase
+         * @return false Something is missing or the camera did not answer
+         */
+        bool validate(const Assembly& shipment, std::vector<std::string>& missing);
+        /**
+         * @brief Submit an assembly shipment without blocking the caller
+         *
+         * @param shipment Assembly shipment to submit
+         * @return std::future<bool> Resolves to the service result
+         */
+        std::future<bool> submitAsync(const Assembly& shipment);
+
+        private:
+        // persistent client of a station, used by one submission at a time
+        struct Station {
+            ros::ServiceClient client;
+            std::mutex mutex;
+        };
+
+        bool submit(const std::string& station, const std::string& shipment_type);
+
+        LogicalCamera& camera_;
+        // filled in the constructor, only the entries change afterwards
+        std::map<std::string, Station> clients_;
+        WorkerThreads workers_;
+    };
+}//namespace
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace tracing {
+
+    /**
+     * @brief One finished span
+     *
+     * Category, name and argument key must be string literals, only the
+     * argument value is copied.
+     */
+    struct Event {
+        const char* category;
+        const char* name;
+        std::int64_t start_ns;
+        std::int64_t duration_ns;
+        const char* arg_key;
+        char arg_value[48];
+    };
+
+    /**
+     * @brief Start recording spans
+     */
+    void enable();
+    /**
+     * @brief Stop recording spans, recorded ones are kept
+     */
+    void disable();
+    bool enabled();
+    /**
+     * @brief Append a span to the ring buffer of the calling thread
+     *
+     * Each thread owns its buffer, so this takes no lock. When a buffer is
+     * full the oldest spans are overwritten.
+     */
+    void record(const Event& event);
+    /**
+     * @brief Dump every recorded span as Chrome trace JSON
+     *
+     * Open the file in chrome://tracing or ui.perfetto.dev. Call it once the
+     * worker threads are idle, a span recorded during the dump may come out torn.
+     *
+     * @param path Output file
+     * @return false The file could not be written
+     */
+    bool write(const std::string& path);
+
+    inline std::int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Records the time between its construction and destruction
+     *
+     * @code
+     * tracing::Span span("arm", "pickPart");
+     * span.arg("type", part_type);
+     * @endcode
+     */
+    class Span {
+        public:
+        Span(const char* category, const char* name) : active_{ enabled() }
+        {
+            if (active_) {
+                event_.category = category;
+                event_.name = name;
+                event_.arg_key = nullptr;
+                event_.start_ns = now_ns();
+            }
+        }
+        ~Span()
+        {
+            if (active_) {
+                event_.duration_ns = now_ns() - event_.start_ns;
+                record(event_);
+            }
+        }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        /**
+         * @brief Attach an argument shown with the span, longer values are cut
+         */
+        void arg(const char* key, const std::string& value);
+        void arg(const char* key, double value);
+
+        private:
+        bool active_;
+        Event event_;
+    };
+}//namespace
+
+#endif
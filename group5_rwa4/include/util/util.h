@@ -44,7 +44,7 @@ typedef struct Product
     geometry_msgs::Pose target_pose;
     geometry_msgs::TransformStamped transformStamped;
     std::string camera;
-    std::string status;
+    std::string status; // "free", "reserved" (spare) or "processed"
     bool processed;
     std::string qcs_id;
     int bin_number;
@@ -0,0 +1,77 @@
+#ifndef WORKER_THREADS_H
+#define WORKER_THREADS_H
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Detached-style work on threads that are still joined
+     *
+     * Each start() runs its work on a new thread. The threads that are over
+     * are joined on the next start(), so a long run does not pile them up,
+     * and join() waits for the ones still running.
+     */
+    class WorkerThreads {
+        public:
+        ~WorkerThreads() { join(); }
+
+        template <typename Work>
+        void start(Work work)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reap();
+            auto done = std::make_shared<std::atomic<bool> >(false);
+            workers_.push_back(Worker{ std::thread([work, done]() {
+                work();
+                *done = true;
+            }), done });
+        }
+        /**
+         * @brief Wait for every worker still running
+         */
+        void join()
+        {
+            std::vector<Worker> workers;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                workers.swap(workers_);
+            }
+            for (auto& worker : workers) {
+                if (worker.thread.joinable())
+                    worker.thread.join();
+            }
+        }
+
+        private:
+        struct Worker {
+            std::thread thread;
+            std::shared_ptr<std::atomic<bool> > done;
+        };
+
+        // join the workers that are over, mutex_ held
+        void reap()
+        {
+            std::size_t running{ 0 };
+            for (std::size_t i = 0; i < workers_.size(); i++) {
+                if (*workers_[i].done) {
+                    workers_[i].thread.join();
+                    continue;
+                }
+                // a joinable thread must not be moved onto itself
+                if (i != running)
+                    workers_[running] = std::move(workers_[i]);
+                running++;
+            }
+            workers_.resize(running);
+        }
+
+        std::vector<Worker> workers_;
+        std::mutex mutex_;
+    };
+}//namespace
+
+#endif
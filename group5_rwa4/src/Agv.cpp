@@ -1,5 +1,6 @@
 #include "../include/agv/agv.h"
- 
+#include "../include/trace/trace.h"
+
 namespace motioncontrol {
     Agv::Agv(ros::NodeHandle& node, std::string agv_name) : agv_name_{agv_name}
     {
@@ -16,10 +17,15 @@ namespace motioncontrol {
 
         auto agv_state_name = "/ariac/" + agv_name + "/state";
         agv_state_subscriber_ = node.subscribe(agv_state_name, 10, &Agv::agv_state_callback, this);
+
+        auto agv_station_name = "/ariac/" + agv_name + "/station";
+        agv_station_subscriber_ = node.subscribe(agv_station_name, 10, &Agv::agv_station_callback, this);
     }
 
 
     bool Agv::shipAgv(std::string shipment_type, std::string station) {
+        tracing::Span span("service", "shipAgv");
+        span.arg("shipment_type", shipment_type);
         nist_gear::AGVToAssemblyStation msg;
         msg.request.assembly_station_name = station;
         msg.request.shipment_type = shipment_type;
@@ -38,14 +44,61 @@ namespace motioncontrol {
 
     bool Agv::getAGVStatus()
     {
+        std::lock_guard<std::mutex> lock(mutex_);
         return agv_ready_;
     }
 
+    std::string Agv::getState()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_;
+    }
+
+    std::string Agv::getStation()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return station_;
+    }
+
+    void Agv::setUpdateListener(std::function<void(const std::string&, const std::string&)> listener)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listener_ = listener;
+    }
+
     void Agv::agv_state_callback(const std_msgs::String& msg)
     {
-        if (!((msg.data).compare("ready_to_deliver")))
-            agv_ready_ = true;
-        else
-            agv_ready_ = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_ = msg.data;
+            if (!((msg.data).compare("ready_to_deliver")))
+                agv_ready_ = true;
+            else
+                agv_ready_ = false;
+        }
+        notify_listener();
+    }
+
+    void Agv::agv_station_callback(const std_msgs::String& msg)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            station_ = msg.data;
+        }
+        notify_listener();
+    }
+
+    void Agv::notify_listener()
+    {
+        std::string state, station;
+        std::function<void(const std::string&, const std::string&)> listener;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state = state_;
+            station = station_;
+            listener = listener_;
+        }
+        if (listener)
+            listener(state, station);
     }
 }//namespace
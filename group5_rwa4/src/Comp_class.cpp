@@ -1,4 +1,5 @@
 #include "../include/comp/comp_class.h"
+#include "../include/trace/trace.h"
 
 MyCompetitionClass::MyCompetitionClass(ros::NodeHandle & node)
   : current_score_(0)
@@ -75,6 +76,7 @@ void MyCompetitionClass::competition_clock_callback(const rosgraph_msgs::Clock::
 
 void MyCompetitionClass::startCompetition()
 {
+  tracing::Span span("service", "start_competition");
   // create a Service client for the correct service, i.e. '/ariac/start_competition'.
   ros::ServiceClient start_client =
     node_.serviceClient<std_srvs::Trigger>("/ariac/start_competition");
@@ -102,6 +104,7 @@ void MyCompetitionClass::startCompetition()
 
 void MyCompetitionClass::endCompetition()
 {
+  tracing::Span span("service", "end_competition");
   ros::ServiceClient end_client = node_.serviceClient<std_srvs::Trigger>("/ariac/end_competition");
 
   std_srvs::Trigger srv;
@@ -164,6 +167,7 @@ void MyCompetitionClass::order_callback(const nist_gear::Order::ConstPtr & order
             Product new_kproduct;
             new_kproduct.type = Prod.type;
             new_kproduct.frame_pose = Prod.pose;
+            new_kproduct.processed = false;
             new_kitting.products.push_back(new_kproduct);
         }
         new_order.kitting.push_back(new_kitting);
@@ -181,6 +185,7 @@ void MyCompetitionClass::order_callback(const nist_gear::Order::ConstPtr & order
             Product new_aproduct;
             new_aproduct.type = Prod.type;
             new_aproduct.frame_pose = Prod.pose;
+            new_aproduct.processed = false;
             new_assembly.products.push_back(new_aproduct);
         }
         new_order.assembly.push_back(new_assembly);
@@ -0,0 +1,141 @@
+#include "../include/agv/agv_fleet.h"
+#include "../include/trace/trace.h"
+#include <chrono>
+
+namespace motioncontrol {
+    AgvFleet::AgvFleet(ros::NodeHandle& node)
+    {
+        for (const std::string agv_id : { "agv1", "agv2", "agv3", "agv4" }) {
+            status_[agv_id] = AgvStatus{};
+            agvs_[agv_id].reset(new Agv(node, agv_id));
+            agvs_[agv_id]->setUpdateListener(
+                [this, agv_id](const std::string& state, const std::string& station) {
+                    update(agv_id, state, station);
+                });
+        }
+        ROS_INFO_STREAM("[AgvFleet] tracking " << agvs_.size() << " AGVs");
+    }
+
+    AgvFleet::~AgvFleet()
+    {
+        // detach the listeners first so no callback touches a half-destroyed fleet
+        for (auto& agv : agvs_)
+            agv.second->setUpdateListener(nullptr);
+        status_changed_.notify_all();
+        workers_.join();
+    }
+
+    std::future<bool> AgvFleet::shipAsync(const std::string& agv_id, const std::string& shipment_type,
+        const std::string& station, ros::Duration ready_timeout)
+    {
+        auto result = std::make_shared<std::promise<bool> >();
+        std::future<bool> future = result->get_future();
+
+        if (agvs_.find(agv_id) == agvs_.end()) {
+            ROS_ERROR_STREAM("[AgvFleet][shipAsync] Unknown AGV: " << agv_id);
+            result->set_value(false);
+            return future;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            status_[agv_id].destination = station;
+        }
+        workers_.start([this, result, agv_id, shipment_type, station, ready_timeout]() {
+            if (!wait_until_ready(agv_id, ready_timeout)) {
+                ROS_WARN_STREAM("[AgvFleet][shipAsync] " << agv_id << " not ready_to_deliver, shipping anyway");
+            }
+            bool shipped = agvs_.at(agv_id)->shipAgv(shipment_type, station);
+            if (!shipped) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                status_[agv_id].destination.clear();
+            }
+            status_changed_.notify_all();
+            result->set_value(shipped);
+        });
+        return future;
+    }
+
+    void AgvFleet::onArrival(ArrivalCallback callback)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        arrival_callbacks_.push_back(callback);
+    }
+
+    bool AgvFleet::waitForDeliveries(const std::string& station, ros::Duration timeout)
+    {
+        tracing::Span span("wait", "agv_delivery");
+        span.arg("station", station);
+        std::unique_lock<std::mutex> lock(mutex_);
+        return waitUntil(lock, ros::Time::now() + timeout, [this, &station]() {
+            if (!ros::ok())
+                return true;
+            for (const auto& status : status_) {
+                if (status.second.destination == station)
+                    return false;
+            }
+            return true;
+        });
+    }
+
+    bool AgvFleet::isReady(const std::string& agv_id)
+    {
+        auto agv = agvs_.find(agv_id);
+        if (agv == agvs_.end())
+            return false;
+        return agv->second->getAGVStatus();
+    }
+
+    std::string AgvFleet::getStation(const std::string& agv_id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto status = status_.find(agv_id);
+        if (status == status_.end())
+            return "";
+        return status->second.station;
+    }
+
+    void AgvFleet::update(const std::string& agv_id, const std::string& state, const std::string& station)
+    {
+        std::vector<ArrivalCallback> callbacks;
+        bool arrived{ false };
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& status = status_[agv_id];
+            arrived = station != status.station && station.rfind("as", 0) == 0;
+            status.state = state;
+            status.station = station;
+            if (arrived) {
+                if (status.destination == station)
+                    status.destination.clear();
+                callbacks = arrival_callbacks_;
+            }
+        }
+        status_changed_.notify_all();
+
+        if (arrived) {
+            ROS_INFO_STREAM("[AgvFleet] " << agv_id << " arrived at " << station);
+            for (auto& callback : callbacks)
+                callback(agv_id, station);
+        }
+    }
+
+    bool AgvFleet::wait_until_ready(const std::string& agv_id, ros::Duration timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return waitUntil(lock, ros::Time::now() + timeout, [this, &agv_id]() {
+            return !ros::ok() || status_[agv_id].state == "ready_to_deliver";
+        });
+    }
+
+    bool AgvFleet::waitUntil(std::unique_lock<std::mutex>& lock, const ros::Time& deadline, std::function<bool()> done)
+    {
+        // the AGV updates wake the wait up, the short timeout only catches the deadline
+        while (!done()) {
+            if (ros::Time::now() >= deadline)
+                return false;
+            status_changed_.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        return true;
+    }
+}//namespace
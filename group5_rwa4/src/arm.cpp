@@ -1,32 +1,77 @@
 #include "../include/arm/arm.h"
+#include "../include/trace/trace.h"
+#include "../include/arm/robot_models.h"
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2_ros/transform_broadcaster.h>
 #include <tf2_ros/static_transform_broadcaster.h>
 #include <geometry_msgs/TransformStamped.h>
 #include <tf2_ros/transform_listener.h>
 #include <eigen_conversions/eigen_msg.h>
+#include <ros/package.h>
 #include <moveit/move_group_interface/move_group_interface.h>
 #include <moveit/planning_interface/planning_interface.h>
 #include <moveit/planning_scene_interface/planning_scene_interface.h>
 #include <Eigen/Geometry>
 #include <tf2/convert.h>
 #include "../include/util/util.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
 #include <math.h>
 
 namespace motioncontrol {
     /////////////////////////////////////////////////////
     Arm::Arm(ros::NodeHandle& node) : node_("/ariac/kitting"),
         planning_group_("/ariac/kitting/robot_description"),
-        arm_options_("kitting_arm", planning_group_, node_),
+        arm_options_(groupOptions("kitting_arm", planning_group_, node_)),
         arm_group_(arm_options_)
     {
         ROS_INFO_STREAM("[Arm] constructor called... ");
 
     }
 
+    /////////////////////////////////////////////////////
+    /**
+     * @brief The parts of the kitting arm a Manipulator works with
+     */
+    class Arm::Adapter {
+        public:
+        explicit Adapter(Arm& arm) : arm_(arm) {}
+
+        moveit::planning_interface::MoveGroupInterface& group() { return arm_.arm_group_; }
+        Gripper& gripper() { return arm_.gripper_; }
+        const JointStateCache& jointStates() const { return arm_.joint_states_; }
+        const ros::Publisher& command() const { return arm_.arm_joint_trajectory_publisher_; }
+        const MotionProfiles& profiles() const { return arm_.profiles_; }
+        const GraspOffsets& offsets() const { return arm_.offsets_; }
+        bool moveToPose(const geometry_msgs::Pose& pose) { return arm_.moveToPose(pose); }
+        void hold(const std::string& part_type, const geometry_msgs::Pose& part)
+        {
+            arm_.held_type_ = part_type;
+            arm_.scene_.clearPart(part_type, part);
+        }
+        void attach() { arm_.attachHeldPart(); }
+        void letGo() { arm_.deactivateGripper(); }
+        bool settle() { return arm_.settle(); }
+
+        private:
+        Arm& arm_;
+    };
+
+    Manipulator<Arm::Adapter> Arm::manipulator()
+    {
+        return Manipulator<Adapter>(Adapter(*this));
+    }
+
     /////////////////////////////////////////////////////
     void Arm::init()
     {
+        // IK seeds built offline by build_ik_table, without them the arm plans from pose targets
+        std::string ik_table_file;
+        if (ros::param::get("~ik_table_kitting", ik_table_file))
+            ik_table_.load(ik_table_file);
+
         // make sure the planning group operates in the world frame
         // check the name of the end effector
         // ROS_INFO_NAMED("init", "End effector link: %s", arm_group_.getEndEffectorLink().c_str());
@@ -35,19 +80,42 @@ namespace motioncontrol {
         // publishers to directly control the joints without moveit
         arm_joint_trajectory_publisher_ =
             node_.advertise<trajectory_msgs::JointTrajectory>("/ariac/kitting/kitting_arm_controller/command", 10);
-        // joint state subscribers
+        streamer_.init(arm_group_.getRobotModel(), arm_group_.getName());
+        streamer_.addController(arm_joint_trajectory_publisher_, arm_group_.getActiveJoints());
+
+        // speeds per motion phase and part type, the built-in ones run everything at full speed
+        std::string profiles_file = ros::package::getPath("group5_rwa4") + "/config/motion_profiles.yaml";
+        ros::param::get("~motion_profiles", profiles_file);
+        profiles_.load(profiles_file);
+        // gripper heights over the parts, the same table for both robots
+        std::string offsets_file = ros::package::getPath("group5_rwa4") + "/config/grasp_offsets.yaml";
+        ros::param::get("~grasp_offsets", offsets_file);
+        offsets_.load(offsets_file);
+
+        // collision objects for the bins, conveyor, trays, briefcases and parts
+        std::string scene_file = ros::package::getPath("group5_rwa4") + "/config/planning_scene.yaml";
+        ros::param::get("~planning_scene", scene_file);
+        scene_.init("/ariac/kitting", scene_file);
+        // bin and part sizes for staging parts in the bins come from the same file
+        stager_ = std::make_shared<BinStager>();
+        stager_->load(scene_file);
+        trays_ = std::make_shared<TrayLocks>();
+        // joint state subscribers, the cache answers current state and pose queries
+        joint_states_.init(arm_group_.getRobotModel(), arm_group_.getEndEffectorLink());
         arm_joint_states_subscriber_ =
             node_.subscribe("/ariac/kitting/joint_states", 10, &Arm::arm_joint_states_callback_, this);
-        // controller state subscribers
+        // controller state subscribers, a stalled or colliding motion is stopped right away
+        monitor_.init();
+        monitor_.onFault([this](const std::string&) {
+            arm_group_.stop();
+        });
         arm_controller_state_subscriber_ = node_.subscribe(
             "/ariac/kitting/kitting_arm_controller/state", 10, &Arm::arm_controller_state_callback, this);
-        // gripper state subscriber
-        gripper_state_subscriber_ = node_.subscribe(
-            "/ariac/kitting/arm/gripper/state", 10, &Arm::gripper_state_callback, this);
-        // controller state subscribers
-        gripper_control_client_ =
-            node_.serviceClient<nist_gear::VacuumGripperControl>("/ariac/kitting/arm/gripper/control");
-        gripper_control_client_.waitForExistence();
+        // gripper state subscriber and control service
+        gripper_.init(node_, "/ariac/kitting/arm/gripper");
+        // parts on the belt, picked on the move
+        conveyor_.init(node_);
+        ros::param::get("~conveyor_lead", conveyor_lead_);
 
 
         // Preset locations
@@ -97,18 +165,21 @@ namespace motioncontrol {
         // raw pointers are frequently used to refer to the planning group for improved performance.
         // to start, we will create a pointer that references the current robot’s state.
         const moveit::core::JointModelGroup* joint_model_group =
-            arm_group_.getCurrentState()->getJointModelGroup("kitting_arm");
-        moveit::core::RobotStatePtr current_state = arm_group_.getCurrentState();
+            arm_group_.getRobotModel()->getJointModelGroup("kitting_arm");
+        moveit::core::RobotStatePtr current_state = currentState();
         // next get the current set of joint values for the group.
         current_state->copyJointGroupPositions(joint_model_group, joint_group_positions_);
     }
 
     //////////////////////////////////////////////////////
     void Arm::moveBaseTo(double linear_arm_actuator_joint_position) {
+        tracing::Span span("arm", "moveBaseTo");
+        finishPreposition();
+        span.arg("position", linear_arm_actuator_joint_position);
         // get the current joint positions
         const moveit::core::JointModelGroup* joint_model_group =
-            arm_group_.getCurrentState()->getJointModelGroup("kitting_arm");
-        moveit::core::RobotStatePtr current_state = arm_group_.getCurrentState();
+            arm_group_.getRobotModel()->getJointModelGroup("kitting_arm");
+        moveit::core::RobotStatePtr current_state = currentState();
 
         // get the current set of joint values for the group.
         current_state->copyJointGroupPositions(joint_model_group, joint_group_positions_);
@@ -121,7 +192,9 @@ namespace motioncontrol {
         arm_group_.move();
     }
     //////////////////////////////////////////////////////
-    void Arm::movePart(std::string part_type, geometry_msgs::Pose pose_in_world_frame, geometry_msgs::Pose goal_in_tray_frame, std::string agv) {
+    bool Arm::movePart(std::string part_type, geometry_msgs::Pose pose_in_world_frame, geometry_msgs::Pose goal_in_tray_frame, std::string agv) {
+        tracing::Span span("arm", "movePart");
+        span.arg("type", part_type);
         //convert goal_in_tray_frame into world frame
         // auto init_pose_in_world = motioncontrol::transformToWorldFrame(camera_frame);
         auto init_pose_in_world = pose_in_world_frame;
@@ -130,14 +203,25 @@ namespace motioncontrol {
         // auto target_pose_in_world = motioncontrol::transformtoWorldFrame(goal_in_tray_frame, agv);
         auto target_pose_in_world = motioncontrol::gettransforminWorldFrame(goal_in_tray_frame, agv);
         
-        if (pickPart(part_type, init_pose_in_world)) {
-            placePart(init_pose_in_world, goal_in_tray_frame, agv);
-        }
+        if (!pickPart(part_type, init_pose_in_world))
+            return false;
+        return placePart(init_pose_in_world, goal_in_tray_frame, agv);
+    }
+    /////////////////////////////////////////////////////
+    bool Arm::moveToPose(const geometry_msgs::Pose& pose)
+    {
+        finishPreposition();
+        std::vector<double> joints;
+        if (ik_table_.solve(*currentState(), "kitting_arm", pose, joints))
+            arm_group_.setJointValueTarget(joints);
+        else
+            arm_group_.setPoseTarget(pose);
+        return arm_group_.move() == moveit::planning_interface::MoveItErrorCode::SUCCESS;
     }
     /////////////////////////////////////////////////////
     nist_gear::VacuumGripperState Arm::getGripperState()
     {
-        return gripper_state_;
+        return gripper_.state();
     }
 
     /**
@@ -150,316 +234,256 @@ namespace motioncontrol {
      * We use the group full_gantry_group_ to allow the robot more flexibility
      */
     bool Arm::pickPart(std::string part_type, geometry_msgs::Pose part_init_pose) {
-        arm_group_.setMaxVelocityScalingFactor(1.0);
+        tracing::Span span("arm", "pickPart");
+        finishPreposition();
+        span.arg("type", part_type);
+        profiles_.select(MotionPhase::EMPTY_TRANSIT, part_type).apply(arm_group_);
         moveBaseTo(part_init_pose.position.y - 0.3);
-        ROS_INFO_STREAM("z of part: " << part_init_pose.position.z);
-        // // move the arm above the part to grasp
-        // // gripper stays at the current z
-        // // only modify its x and y based on the part to grasp
-        // // In this case we do not need to use preset locations
-        // // everything is done dynamically
-
-        // Make sure the wrist is facing down
-        // otherwise it will have a hard time attaching a part
-        geometry_msgs::Pose arm_ee_link_pose = arm_group_.getCurrentPose().pose;
-        auto flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
-        arm_ee_link_pose.orientation.x = flat_orientation.getX();
-        arm_ee_link_pose.orientation.y = flat_orientation.getY();
-        arm_ee_link_pose.orientation.z = flat_orientation.getZ();
-        arm_ee_link_pose.orientation.w = flat_orientation.getW();
-        
-        // post-grasp pose 3
-        // store the pose of the arm before it goes down to pick the part
-        // we will bring the arm back to this pose after picking up the part
-        auto postgrasp_pose3 = part_init_pose;
-        postgrasp_pose3.orientation = arm_ee_link_pose.orientation;
-        postgrasp_pose3.position.z = arm_ee_link_pose.position.z + 0.25;
-
-        // preset z depending on the part type
-        // some parts are bigger than others
-        
-        double z_pos{};
-        if (part_type.find("pump") != std::string::npos) {
-            z_pos = 0.83;
-        }
-        if (part_type.find("sensor") != std::string::npos) {
-            z_pos = 0.79;
-        }
-        if (part_type.find("regulator") != std::string::npos) {
-            z_pos = 0.80;
-        }
-        if (part_type.find("battery") != std::string::npos) {
-            z_pos = 0.78;
-        }
-        
-        // set of waypoints the arm will go through
-        std::vector<geometry_msgs::Pose> waypoints;
-        // pre-grasp pose: somewhere above the part
-        auto pregrasp_pose = part_init_pose;
-        pregrasp_pose.orientation = arm_ee_link_pose.orientation;
-        pregrasp_pose.position.z = z_pos + 0.06;
-
-        // grasp pose: right above the part
-        auto grasp_pose = part_init_pose;
-        grasp_pose.orientation = arm_ee_link_pose.orientation;
-        grasp_pose.position.z = z_pos + 0.03;
-
-        waypoints.push_back(pregrasp_pose);
-        waypoints.push_back(grasp_pose);
-
-        // activate gripper
-        // sometimes it does not activate right away
-        // so we are doing this in a loop
-        while (!gripper_state_.enabled) {
-            activateGripper();
-        }
-
-        // move the arm to the pregrasp pose
-        arm_group_.setPoseTarget(pregrasp_pose);
-        arm_group_.move();
-
-        
-        /* Cartesian motions are frequently needed to be slower for actions such as approach
-        and retreat grasp motions. Here we demonstrate how to reduce the speed and the acceleration
-        of the robot arm via a scaling factor of the maxiumum speed of each joint.
-        */
-        arm_group_.setMaxVelocityScalingFactor(0.05);
-        arm_group_.setMaxAccelerationScalingFactor(0.05);
-        // plan the cartesian motion and execute it
-        moveit_msgs::RobotTrajectory trajectory;
-        const double jump_threshold = 0.0;
-        const double eef_step = 0.01;
-        double fraction = arm_group_.computeCartesianPath(waypoints, eef_step, jump_threshold, trajectory);
-        moveit::planning_interface::MoveGroupInterface::Plan plan;
-        plan.trajectory_ = trajectory;
-        arm_group_.execute(plan);
-
-        ros::Duration(sleep(2.0));
-
-        // move the arm 1 mm down until the part is attached
-        while (!gripper_state_.attached) {
-            grasp_pose.position.z -= 0.001;
-            arm_group_.setPoseTarget(grasp_pose);
-            arm_group_.move();
-            ros::Duration(sleep(0.5));
-        }
-        
-            arm_group_.setMaxVelocityScalingFactor(1.0);
-            arm_group_.setMaxAccelerationScalingFactor(1.0);
-            ROS_INFO_STREAM("[Gripper] = object attached");
-            ros::Duration(sleep(2.0));
-            arm_group_.setPoseTarget(postgrasp_pose3);
-            arm_group_.move();
 
-            return true;
-        
+        // after the pick the arm goes back up over the part, higher than it came
+        auto postgrasp_pose3 = Manipulator<Adapter>::wristDown(part_init_pose.position);
+        postgrasp_pose3.position.z = currentPose().position.z + 0.25;
+        return manipulator().pick(part_type, part_init_pose, { postgrasp_pose3 });
     }
 
     bool Arm::pickfaulty(std::string part_type, geometry_msgs::Pose part_init_pose) {
-        arm_group_.setMaxVelocityScalingFactor(1.0);
+        tracing::Span span("arm", "pickfaulty");
+        finishPreposition();
+        span.arg("type", part_type);
+        profiles_.select(MotionPhase::EMPTY_TRANSIT, part_type).apply(arm_group_);
         moveBaseTo(part_init_pose.position.y - 0.3);
-        ROS_INFO_STREAM("z of part: " << part_init_pose.position.z);
-        // // move the arm above the part to grasp
-        // // gripper stays at the current z
-        // // only modify its x and y based on the part to grasp
-        // // In this case we do not need to use preset locations
-        // // everything is done dynamically
-
-        // Make sure the wrist is facing down
-        // otherwise it will have a hard time attaching a part
-        geometry_msgs::Pose arm_ee_link_pose = arm_group_.getCurrentPose().pose;
-        auto flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
-        arm_ee_link_pose.orientation.x = flat_orientation.getX();
-        arm_ee_link_pose.orientation.y = flat_orientation.getY();
-        arm_ee_link_pose.orientation.z = flat_orientation.getZ();
-        arm_ee_link_pose.orientation.w = flat_orientation.getW();
-        arm_group_.setMaxVelocityScalingFactor(1);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
-        // post-grasp pose 3
-        // store the pose of the arm before it goes down to pick the part
-        // we will bring the arm back to this pose after picking up the part
-        // auto postgrasp_pose3 = part_init_pose;
-        // postgrasp_pose3.orientation = arm_ee_link_pose.orientation;
-        // postgrasp_pose3.position.z += 0.05;
-
-        // preset z depending on the part type
-        // some parts are bigger than others
-        
-        double z_pos{};
-        if (part_type.find("pump") != std::string::npos) {
-            z_pos = 0.83;
-        }
-        if (part_type.find("sensor") != std::string::npos) {
-            z_pos = 0.79;
-        }
-        if (part_type.find("regulator") != std::string::npos) {
-            z_pos = 0.80;
-        }
-        if (part_type.find("battery") != std::string::npos) {
-            z_pos = 0.78;
-        }
 
-        arm_ee_link_pose.position.x = part_init_pose.position.x;
-        arm_ee_link_pose.position.y = part_init_pose.position.y;
-        arm_ee_link_pose.position.z = part_init_pose.position.z + 0.2;
-        ROS_INFO_STREAM("EE_Z " <<arm_ee_link_pose.position.z);
-        arm_group_.setMaxVelocityScalingFactor(1);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
-        ros::Duration(sleep(0.5));
-        
-        arm_ee_link_pose.position.z = arm_ee_link_pose.position.z - 0.1;
-        ROS_INFO_STREAM("EE_Z " <<arm_ee_link_pose.position.z);
-        arm_group_.setMaxVelocityScalingFactor(1);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
-        ros::Duration(sleep(0.5));
+        // well clear of the tray before the wrist swings away
+        auto hand = manipulator();
+        return hand.pick(part_type, part_init_pose, { hand.above(part_type, part_init_pose, 0.5) });
+    }
+    /////////////////////////////////////////////////////
+    bool Arm::replaceFaultyPart(std::string part_type, geometry_msgs::Pose faulty_pose, geometry_msgs::Pose spare_pose, geometry_msgs::Pose goal_in_tray_frame, std::string agv)
+    {
+        tracing::Span span("arm", "replaceFaultyPart");
+        span.arg("type", part_type);
+        if (!pickfaulty(part_type, faulty_pose))
+            return false;
 
-        // // activate gripper
-        // // sometimes it does not activate right away
-        // // so we are doing this in a loop
-        while (!gripper_state_.enabled) {
-            activateGripper();
+        // discard: keep the linear actuator where it is, only swing the wrist
+        // away from the tray as in home2, then let go
+        const moveit::core::JointModelGroup* joint_model_group =
+            arm_group_.getRobotModel()->getJointModelGroup("kitting_arm");
+        currentState()->copyJointGroupPositions(joint_model_group, joint_group_positions_);
+        auto discard = home2_.arm_preset;
+        discard.at(0) = joint_group_positions_.at(0);
+        auto to_discard = MotionSegment::joint(arm_group_, discard, profiles_.select(MotionPhase::LOADED_TRANSIT, part_type));
+        to_discard.after = [this]() { deactivateGripper(); };
+        // the rail move to the spare is planned while the wrist swings away
+        double rail_at_spare = spare_pose.position.y - 0.3;
+        MotionPipeline swap(&joint_states_);
+        swap.add(to_discard)
+            .add(MotionSegment::jointFromStart(arm_group_, [rail_at_spare](std::vector<double> joints) {
+                joints.at(0) = rail_at_spare;
+                return joints;
+            }, profiles_.select(MotionPhase::EMPTY_TRANSIT, part_type)));
+        if (!swap.run()) {
+            // the part may still hang under the gripper
+            deactivateGripper();
+            return false;
         }
 
-
-        
-        /* Cartesian motions are frequently needed to be slower for actions such as approach
-        and retreat grasp motions. Here we demonstrate how to reduce the speed and the acceleration
-        of the robot arm via a scaling factor of the maxiumum speed of each joint.
-        */
-
-        // move the arm 1 mm down until the part is attached
-        while (!gripper_state_.attached) {
-            arm_ee_link_pose.position.z = arm_ee_link_pose.position.z - 0.001;
-            ROS_INFO_STREAM("EE_Z in loop " <<arm_ee_link_pose.position.z);
-            arm_group_.setMaxVelocityScalingFactor(1);
-            arm_group_.setPoseTarget(arm_ee_link_pose);
-            arm_group_.move();
-            ros::Duration(sleep(0.5));
-        }
-            arm_ee_link_pose = arm_group_.getCurrentPose().pose;
-             arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.5;
-            arm_group_.setMaxVelocityScalingFactor(1.0);
-            // arm_group_.setMaxAccelerationScalingFactor(1.0);
-            ROS_INFO_STREAM("[Gripper] = object attached");
-            ros::Duration(sleep(2.0));
-            // geometry_msgs::Pose arm_ee_link_pose1 = arm_group_.getCurrentPose().pose;
-            // arm_ee_link_pose.position.z += 0.5;
-            arm_group_.setPoseTarget(arm_ee_link_pose);
-            arm_group_.move();
-
-            return true;
-        
+        // pick the spare from where the rail stopped, as pickPart does, and put it in the freed slot
+        auto postgrasp = Manipulator<Adapter>::wristDown(spare_pose.position);
+        postgrasp.position.z = currentPose().position.z + 0.25;
+        if (!manipulator().pick(part_type, spare_pose, { postgrasp }))
+            return false;
+        return placePart(spare_pose, goal_in_tray_frame, agv);
     }
     /////////////////////////////////////////////////////
     bool Arm::placePart(geometry_msgs::Pose part_init_pose, geometry_msgs::Pose part_pose_in_frame, std::string agv)
     {
+        tracing::Span span("arm", "placePart");
+        span.arg("agv", agv);
+        // the gantry may be finishing a flip on the same tray
+        auto tray = trays_->lock(agv);
         goToPresetLocation(agv);
         // get the target pose of the part in the world frame
         auto target_pose_in_world = motioncontrol::transformtoWorldFrame(
             part_pose_in_frame,
             agv);
 
-        // moveBaseTo(target_pose_in_world.position.y - 0.1);
-        geometry_msgs::Pose arm_ee_link_pose = arm_group_.getCurrentPose().pose;
-        auto flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
-        arm_ee_link_pose = arm_group_.getCurrentPose().pose;
-        arm_ee_link_pose.orientation.x = flat_orientation.getX();
-        arm_ee_link_pose.orientation.y = flat_orientation.getY();
-        arm_ee_link_pose.orientation.z = flat_orientation.getZ();
-        arm_ee_link_pose.orientation.w = flat_orientation.getW();
+        // above the agv at the height of the preset, then down to the tray as one trajectory
+        auto hand = manipulator();
+        auto release = hand.releasePose(part_init_pose, target_pose_in_world, GraspOffsets::site(agv));
+        auto above = Manipulator<Adapter>::wristDown(release.position);
+        above.position.z = currentPose().position.z;
+        bool placed = hand.place(held_type_, above, release);
 
-        // store the current orientation of the end effector now
-        // so we can reuse it later
-        tf2::Quaternion q_current(
-            arm_ee_link_pose.orientation.x,
-            arm_ee_link_pose.orientation.y,
-            arm_ee_link_pose.orientation.z,
-            arm_ee_link_pose.orientation.w);
-        
-        // move the arm above the agv
-        // gripper stays at the current z
-        // only modify its x and y based on the part to grasp
-        // In this case we do not need to use preset locations
-        // everything is done dynamically
-        arm_ee_link_pose.position.x = target_pose_in_world.position.x;
-        arm_ee_link_pose.position.y = target_pose_in_world.position.y;
-        // move the arm
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
+        goToPresetLocation("home2");
 
-        
+        return placed;
+    }
+    /////////////////////////////////////////////////////
+    void Arm::activateGripper()
+    {
+        gripper_.enableAsync();
+    }
+
+    /////////////////////////////////////////////////////
+    void Arm::deactivateGripper()
+    {
+        gripper_.disable();
+        scene_.detach();
+        preset_cache_.hold("");
+    }
 
+    /////////////////////////////////////////////////////
+    void Arm::updateScene(const std::vector<Product>& parts)
+    {
+        // cached preset motions were checked against the trays and parts as they were
+        if (scene_.update(parts))
+            preset_cache_.clear();
+        stager_->observe(parts);
+    }
 
-        // orientation of the part in the bin, in world frame
-        tf2::Quaternion q_init_part(
-            part_init_pose.orientation.x,
-            part_init_pose.orientation.y,
-            part_init_pose.orientation.z,
-            part_init_pose.orientation.w);
-        // orientation of the part in the tray, in world frame
-        tf2::Quaternion q_target_part(
-            target_pose_in_world.orientation.x,
-            target_pose_in_world.orientation.y,
-            target_pose_in_world.orientation.z,
-            target_pose_in_world.orientation.w);
+    /////////////////////////////////////////////////////
+    void Arm::setBinStager(const std::shared_ptr<BinStager>& stager)
+    {
+        stager_ = stager;
+    }
 
-        // relative rotation between init and target
-        tf2::Quaternion q_rot = q_target_part * q_init_part.inverse();
-        // apply this rotation to the current gripper rotation
-        tf2::Quaternion q_rslt = q_rot * q_current;
-        q_rslt.normalize();
+    /////////////////////////////////////////////////////
+    std::shared_ptr<BinStager> Arm::binStager() const
+    {
+        return stager_;
+    }
 
-        // orientation of the gripper when placing the part in the tray
-        target_pose_in_world.orientation.x = q_rslt.x();
-        target_pose_in_world.orientation.y = q_rslt.y();
-        target_pose_in_world.orientation.z = q_rslt.z();
-        target_pose_in_world.orientation.w = q_rslt.w();
-        target_pose_in_world.position.z += 0.15;
-
-        arm_group_.setMaxVelocityScalingFactor(0.1);
-        arm_group_.setPoseTarget(target_pose_in_world);
-        arm_group_.move();
-        ros::Duration(2.0).sleep();
-        deactivateGripper();
+    /////////////////////////////////////////////////////
+    void Arm::setTrayLocks(const std::shared_ptr<TrayLocks>& trays)
+    {
+        trays_ = trays;
+    }
 
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        goToPresetLocation("home2");
+    /////////////////////////////////////////////////////
+    std::shared_ptr<TrayLocks> Arm::trayLocks() const
+    {
+        return trays_;
+    }
+
+    /////////////////////////////////////////////////////
+    void Arm::attachHeldPart()
+    {
+        // top-down picks only, the held part hangs right under the gripper
+        scene_.attach(arm_group_.getEndEffectorLink(), held_type_, currentPose());
+        preset_cache_.hold(held_type_);
+    }
+
+    /////////////////////////////////////////////////////
+    bool Arm::settle()
+    {
+        return monitor_.waitSettled(ros::Time::now() + ros::Duration(2.0));
+    }
+
+    /////////////////////////////////////////////////////
+    bool Arm::prepositionBase(double linear_arm_actuator_joint_position)
+    {
+        if (gripper_.attached())
+            return false;
+        auto joints = arm_group_.getActiveJoints();
+        std::vector<double> start;
+        if (!joint_states_.positions(joints, start) || start.size() != home1_.arm_preset.size())
+            return false;
+        // in a travel posture only the base moves, nothing is in the way of the arm
+        auto travelling = [&start](const std::vector<double>& preset) {
+            for (std::size_t i{ 1 }; i < preset.size(); i++) {
+                if (std::abs(start.at(i) - preset.at(i)) > 0.1)
+                    return false;
+            }
+            return true;
+        };
+        if (!travelling(home1_.arm_preset) && !travelling(home2_.arm_preset))
+            return false;
+
+        auto goal = start;
+        goal.at(0) = linear_arm_actuator_joint_position;
+        auto base = arm_group_.getRobotModel()->getJointModel(joints.at(0));
+        if (base) {
+            auto& bounds = base->getVariableBounds().at(0);
+            goal.at(0) = std::max(bounds.min_position_, std::min(bounds.max_position_, goal.at(0)));
+        }
+        if (std::abs(goal.at(0) - start.at(0)) < 0.05)
+            return false;
 
+        trajectory_msgs::JointTrajectory trajectory;
+        std::vector<double> durations;
+        if (!streamer_.plan(start, { goal }, trajectory, durations, transitProfile()) || !streamer_.send(trajectory))
+            return false;
+        double duration{ 0.0 };
+        for (auto step : durations)
+            duration += step;
+        preposition_until_ = ros::Time::now() + ros::Duration(duration);
+        ROS_INFO_STREAM("[Arm][prepositionBase] Base from " << start.at(0) << " to " << goal.at(0)
+            << " in " << duration << " s");
         return true;
-        
     }
+
     /////////////////////////////////////////////////////
-    void Arm::gripper_state_callback(const nist_gear::VacuumGripperState::ConstPtr& gripper_state_msg)
+    void Arm::finishPreposition()
     {
-        gripper_state_ = *gripper_state_msg;
+        if (preposition_until_.isZero())
+            return;
+        tracing::Span span("arm", "finishPreposition");
+        if ((preposition_until_ - ros::Time::now()).toSec() > 0.5) {
+            // a new goal replaces the one running, the base stops where it is
+            std::vector<double> current;
+            if (joint_states_.positions(arm_group_.getActiveJoints(), current)) {
+                trajectory_msgs::JointTrajectory hold;
+                hold.joint_names = arm_group_.getActiveJoints();
+                hold.points.resize(1);
+                hold.points.at(0).positions = current;
+                hold.points.at(0).velocities.assign(current.size(), 0.0);
+                hold.points.at(0).time_from_start = ros::Duration(0.3);
+                streamer_.send(hold);
+                ROS_INFO_STREAM("[Arm][finishPreposition] Base stopped at " << current.at(0));
+            }
+        }
+        settle();
+        preposition_until_ = ros::Time();
     }
+
     /////////////////////////////////////////////////////
-    void Arm::activateGripper()
+    bool Arm::sendJointPosition(trajectory_msgs::JointTrajectory command_msg)
     {
-        nist_gear::VacuumGripperControl srv;
-        srv.request.enable = true;
-        gripper_control_client_.call(srv);
+        return streamer_.send(command_msg);
+    }
 
-        ROS_INFO_STREAM("[Arm][activateGripper] DEBUG: srv.response =" << srv.response);
+    /////////////////////////////////////////////////////
+    MotionProfile Arm::transitProfile() const
+    {
+        if (gripper_.attached())
+            return profiles_.select(MotionPhase::LOADED_TRANSIT, held_type_);
+        return profiles_.select(MotionPhase::EMPTY_TRANSIT);
     }
 
     /////////////////////////////////////////////////////
-    void Arm::deactivateGripper()
+    moveit::core::RobotStatePtr Arm::currentState()
     {
-        nist_gear::VacuumGripperControl srv;
-        srv.request.enable = false;
-        gripper_control_client_.call(srv);
+        return latestState(&joint_states_, arm_group_);
+    }
 
-        ROS_INFO_STREAM("[Arm][deactivateGripper] DEBUG: srv.response =" << srv.response);
+    /////////////////////////////////////////////////////
+    geometry_msgs::Pose Arm::currentPose()
+    {
+        geometry_msgs::Pose pose;
+        if (!joint_states_.pose(pose)) {
+            ROS_DEBUG_STREAM("[Arm][currentPose] No recent joint state, asking MoveIt");
+            pose = arm_group_.getCurrentPose().pose;
+        }
+        return pose;
     }
 
     /////////////////////////////////////////////////////
     void Arm::goToPresetLocation(std::string location_name)
     {
+        tracing::Span span("arm", "goToPresetLocation");
+        finishPreposition();
+        span.arg("location", location_name);
 
         ArmPresetLocation location;
         if (location_name.compare("home1") == 0) {
@@ -497,72 +521,31 @@ namespace motioncontrol {
         joint_group_positions_.at(5) = location.arm_preset.at(5);
         joint_group_positions_.at(6) = location.arm_preset.at(6);
 
-        arm_group_.setJointValueTarget(joint_group_positions_);
-
-        moveit::planning_interface::MoveGroupInterface::Plan my_plan;
-        // check a plan is found first then execute the action
-        bool success = (arm_group_.plan(my_plan) == moveit::planning_interface::MoveItErrorCode::SUCCESS);
-        if (success)
-            arm_group_.move();
+        // a loaded and an empty move to the same preset are cached apart
+        if (!preset_cache_.moveTo(arm_group_, joint_group_positions_, transitProfile(), &joint_states_))
+            ROS_ERROR_STREAM("[Arm][goToPresetLocation] Failed to reach " << location_name);
     }
 
-    geometry_msgs::Pose Arm::get_part_pose_in_empty_bin(int bin_number){
-        std::array<double,3> bin_origin{0,0,0};
-        geometry_msgs::Pose part_world_pose;
-        ROS_INFO_STREAM("empty_bin_place_count "<<empty_bin_place_count);
-        if (bin_number == 1){
-            bin_origin = bin1_origin_;
-        }
-        if (bin_number == 2){
-            bin_origin = bin2_origin_;
-        }
-        if (bin_number == 3){
-            bin_origin = bin3_origin_;
-        }
-        if (bin_number == 4){
-            bin_origin = bin4_origin_;
-        }
-        if (bin_number == 5){
-            bin_origin = bin5_origin_;
-        }
-        if (bin_number == 6){
-            bin_origin = bin6_origin_;
-        }
-        if (bin_number == 7){
-            bin_origin = bin7_origin_;
-        }
-        if (bin_number == 8){
-            bin_origin = bin8_origin_;
-        }
-
-        if (empty_bin_place_count == 0){
-            part_world_pose.position.x = bin_origin.at(0) + 0.20;
-            part_world_pose.position.y = bin_origin.at(1) - 0.15;
-            part_world_pose.position.z = bin_origin.at(2);
-            empty_bin_place_count++;
-        }
-        else if (empty_bin_place_count == 1){
-            part_world_pose.position.x = bin_origin.at(0) + 0.20;
-            part_world_pose.position.y = bin_origin.at(1) + 0.15;
-            part_world_pose.position.z = bin_origin.at(2);
-            empty_bin_place_count++;
-        }
-        else if (empty_bin_place_count == 2){
-            part_world_pose.position.x = bin_origin.at(0) - 0.10;
-            part_world_pose.position.y = bin_origin.at(1) + 0.15;
-            part_world_pose.position.z = bin_origin.at(2);
-            empty_bin_place_count++;
-        }
-        else if (empty_bin_place_count == 3){
-            part_world_pose.position.x = bin_origin.at(0) - 0.10;
-            part_world_pose.position.y = bin_origin.at(1) - 0.15;
-            part_world_pose.position.z = bin_origin.at(2);
+    bool Arm::get_part_pose_in_empty_bin(const std::vector<int>& bins, geometry_msgs::Pose& pose, int& bin_number)
+    {
+        StagingSlot slot;
+        if (stager_->stage(held_type_, bins, StagingRobot::KITTING, slot)) {
+            pose = slot.pose;
+            bin_number = slot.bin;
+            return true;
         }
-        return part_world_pose;
+        // still have to let go of the part somewhere
+        bin_number = bins.empty() ? 0 : bins.front();
+        stager_->center(bin_number, pose);
+        return false;
     }
 
-    std::vector<int>  Arm::pick_from_conveyor(std::vector<int> empty_bins_at_start, unsigned short int n)
+    std::vector<int>  Arm::pick_from_conveyor(std::vector<int> empty_bins_at_start, unsigned short int n,
+        const std::vector<std::string>& wanted)
     {   
+        tracing::Span span("arm", "pick_from_conveyor");
+        finishPreposition();
+        span.arg("count", n);
         std::vector<int> empty_bins;
         int bin_selected = 0;
         for(auto &bin: empty_bins_at_start){
@@ -582,49 +565,68 @@ namespace motioncontrol {
                 empty_bins.push_back(bin);
             }
         }
+        // the selected bin first, the other empty ones in reach once it is full
+        std::vector<int> staging_bins{ bin_selected };
+        for (auto& bin : empty_bins) {
+            if (bin == 1 || bin == 2 || bin == 5 || bin == 6)
+                staging_bins.push_back(bin);
+        }
         for(int i = 0 ; i < n; i++){
             double trigger_time_ = ros::Time::now().toSec();
-            
-            goToPresetLocation("on");
-            geometry_msgs::Pose arm_ee_link_pose = arm_group_.getCurrentPose().pose;
+            held_type_.clear();
+
+            // intercept a tracked part first, park on the belt only when none can be reached
+            geometry_msgs::Pose arm_ee_link_pose;
             auto side_orientation = motioncontrol::quaternionFromEuler(0, 0, 1.57);
-            while (!gripper_state_.enabled) {
-                activateGripper();
+            if (interceptFromBelt(wanted, ros::Time(trigger_time_) + ros::Duration(15))) {
+                profiles_.select(MotionPhase::LOADED_TRANSIT, held_type_).apply(arm_group_);
+                arm_ee_link_pose = currentPose();
+                arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.3;
+                moveToPose(arm_ee_link_pose);
             }
-            while (!gripper_state_.attached && ros::Time::now().toSec() - trigger_time_ < 15){
-                
+            else {
+                goToPresetLocation("on");
+                arm_ee_link_pose = currentPose();
+                gripper_.waitEnabled(ros::Time::now() + ros::Duration(2.0));
+                gripper_.waitAttached(ros::Time(trigger_time_) + ros::Duration(15));
+                ROS_INFO_STREAM("object attached"); 
+                profiles_.select(MotionPhase::LOADED_TRANSIT).apply(arm_group_);
+                // arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.009;
+                side_orientation = motioncontrol::quaternionFromEuler(0, 0, 0);
+                arm_ee_link_pose = currentPose();
+                arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.5; 
+                arm_ee_link_pose.orientation.x = side_orientation.getX();
+                arm_ee_link_pose.orientation.y = side_orientation.getY();
+                arm_ee_link_pose.orientation.z = side_orientation.getZ();
+                arm_ee_link_pose.orientation.w = side_orientation.getW();
+                arm_group_.setPoseTarget(arm_ee_link_pose);
+                arm_group_.move();
             }
-            ROS_INFO_STREAM("object attached"); 
-            // arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.009;
-            side_orientation = motioncontrol::quaternionFromEuler(0, 0, 0);
-            arm_ee_link_pose = arm_group_.getCurrentPose().pose;
-            arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.5; 
-            arm_ee_link_pose.orientation.x = side_orientation.getX();
-            arm_ee_link_pose.orientation.y = side_orientation.getY();
-            arm_ee_link_pose.orientation.z = side_orientation.getZ();
-            arm_ee_link_pose.orientation.w = side_orientation.getW();
-            arm_group_.setPoseTarget(arm_ee_link_pose);
-            arm_group_.move();
             
-            ROS_INFO_STREAM("Selected bin number "<< bin_selected);
-            geometry_msgs::Pose bin = get_part_pose_in_empty_bin(bin_selected);
+            geometry_msgs::Pose bin;
+            int bin_used = bin_selected;
+            if (!get_part_pose_in_empty_bin(staging_bins, bin, bin_used))
+                ROS_ERROR_STREAM("[Arm][pick_from_conveyor] No room left, dropping in bin " << bin_used);
+            ROS_INFO_STREAM("Selected bin number "<< bin_used);
+            // a bin that got parts is no longer empty
+            empty_bins.erase(std::remove(empty_bins.begin(), empty_bins.end(), bin_used), empty_bins.end());
             ROS_INFO_STREAM("Y_pos: "<< bin.position.y);
             side_orientation = motioncontrol::quaternionFromEuler(0, 0, 0);
             moveBaseTo(bin.position.y);
             arm_ee_link_pose.position.x = bin.position.x - 0.15;
             arm_ee_link_pose.position.y = bin.position.y;
             arm_ee_link_pose.position.z = bin.position.z + 0.5;
-            arm_group_.setMaxVelocityScalingFactor(1.0);
+            profiles_.select(MotionPhase::LOADED_TRANSIT, held_type_).apply(arm_group_);
             arm_group_.setPoseTarget(arm_ee_link_pose);
             arm_group_.move();
             arm_ee_link_pose.position.z = bin.position.z + 0.1;
-            arm_group_.setMaxVelocityScalingFactor(1.0);
+            profiles_.select(MotionPhase::PLACE, held_type_).apply(arm_group_);
             arm_group_.setPoseTarget(arm_ee_link_pose);
             arm_group_.move();
             // get the current joint positions
             const moveit::core::JointModelGroup* joint_model_group =
-                arm_group_.getCurrentState()->getJointModelGroup("kitting_arm");
-            moveit::core::RobotStatePtr current_state = arm_group_.getCurrentState();
+                arm_group_.getRobotModel()->getJointModelGroup("kitting_arm");
+            moveit::core::RobotStatePtr current_state = currentState();
 
             // get the current set of joint values for the group.
             current_state->copyJointGroupPositions(joint_model_group, joint_group_positions_);
@@ -637,15 +639,89 @@ namespace motioncontrol {
             arm_group_.move();
 
 
-            ros::Duration(2.0).sleep();
+            settle();
             deactivateGripper();
             goToPresetLocation("above");
         }
         // goToPresetLocation(bin);
         return empty_bins;
     }
+
+    /////////////////////////////////////////////////////
+    bool Arm::interceptFromBelt(const std::vector<std::string>& wanted, const ros::Time& deadline)
+    {
+        tracing::Span span("arm", "interceptFromBelt");
+        GraspOptions timing;
+        while (ros::ok() && ros::Time::now() < deadline) {
+            // the part leaving the reach of the rail first, among the ones still reachable in time
+            ros::Time contact_time = ros::Time::now() + ros::Duration(conveyor_lead_);
+            ConveyorTrack chosen;
+            double soonest{ std::numeric_limits<double>::max() };
+            for (auto& track : conveyor_.tracks()) {
+                if (!wanted.empty() && std::find(wanted.begin(), wanted.end(), track.type) == wanted.end())
+                    continue;
+                double speed = std::abs(track.velocity.y());
+                if (speed < 1e-3)
+                    continue;
+                // hover and contact must both be over the part of the belt the rail reaches
+                double y = track.predict(contact_time).position.y;
+                double hover_y = y - track.velocity.y() * timing.track_descent;
+                if (std::min(y, hover_y) < conveyor_reach_.at(0) || std::max(y, hover_y) > conveyor_reach_.at(1))
+                    continue;
+                double end = track.velocity.y() > 0.0 ? conveyor_reach_.at(1) : conveyor_reach_.at(0);
+                double left = std::abs(end - y) / speed;
+                if (left < soonest) {
+                    soonest = left;
+                    chosen = track;
+                }
+            }
+            if (soonest == std::numeric_limits<double>::max()) {
+                // no camera message at all: the belt is not watched, the caller waits on the belt instead
+                if (!conveyor_.waitForUpdate(std::min(deadline, ros::Time::now() + ros::Duration(1.0))) &&
+                    ros::Time::now() < deadline) {
+                    ROS_WARN_STREAM("[Arm][interceptFromBelt] No belt camera messages");
+                    return false;
+                }
+                continue;
+            }
+
+            held_type_ = chosen.type;
+            span.arg("type", chosen.type);
+            GraspPrimitive grasp(arm_group_, gripper_, graspOptions(profiles_, chosen.type), &joint_states_);
+            auto contact = manipulator().above(chosen.type, chosen.predict(contact_time), 0.0);
+
+            profiles_.select(MotionPhase::EMPTY_TRANSIT).apply(arm_group_);
+            activateGripper();
+            if (!moveToPose(grasp.trackingHover(contact, chosen.velocity))) {
+                ROS_WARN_STREAM("[Arm][interceptFromBelt] Could not reach the part " << chosen.id);
+                continue;
+            }
+            if (!gripper_.waitEnabled(contact_time - ros::Duration(timing.track_descent))) {
+                ROS_ERROR_STREAM("[Arm][interceptFromBelt] Gripper not enabled");
+                return false;
+            }
+            if (ros::Time::now() > contact_time - ros::Duration(timing.track_descent)) {
+                // arrived too late for this contact, aim further down the same track
+                ROS_WARN_STREAM("[Arm][interceptFromBelt] Late for part " << chosen.id << ", aiming again");
+                continue;
+            }
+            // a part the gripper went down on is not tried again
+            conveyor_.remove(chosen.id);
+            if (grasp.trackingPick(arm_joint_trajectory_publisher_, contact, chosen.velocity, contact_time)) {
+                ROS_INFO_STREAM("[Arm][interceptFromBelt] Picked " << chosen.type << " off the belt");
+                attachHeldPart();
+                return true;
+            }
+            ROS_WARN_STREAM("[Arm][interceptFromBelt] Missed " << chosen.type);
+        }
+        held_type_.clear();
+        return false;
+    }
     ///////////////////////////////
-    void Arm::flippart(Product part, std::vector<int> empty_bins, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool arm_required){
+    bool Arm::flippart(Product part, std::vector<int> empty_bins, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool arm_required){
+        tracing::Span span("arm", "flippart");
+        finishPreposition();
+        span.arg("agv", agv);
         std::string part_type = part.type;
         geometry_msgs::Pose part_pose = part.world_pose;
         ROS_INFO_STREAM("In flip");
@@ -690,12 +766,28 @@ namespace motioncontrol {
             bin_origin = bin8_origin_;
         }
         // ROS_INFO_STREAM("EMPTYBIN: "<<bin_selected);
+        if (arm_required) {
+            // room for the first drop 0.25 m towards -y, the part turned over
+            // at the slot and the gripper next to it; the gantry hands parts
+            // over at a fixed spot instead, see Gantry::movePartfrombin
+            std::vector<int> candidates{ bin_selected };
+            for (auto& bin : empty_bins) {
+                if ((bin == 1 || bin == 2 || bin == 5 || bin == 6) && bin != bin_selected)
+                    candidates.push_back(bin);
+            }
+            StagingSlot slot;
+            if (stager_->stage(part_type, candidates, StagingRobot::KITTING, slot, StagingMargin{ 0.25, 0.1 })) {
+                bin_selected = slot.bin;
+                bin_origin = { slot.pose.position.x, slot.pose.position.y, bin_origin.at(2) };
+            }
+        }
 
-        if (arm_required){
-        pickPart(part_type, part_pose);
-        }         
-        moveBaseTo(bin_origin.at(1)-0.8);
-        geometry_msgs::Pose arm_ee_link_pose = arm_group_.getCurrentPose().pose;
+        if (arm_required && !pickPart(part_type, part_pose)) {
+            ROS_ERROR_STREAM("[Arm][flippart] Could not pick " << part_type);
+            return false;
+        }
+        // every pose below is known up front, so each motion is planned while the previous one runs
+        geometry_msgs::Pose arm_ee_link_pose;
         auto flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
         arm_ee_link_pose.orientation.x = flat_orientation.getX();
         arm_ee_link_pose.orientation.y = flat_orientation.getY();
@@ -704,9 +796,7 @@ namespace motioncontrol {
         arm_ee_link_pose.position.x = bin_origin.at(0);
         arm_ee_link_pose.position.y = bin_origin.at(1)-0.25 ;
         arm_ee_link_pose.position.z = bin_origin.at(2)+0.15;
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
+        geometry_msgs::Pose above_bin = arm_ee_link_pose;
         
         tf2::Quaternion q_current(
             arm_ee_link_pose.orientation.x,
@@ -733,12 +823,21 @@ namespace motioncontrol {
         arm_ee_link_pose.orientation.y = q_rslt.y();
         arm_ee_link_pose.orientation.z = q_rslt.z();
         arm_ee_link_pose.orientation.w = q_rslt.w();
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
-        ros::Duration(2.0).sleep();
+
+        double rail_at_bin = bin_origin.at(1)-0.8;
+        // the part is held by its top until it is turned over
+        auto flip = profiles_.select(MotionPhase::FLIP, part_type);
+        MotionPipeline to_bin(&joint_states_);
+        to_bin.add(MotionSegment::jointFromStart(arm_group_, [rail_at_bin](std::vector<double> joints) {
+                joints.at(0) = rail_at_bin;
+                return joints;
+            }, flip))
+            .add(MotionSegment::poseTarget(arm_group_, above_bin, flip))
+            .add(MotionSegment::poseTarget(arm_group_, arm_ee_link_pose, flip));
+        to_bin.run();
+        settle();
         deactivateGripper();
-        ros::Duration(2.0).sleep();
+        gripper_.waitReleased(ros::Time::now() + ros::Duration(2.0));
         // moveBaseTo(bin_origin.at(1)-0.4);
         part_pose.position.x = arm_ee_link_pose.position.x;
         part_pose.position.y = arm_ee_link_pose.position.y;
@@ -747,70 +846,59 @@ namespace motioncontrol {
         part_pose.orientation.y = target_pose.getY();
         part_pose.orientation.z = target_pose.getZ();
         part_pose.orientation.w = target_pose.getW();
-        moveBaseTo(bin_origin.at(1)-0.6);
         arm_ee_link_pose.position.x = bin_origin.at(0);
         arm_ee_link_pose.position.y = bin_origin.at(1);
         arm_ee_link_pose.position.z = bin_origin.at(2) + 0.3;
         geometry_msgs::Pose Post_grasp = arm_ee_link_pose;
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
         // goToPresetLocation("flip");
         auto side_orientation = motioncontrol::quaternionFromEuler(0, 0, -1.57);
-        arm_ee_link_pose.orientation.x = side_orientation.getX();
-        arm_ee_link_pose.orientation.y = side_orientation.getY();
-        arm_ee_link_pose.orientation.z = side_orientation.getZ();
-        arm_ee_link_pose.orientation.w = side_orientation.getW();
+        geometry_msgs::Pose side_pose = arm_ee_link_pose;
+        side_pose.orientation.x = side_orientation.getX();
+        side_pose.orientation.y = side_orientation.getY();
+        side_pose.orientation.z = side_orientation.getZ();
+        side_pose.orientation.w = side_orientation.getW();
         // target_pose.position.z = bin_origin.at(2)+0.2;
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
-        
-        while (!gripper_state_.enabled) {
-            activateGripper();
-        }
-        
+        arm_ee_link_pose = side_pose;
         arm_ee_link_pose.position.x = part_pose.position.x;
         arm_ee_link_pose.position.y = part_pose.position.y+0.12 ;
         arm_ee_link_pose.position.z = part_pose.position.z;
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
+
+        double rail_at_part = bin_origin.at(1)-0.6;
+        auto empty = profiles_.select(MotionPhase::EMPTY_TRANSIT, part_type);
+        auto side = MotionSegment::poseTarget(arm_group_, side_pose, empty);
+        side.after = [this]() {
+            gripper_.waitEnabled(ros::Time::now() + ros::Duration(2.0));
+        };
+        MotionPipeline to_side(&joint_states_);
+        to_side.add(MotionSegment::jointFromStart(arm_group_, [rail_at_part](std::vector<double> joints) {
+                joints.at(0) = rail_at_part;
+                return joints;
+            }, empty))
+            .add(MotionSegment::poseTarget(arm_group_, Post_grasp, empty))
+            .add(side)
+            .add(MotionSegment::poseTarget(arm_group_, arm_ee_link_pose, profiles_.select(MotionPhase::APPROACH, part_type)));
+        to_side.run();
         
 
-        while (!gripper_state_.attached) {
-            arm_ee_link_pose.position.y -= 0.005;
-            arm_group_.setPoseTarget(arm_ee_link_pose);
-            arm_group_.move();
-            ros::Duration(sleep(0.5));
-        }
+        GraspPrimitive grasp(arm_group_, gripper_, graspOptions(profiles_, part_type), &joint_states_);
+        grasp.guardedMove(arm_joint_trajectory_publisher_, Eigen::Vector3d(0, -1, 0), 0.1);
+        arm_ee_link_pose = currentPose();
 
         arm_ee_link_pose.position.z =arm_ee_link_pose.position.z+0.15;
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
-        
+        geometry_msgs::Pose lifted = arm_ee_link_pose;
         arm_ee_link_pose.position.x = bin_origin.at(0);
         arm_ee_link_pose.position.y = bin_origin.at(1)+0.07;
-        arm_group_.setMaxVelocityScalingFactor(1.0);
-        arm_group_.setPoseTarget(arm_ee_link_pose);
-        arm_group_.move();
-        
-        const moveit::core::JointModelGroup* joint_model_group =
-            arm_group_.getCurrentState()->getJointModelGroup("kitting_arm");
-        moveit::core::RobotStatePtr current_state = arm_group_.getCurrentState();
-
-        // get the current set of joint values for the group.
-        current_state->copyJointGroupPositions(joint_model_group, joint_group_positions_);
 
-        // next, assign a value to only the linear_arm_actuator_joint
-        ROS_INFO_STREAM("wrist3 "<<joint_group_positions_.at(6));
-        joint_group_positions_.at(6) = joint_group_positions_.at(6) + M_PI;
-        // move the arm
-        ROS_INFO_STREAM("wrist3 "<<joint_group_positions_.at(6));
-        arm_group_.setJointValueTarget(joint_group_positions_);
-        arm_group_.move();
-        ros::Duration(2.0).sleep();
+        MotionPipeline turn_over(&joint_states_);
+        turn_over.add(MotionSegment::poseTarget(arm_group_, lifted, flip))
+            .add(MotionSegment::poseTarget(arm_group_, arm_ee_link_pose, flip))
+            .add(MotionSegment::jointFromStart(arm_group_, [](std::vector<double> joints) {
+                // wrist 3
+                joints.at(6) = joints.at(6) + M_PI;
+                return joints;
+            }, flip));
+        turn_over.run();
+        settle();
         deactivateGripper();
         part.world_pose.position.x = bin_origin.at(0);
         part.world_pose.position.y = bin_origin.at(1);
@@ -821,8 +909,7 @@ namespace motioncontrol {
         part.world_pose.orientation.z = final_orientation.getZ();
         part.world_pose.orientation.w = final_orientation.getW();
         goToPresetLocation("home2");
-        movePart(part_type,part.world_pose,part_pose_in_frame, agv);
-
+        return movePart(part_type,part.world_pose,part_pose_in_frame, agv);
     }
 
     ///////////////////////////
@@ -835,13 +922,13 @@ namespace motioncontrol {
         if (joint_state_msg->position.size() == 0) {
             ROS_ERROR("[Arm][arm_joint_states_callback_] joint_state_msg->position.size() == 0!");
         }
-        current_joint_states_ = *joint_state_msg;
+        joint_states_.update(*joint_state_msg);
     }
 
     /////////////////////////////////////////////////////
     void Arm::arm_controller_state_callback(const control_msgs::JointTrajectoryControllerState::ConstPtr& msg)
     {
-        arm_controller_state_ = *msg;
+        monitor_.update("kitting_arm_controller", *msg);
     }
 }//namespace
 
@@ -850,9 +937,9 @@ namespace gantry_motioncontrol {
     /////////////////////////////////////////////////////
     Gantry::Gantry(ros::NodeHandle& node) : node_("/ariac/gantry"),
         planning_group_("/ariac/gantry/robot_description"),
-        full_gantry_options_("gantry_full", planning_group_, node_),
-        arm_gantry_options_("gantry_arm", planning_group_, node_),
-        torso_gantry_options_("gantry_torso", planning_group_, node_),
+        full_gantry_options_(motioncontrol::groupOptions("gantry_full", planning_group_, node_)),
+        arm_gantry_options_(motioncontrol::groupOptions("gantry_arm", planning_group_, node_)),
+        torso_gantry_options_(motioncontrol::groupOptions("gantry_torso", planning_group_, node_)),
         full_gantry_group_(full_gantry_options_),
         arm_gantry_group_(arm_gantry_options_),
         torso_gantry_group_(torso_gantry_options_)
@@ -861,11 +948,47 @@ namespace gantry_motioncontrol {
         ROS_INFO_STREAM("[Gantry] constructor called... ");
     }
 
+    /////////////////////////////////////////////////////
+    /**
+     * @brief The parts of the gantry arm a motioncontrol::Manipulator works with
+     */
+    class Gantry::Adapter {
+        public:
+        explicit Adapter(Gantry& gantry) : gantry_(gantry) {}
+
+        moveit::planning_interface::MoveGroupInterface& group() { return gantry_.arm_gantry_group_; }
+        motioncontrol::Gripper& gripper() { return gantry_.gripper_; }
+        const motioncontrol::JointStateCache& jointStates() const { return gantry_.joint_states_; }
+        const ros::Publisher& command() const { return gantry_.gantry_arm_joint_trajectory_publisher_; }
+        const motioncontrol::MotionProfiles& profiles() const { return gantry_.profiles_; }
+        const motioncontrol::GraspOffsets& offsets() const { return gantry_.offsets_; }
+        bool moveToPose(const geometry_msgs::Pose& pose) { return gantry_.moveToPose(pose); }
+        void hold(const std::string& part_type, const geometry_msgs::Pose& part)
+        {
+            gantry_.held_type_ = part_type;
+            gantry_.scene_.clearPart(part_type, part);
+        }
+        void attach() { gantry_.attachHeldPart(); }
+        void letGo() { gantry_.deactivateGripper(); }
+        bool settle() { return gantry_.settle(); }
+
+        private:
+        Gantry& gantry_;
+    };
+
+    motioncontrol::Manipulator<Gantry::Adapter> Gantry::manipulator()
+    {
+        return motioncontrol::Manipulator<Adapter>(Adapter(*this));
+    }
+
 
 
     /////////////////////////////////////////////////////
     void Gantry::init()
     {
+        std::string ik_table_file;
+        if (ros::param::get("~ik_table_gantry", ik_table_file))
+            ik_table_.load(ik_table_file);
 
 
         // publishers to directly control the joints without moveit
@@ -873,23 +996,49 @@ namespace gantry_motioncontrol {
             node_.advertise<trajectory_msgs::JointTrajectory>("/ariac/gantry/gantry_arm_controller/command", 10);
         gantry_torso_joint_trajectory_publisher_ =
             node_.advertise<trajectory_msgs::JointTrajectory>("/ariac/gantry/gantry_controller/command", 10);
-
-        // joint state subscribers
+        // the full gantry is driven by the torso and the arm controllers together
+        streamer_.init(full_gantry_group_.getRobotModel(), "gantry_full");
+        streamer_.addController(gantry_torso_joint_trajectory_publisher_, torso_gantry_group_.getActiveJoints());
+        streamer_.addController(gantry_arm_joint_trajectory_publisher_, arm_gantry_group_.getActiveJoints());
+        // streamed moves off the preset edges are checked against the move group scene first
+        sweep_.init(node_, "gantry_full");
+        ros::param::get("~stream_presets", stream_presets_);
+
+        // speeds per motion phase and part type, the built-in ones run everything at full speed
+        std::string profiles_file = ros::package::getPath("group5_rwa4") + "/config/motion_profiles.yaml";
+        ros::param::get("~motion_profiles", profiles_file);
+        profiles_.load(profiles_file);
+        // gripper heights over the parts, the same table for both robots
+        std::string offsets_file = ros::package::getPath("group5_rwa4") + "/config/grasp_offsets.yaml";
+        ros::param::get("~grasp_offsets", offsets_file);
+        offsets_.load(offsets_file);
+
+        // collision objects for the bins, conveyor, trays, briefcases and parts
+        std::string scene_file = ros::package::getPath("group5_rwa4") + "/config/planning_scene.yaml";
+        ros::param::get("~planning_scene", scene_file);
+        scene_.init("/ariac/gantry", scene_file);
+        stager_ = std::make_shared<motioncontrol::BinStager>();
+        stager_->load(scene_file);
+        trays_ = std::make_shared<motioncontrol::TrayLocks>();
+
+        // joint state subscribers, the cache answers current state and pose queries
+        joint_states_.init(full_gantry_group_.getRobotModel(), arm_gantry_group_.getEndEffectorLink());
         gantry_full_joint_states_subscriber_ =
             node_.subscribe("/ariac/gantry/joint_states", 10, &Gantry::gantry_full_joint_states_callback_, this);
-        // gripper state subscriber
-        gantry_gripper_state_subscriber_ = node_.subscribe(
-            "/ariac/gantry/arm/gripper/state", 10, &Gantry::gantry_gripper_state_callback, this);
-        // controller state subscribers
+        // gripper state subscriber and control service
+        gripper_.init(node_, "/ariac/gantry/arm/gripper");
+        // controller state subscribers, a stalled or colliding motion is stopped right away
+        monitor_.init();
+        monitor_.onFault([this](const std::string&) {
+            full_gantry_group_.stop();
+            arm_gantry_group_.stop();
+            torso_gantry_group_.stop();
+        });
         gantry_controller_state_subscriber_ = node_.subscribe(
             "/ariac/gantry/gantry_controller/state", 10, &Gantry::gantry_controller_state_callback, this);
         gantry_arm_controller_state_subscriber_ = node_.subscribe(
             "/ariac/gantry/gantry_arm_controller/state", 10, &Gantry::gantry_arm_controller_state_callback, this);
 
-        gantry_gripper_control_client_ =
-            node_.serviceClient<nist_gear::VacuumGripperControl>("/ariac/gantry/arm/gripper/control");
-        gantry_gripper_control_client_.waitForExistence();
-
         // Preset locations
         // ^^^^^^^^^^^^^^^^
         // Joints for the gantry are in this order:
@@ -905,229 +1054,50 @@ namespace gantry_motioncontrol {
         // - gantry_arm_wrist_2
         // - gantry_arm_wrist_3
         // For the full robot = torso + arm
-
- 
-        home_.gantry_torso_preset = { -3.3, 0.0, -1.57 };
-        home_.gantry_arm_preset = {-0.01, -0.92, 1.20, -0.25, 1.54, 0.83 };
-        //concatenate gantry torso and gantry arm
-        home_.gantry_full_preset.insert(home_.gantry_full_preset.begin(), home_.gantry_torso_preset.begin(), home_.gantry_torso_preset.end());
-        home_.gantry_full_preset.insert(home_.gantry_full_preset.end(), home_.gantry_arm_preset.begin(), home_.gantry_arm_preset.end());
-        // print(home_.gantry_full);
-
-        home2_.gantry_torso_preset = { -8.3, 0.0, -1.57 };
-        home2_.gantry_arm_preset = {-0.01, -0.92, 1.20, -0.25, 1.54, 0.83 };
-        home2_.gantry_full_preset.insert(home2_.gantry_full_preset.begin(), home2_.gantry_torso_preset.begin(), home2_.gantry_torso_preset.end());
-        home2_.gantry_full_preset.insert(home2_.gantry_full_preset.end(), home2_.gantry_arm_preset.begin(), home2_.gantry_arm_preset.end());
-
-        //safe spot to reach any bin without colliding with anything
-        safe_bins_.gantry_torso_preset = { -6.90, -0.13, -0.02 };
-        safe_bins_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        safe_bins_.gantry_full_preset.insert(safe_bins_.gantry_full_preset.begin(), safe_bins_.gantry_torso_preset.begin(), safe_bins_.gantry_torso_preset.end());
-        safe_bins_.gantry_full_preset.insert(safe_bins_.gantry_full_preset.end(), safe_bins_.gantry_arm_preset.begin(), safe_bins_.gantry_arm_preset.end());
-
-        //at bins 1, 2, 3, 4
-        at_bins1234_.gantry_torso_preset = { -1.72, -2.90, -1.57 };
-        at_bins1234_.gantry_arm_preset = { -0.01, -0.92, 1.20, -0.25, 1.54, 0.83 };
-        at_bins1234_.gantry_full_preset.insert(at_bins1234_.gantry_full_preset.begin(), at_bins1234_.gantry_torso_preset.begin(), at_bins1234_.gantry_torso_preset.end());
-        at_bins1234_.gantry_full_preset.insert(at_bins1234_.gantry_full_preset.end(), at_bins1234_.gantry_arm_preset.begin(), at_bins1234_.gantry_arm_preset.end());
-        
-        //at bins 5, 6, 7, 8
-        at_bins5678_.gantry_torso_preset = { -1.72, 3.0, -1.57 };
-        at_bins5678_.gantry_arm_preset = { -0.01, -0.92, 1.20, -0.25, 1.54, 0.83 };
-        at_bins5678_.gantry_full_preset.insert(at_bins5678_.gantry_full_preset.begin(), at_bins5678_.gantry_torso_preset.begin(), at_bins5678_.gantry_torso_preset.end());
-        at_bins5678_.gantry_full_preset.insert(at_bins5678_.gantry_full_preset.end(), at_bins5678_.gantry_arm_preset.begin(), at_bins5678_.gantry_arm_preset.end());
-        
-
-        // above bin1
-        at_bin1_.gantry_torso_preset = { 0.06, -2.63, 0.0 };
-        at_bin1_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_bin1_.gantry_full_preset.insert(at_bin1_.gantry_full_preset.begin(), at_bin1_.gantry_torso_preset.begin(), at_bin1_.gantry_torso_preset.end());
-        at_bin1_.gantry_full_preset.insert(at_bin1_.gantry_full_preset.end(), at_bin1_.gantry_arm_preset.begin(), at_bin1_.gantry_arm_preset.end());
-
-        // above bin2
-        at_bin2_.gantry_torso_preset = { 0.0, -3.35, -3.14 };
-        at_bin2_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_bin2_.gantry_full_preset.insert(at_bin2_.gantry_full_preset.begin(), at_bin2_.gantry_torso_preset.begin(), at_bin2_.gantry_torso_preset.end());
-        at_bin2_.gantry_full_preset.insert(at_bin2_.gantry_full_preset.end(), at_bin2_.gantry_arm_preset.begin(), at_bin2_.gantry_arm_preset.end());
-
-        // above bin3
-        at_bin3_.gantry_torso_preset = { -0.78, -3.26, -3.14 };
-        at_bin3_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_bin3_.gantry_full_preset.insert(at_bin3_.gantry_full_preset.begin(), at_bin3_.gantry_torso_preset.begin(), at_bin3_.gantry_torso_preset.end());
-        at_bin3_.gantry_full_preset.insert(at_bin3_.gantry_full_preset.end(), at_bin3_.gantry_arm_preset.begin(), at_bin3_.gantry_arm_preset.end());
-
-        // above bin4
-        at_bin4_.gantry_torso_preset = { -0.63, -2.63, 0.0 };
-        at_bin4_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_bin4_.gantry_full_preset.insert(at_bin4_.gantry_full_preset.begin(), at_bin4_.gantry_torso_preset.begin(), at_bin4_.gantry_torso_preset.end());
-        at_bin4_.gantry_full_preset.insert(at_bin4_.gantry_full_preset.end(), at_bin4_.gantry_arm_preset.begin(), at_bin4_.gantry_arm_preset.end());
-
-        // above bin5
-        at_bin5_.gantry_torso_preset = { 0.0, 2.63, 3.14 };
-        at_bin5_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_bin5_.gantry_full_preset.insert(at_bin5_.gantry_full_preset.begin(), at_bin5_.gantry_torso_preset.begin(), at_bin5_.gantry_torso_preset.end());
-        at_bin5_.gantry_full_preset.insert(at_bin5_.gantry_full_preset.end(), at_bin5_.gantry_arm_preset.begin(), at_bin5_.gantry_arm_preset.end());
-
-        // above bin6
-        at_bin6_.gantry_torso_preset = { 0.06, 3.36, 0.0 };
-        at_bin6_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_bin6_.gantry_full_preset.insert(at_bin6_.gantry_full_preset.begin(), at_bin6_.gantry_torso_preset.begin(), at_bin6_.gantry_torso_preset.end());
-        at_bin6_.gantry_full_preset.insert(at_bin6_.gantry_full_preset.end(), at_bin6_.gantry_arm_preset.begin(), at_bin6_.gantry_arm_preset.end());
-
-        // above bin7
-        at_bin7_.gantry_torso_preset = { -0.63, 3.36, 0.0 };
-        at_bin7_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_bin7_.gantry_full_preset.insert(at_bin7_.gantry_full_preset.begin(), at_bin7_.gantry_torso_preset.begin(), at_bin7_.gantry_torso_preset.end());
-        at_bin7_.gantry_full_preset.insert(at_bin7_.gantry_full_preset.end(), at_bin7_.gantry_arm_preset.begin(), at_bin7_.gantry_arm_preset.end());
-
-        // above bin8
-        at_bin8_.gantry_torso_preset = { -0.78, 2.72, 3.14 };
-        at_bin8_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_bin8_.gantry_full_preset.insert(at_bin8_.gantry_full_preset.begin(), at_bin8_.gantry_torso_preset.begin(), at_bin8_.gantry_torso_preset.end());
-        at_bin8_.gantry_full_preset.insert(at_bin8_.gantry_full_preset.end(), at_bin8_.gantry_arm_preset.begin(), at_bin8_.gantry_arm_preset.end());
-
-
-
-        // above agv3_as3
-        at_agv3_as3_.gantry_torso_preset = { -2.70, 1.40, 1.19 };
-        at_agv3_as3_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_agv3_as3_.gantry_full_preset.insert(at_agv3_as3_.gantry_full_preset.begin(), at_agv3_as3_.gantry_torso_preset.begin(), at_agv3_as3_.gantry_torso_preset.end());
-        at_agv3_as3_.gantry_full_preset.insert(at_agv3_as3_.gantry_full_preset.end(), at_agv3_as3_.gantry_arm_preset.begin(), at_agv3_as3_.gantry_arm_preset.end());
-
-        // above agv4_as3
-        at_agv4_as3_.gantry_torso_preset = { -3.70, 3.99, 3.14 };
-        at_agv4_as3_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_agv4_as3_.gantry_full_preset.insert(at_agv4_as3_.gantry_full_preset.begin(), at_agv4_as3_.gantry_torso_preset.begin(), at_agv4_as3_.gantry_torso_preset.end());
-        at_agv4_as3_.gantry_full_preset.insert(at_agv4_as3_.gantry_full_preset.end(), at_agv4_as3_.gantry_arm_preset.begin(), at_agv4_as3_.gantry_arm_preset.end());
-
-        // above near_as3
-        near_as3_.gantry_torso_preset = { -2.85, 2.68, 3.14 };
-        near_as3_.gantry_arm_preset = { 0 , -1.65 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        near_as3_.gantry_full_preset.insert(near_as3_.gantry_full_preset.begin(), near_as3_.gantry_torso_preset.begin(), near_as3_.gantry_torso_preset.end());
-        near_as3_.gantry_full_preset.insert(near_as3_.gantry_full_preset.end(), near_as3_.gantry_arm_preset.begin(), near_as3_.gantry_arm_preset.end());
-
-        // above as3
-        at_as3_.gantry_torso_preset = { -3.87, 2.82, 1.44 };
-        at_as3_.gantry_arm_preset = { 0 , -1.88 , 1.50 ,0.38 ,1.55 ,0.83 };
-        at_as3_.gantry_full_preset.insert(at_as3_.gantry_full_preset.begin(), at_as3_.gantry_torso_preset.begin(), at_as3_.gantry_torso_preset.end());
-        at_as3_.gantry_full_preset.insert(at_as3_.gantry_full_preset.end(), at_as3_.gantry_arm_preset.begin(), at_as3_.gantry_arm_preset.end());
-
-
-        // above agv1_as1
-        at_agv1_as1_.gantry_torso_preset = { -2.70, -4.5, 1.19 };
-        at_agv1_as1_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_agv1_as1_.gantry_full_preset.insert(at_agv1_as1_.gantry_full_preset.begin(), at_agv1_as1_.gantry_torso_preset.begin(), at_agv1_as1_.gantry_torso_preset.end());
-        at_agv1_as1_.gantry_full_preset.insert(at_agv1_as1_.gantry_full_preset.end(), at_agv1_as1_.gantry_arm_preset.begin(), at_agv1_as1_.gantry_arm_preset.end());
-
-        // above agv2_as1
-        at_agv2_as1_.gantry_torso_preset = { -3.7, -2.13, 3.14 };
-        at_agv2_as1_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_agv2_as1_.gantry_full_preset.insert(at_agv2_as1_.gantry_full_preset.begin(), at_agv2_as1_.gantry_torso_preset.begin(), at_agv2_as1_.gantry_torso_preset.end());
-        at_agv2_as1_.gantry_full_preset.insert(at_agv2_as1_.gantry_full_preset.end(), at_agv2_as1_.gantry_arm_preset.begin(), at_agv2_as1_.gantry_arm_preset.end());
-
-        // above near_as1
-        near_as1_.gantry_torso_preset = { -2.5, -3.21, 3.14 };
-        near_as1_.gantry_arm_preset = { 0 , -1.65 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        near_as1_.gantry_full_preset.insert(near_as1_.gantry_full_preset.begin(), near_as1_.gantry_torso_preset.begin(), near_as1_.gantry_torso_preset.end());
-        near_as1_.gantry_full_preset.insert(near_as1_.gantry_full_preset.end(), near_as1_.gantry_arm_preset.begin(), near_as1_.gantry_arm_preset.end());
-
-        // above as1
-        at_as1_.gantry_torso_preset = { -3.87, -3.07, 1.44 };
-        at_as1_.gantry_arm_preset = { 0 , -1.88 , 1.50 ,0.38 ,1.55 ,0.83 };
-        at_as1_.gantry_full_preset.insert(at_as1_.gantry_full_preset.begin(), at_as1_.gantry_torso_preset.begin(), at_as1_.gantry_torso_preset.end());
-        at_as1_.gantry_full_preset.insert(at_as1_.gantry_full_preset.end(), at_as1_.gantry_arm_preset.begin(), at_as1_.gantry_arm_preset.end());
-
-
-        // above agv1_as2
-        at_agv1_as2_.gantry_torso_preset = { -7.75, -4.5, 1.19 };
-        at_agv1_as2_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_agv1_as2_.gantry_full_preset.insert(at_agv1_as2_.gantry_full_preset.begin(), at_agv1_as2_.gantry_torso_preset.begin(), at_agv1_as2_.gantry_torso_preset.end());
-        at_agv1_as2_.gantry_full_preset.insert(at_agv1_as2_.gantry_full_preset.end(), at_agv1_as2_.gantry_arm_preset.begin(), at_agv1_as2_.gantry_arm_preset.end());
-
-        // above agv2_as2
-        at_agv2_as2_.gantry_torso_preset = { -8.7, -2.13, 3.14 };
-        at_agv2_as2_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_agv2_as2_.gantry_full_preset.insert(at_agv2_as2_.gantry_full_preset.begin(), at_agv2_as2_.gantry_torso_preset.begin(), at_agv2_as2_.gantry_torso_preset.end());
-        at_agv2_as2_.gantry_full_preset.insert(at_agv2_as2_.gantry_full_preset.end(), at_agv2_as2_.gantry_arm_preset.begin(), at_agv2_as2_.gantry_arm_preset.end());
-
-        // above near_as2
-        near_as2_.gantry_torso_preset = { -7.5, -3.21, 3.14 };
-        near_as2_.gantry_arm_preset = { 0 , -1.65 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        near_as2_.gantry_full_preset.insert(near_as2_.gantry_full_preset.begin(), near_as2_.gantry_torso_preset.begin(), near_as2_.gantry_torso_preset.end());
-        near_as2_.gantry_full_preset.insert(near_as2_.gantry_full_preset.end(), near_as2_.gantry_arm_preset.begin(), near_as2_.gantry_arm_preset.end());
-
-        // above as2
-        at_as2_.gantry_torso_preset = { -8.87, -3.07, 1.44 };
-        at_as2_.gantry_arm_preset = { 0 , -1.88 , 1.50 ,0.38 ,1.55 ,0.83 };
-        at_as2_.gantry_full_preset.insert(at_as2_.gantry_full_preset.begin(), at_as2_.gantry_torso_preset.begin(), at_as2_.gantry_torso_preset.end());
-        at_as2_.gantry_full_preset.insert(at_as2_.gantry_full_preset.end(), at_as2_.gantry_arm_preset.begin(), at_as2_.gantry_arm_preset.end());
-
-        // above agv3_as4
-        at_agv3_as4_.gantry_torso_preset = {  -7.75, 1.40, 1.19 };
-        at_agv3_as4_.gantry_arm_preset = { 0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_agv3_as4_.gantry_full_preset.insert(at_agv3_as4_.gantry_full_preset.begin(), at_agv3_as4_.gantry_torso_preset.begin(), at_agv3_as4_.gantry_torso_preset.end());
-        at_agv3_as4_.gantry_full_preset.insert(at_agv3_as4_.gantry_full_preset.end(), at_agv3_as4_.gantry_arm_preset.begin(), at_agv3_as4_.gantry_arm_preset.end());
-
-        // above agv4_as4
-        at_agv4_as4_.gantry_torso_preset = { -8.70, 3.99, 3.14 };
-        at_agv4_as4_.gantry_arm_preset = {  0 , -1.13 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        at_agv4_as4_.gantry_full_preset.insert(at_agv4_as4_.gantry_full_preset.begin(), at_agv4_as4_.gantry_torso_preset.begin(), at_agv4_as4_.gantry_torso_preset.end());
-        at_agv4_as4_.gantry_full_preset.insert(at_agv4_as4_.gantry_full_preset.end(), at_agv4_as4_.gantry_arm_preset.begin(), at_agv4_as4_.gantry_arm_preset.end());
-
-        // above near_as4
-        near_as4_.gantry_torso_preset = { -7.85, 2.68, 3.14 };
-        near_as4_.gantry_arm_preset = {  0 , -1.65 , 1.88 ,-0.72 ,1.55 ,0.83 };
-        near_as4_.gantry_full_preset.insert(near_as4_.gantry_full_preset.begin(), near_as4_.gantry_torso_preset.begin(), near_as4_.gantry_torso_preset.end());
-        near_as4_.gantry_full_preset.insert(near_as4_.gantry_full_preset.end(), near_as4_.gantry_arm_preset.begin(), near_as4_.gantry_arm_preset.end());
-
-        // above as4
-        at_as4_.gantry_torso_preset = { -8.87, 2.82, 1.44 };
-        at_as4_.gantry_arm_preset = { 0 , -1.88 , 1.50 ,0.38 ,1.55 ,0.83 };
-        at_as4_.gantry_full_preset.insert(at_as4_.gantry_full_preset.begin(), at_as4_.gantry_torso_preset.begin(), at_as4_.gantry_torso_preset.end());
-        at_as4_.gantry_full_preset.insert(at_as4_.gantry_full_preset.end(), at_as4_.gantry_arm_preset.begin(), at_as4_.gantry_arm_preset.end());
-
-
-        // above agv1
-        //small_long_joint. torso_rail_joint, torso_base_main_joint
-        at_agv1_.gantry_torso_preset = { -0.37, -3.78, -0.69 };
-        at_agv1_.gantry_arm_preset = { -0.01, -1.17, 1.20, -0.01, 1.54, 0.83 };
-        at_agv1_.gantry_full_preset.insert(at_agv1_.gantry_full_preset.begin(), at_agv1_.gantry_torso_preset.begin(), at_agv1_.gantry_torso_preset.end());
-        at_agv1_.gantry_full_preset.insert(at_agv1_.gantry_full_preset.end(), at_agv1_.gantry_arm_preset.begin(), at_agv1_.gantry_arm_preset.end());
-
-        // above agv2
-        //small_long_joint. torso_rail_joint, torso_base_main_joint
-        at_agv2_.gantry_torso_preset = { -0.22, -2.16, -3.14 };
-        at_agv2_.gantry_arm_preset = { -0.01, -1.17, 1.20, -0.01, 1.54, 0.83 };
-        at_agv2_.gantry_full_preset.insert(at_agv2_.gantry_full_preset.begin(), at_agv2_.gantry_torso_preset.begin(), at_agv2_.gantry_torso_preset.end());
-        at_agv2_.gantry_full_preset.insert(at_agv2_.gantry_full_preset.end(), at_agv2_.gantry_arm_preset.begin(), at_agv2_.gantry_arm_preset.end());
-
-        // above agv3
-        //small_long_joint. torso_rail_joint, torso_base_main_joint
-        at_agv3_.gantry_torso_preset = { -0.37, 2.10, -0.69 };
-        at_agv3_.gantry_arm_preset = { -0.01, -1.17, 1.20, -0.01, 1.54, 0.83 };
-        at_agv3_.gantry_full_preset.insert(at_agv3_.gantry_full_preset.begin(), at_agv3_.gantry_torso_preset.begin(), at_agv3_.gantry_torso_preset.end());
-        at_agv3_.gantry_full_preset.insert(at_agv3_.gantry_full_preset.end(), at_agv3_.gantry_arm_preset.begin(), at_agv3_.gantry_arm_preset.end());
-
-        // above agv4
-        //small_long_joint. torso_rail_joint, torso_base_main_joint
-        at_agv4_.gantry_torso_preset = { -0.22, 3.67, -3.14 };
-        at_agv4_.gantry_arm_preset = { -0.01, -1.17, 1.20, -0.01, 1.54, 0.83 };
-        at_agv4_.gantry_full_preset.insert(at_agv4_.gantry_full_preset.begin(), at_agv4_.gantry_torso_preset.begin(), at_agv4_.gantry_torso_preset.end());
-        at_agv4_.gantry_full_preset.insert(at_agv4_.gantry_full_preset.end(), at_agv4_.gantry_arm_preset.begin(), at_agv4_.gantry_arm_preset.end());
+        std::string presets_file = ros::package::getPath("group5_rwa4") + "/config/gantry_presets.yaml";
+        ros::param::get("~gantry_presets", presets_file);
+        if (!presets_.load(presets_file)) {
+            ROS_FATAL_STREAM("[Gantry][init] Cannot move the gantry without " << presets_file);
+            ros::shutdown();
+            return;
+        }
+
+        const std::map<std::string, GantryPresetLocation*> locations{
+            { "home", &home_ }, { "home2", &home2_ }, { "safe_bins", &safe_bins_ },
+            { "at_bins1234", &at_bins1234_ }, { "at_bins5678", &at_bins5678_ },
+            { "at_bin1", &at_bin1_ }, { "at_bin2", &at_bin2_ }, { "at_bin3", &at_bin3_ }, { "at_bin4", &at_bin4_ },
+            { "at_bin5", &at_bin5_ }, { "at_bin6", &at_bin6_ }, { "at_bin7", &at_bin7_ }, { "at_bin8", &at_bin8_ },
+            { "at_agv1", &at_agv1_ }, { "at_agv2", &at_agv2_ }, { "at_agv3", &at_agv3_ }, { "at_agv4", &at_agv4_ },
+            { "at_agv1_as1", &at_agv1_as1_ }, { "at_agv2_as1", &at_agv2_as1_ }, { "near_as1", &near_as1_ }, { "at_as1", &at_as1_ },
+            { "at_agv1_as2", &at_agv1_as2_ }, { "at_agv2_as2", &at_agv2_as2_ }, { "near_as2", &near_as2_ }, { "at_as2", &at_as2_ },
+            { "at_agv3_as3", &at_agv3_as3_ }, { "at_agv4_as3", &at_agv4_as3_ }, { "near_as3", &near_as3_ }, { "at_as3", &at_as3_ },
+            { "at_agv3_as4", &at_agv3_as4_ }, { "at_agv4_as4", &at_agv4_as4_ }, { "near_as4", &near_as4_ }, { "at_as4", &at_as4_ }
+        };
+        for (auto& location : locations) {
+            if (!presets_.has(location.first)) {
+                ROS_ERROR_STREAM("[Gantry][init] " << presets_file << " has no preset " << location.first);
+                continue;
+            }
+            auto& preset = presets_.preset(location.first);
+            location.second->name = location.first;
+            location.second->gantry_torso_preset = preset.torso;
+            location.second->gantry_arm_preset = preset.arm;
+            location.second->gantry_full_preset = preset.full();
+        }
 
 
         // raw pointers are frequently used to refer to the planning group for improved performance.
         // to start, we will create a pointer that references the current robot’s state.
         const moveit::core::JointModelGroup* joint_model_group =
-            full_gantry_group_.getCurrentState()->getJointModelGroup("gantry_full");
-        moveit::core::RobotStatePtr current_state = full_gantry_group_.getCurrentState();
+            full_gantry_group_.getRobotModel()->getJointModelGroup("gantry_full");
+        moveit::core::RobotStatePtr current_state = currentState();
         // next get the current set of joint values for the group.
         current_state->copyJointGroupPositions(joint_model_group, joint_group_positions_);
 
 
         const moveit::core::JointModelGroup* joint_arm_group =
-            arm_gantry_group_.getCurrentState()->getJointModelGroup("gantry_arm");
-        moveit::core::RobotStatePtr current_state_arm = arm_gantry_group_.getCurrentState();
+            arm_gantry_group_.getRobotModel()->getJointModelGroup("gantry_arm");
+        moveit::core::RobotStatePtr current_state_arm = currentState();
         current_state_arm->copyJointGroupPositions(joint_arm_group, joint_arm_positions_);
     }
 
@@ -1141,427 +1111,96 @@ namespace gantry_motioncontrol {
      *
      * We use the group full_gantry_group_ to allow the robot more flexibility
      */
-    bool Gantry::pickPart(geometry_msgs::Pose part_init_pose_in_world)
+    bool Gantry::pickPart(geometry_msgs::Pose part_init_pose_in_world, const std::string& part_type)
     {
-        ros::Duration(0.5).sleep();
-        activateGripper();
-        const double GRIPPER_HEIGHT = 0.01;
-        const double EPSILON = 0.008; // for the gripper to firmly touch
-        ros::Duration(0.5).sleep();
-
-        // pose of the end effector in the world frame
-        geometry_msgs::Pose gantry_ee_link_pose = arm_gantry_group_.getCurrentPose().pose;
-
-
-        auto flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
-        
-        gantry_ee_link_pose.orientation.x = flat_orientation.getX();
-        gantry_ee_link_pose.orientation.y = flat_orientation.getY();
-        gantry_ee_link_pose.orientation.z = flat_orientation.getZ();
-        gantry_ee_link_pose.orientation.w = flat_orientation.getW();
-
-        tf2::Quaternion  gantry_ee_link_orientation(
-            gantry_ee_link_pose.orientation.x,
-            gantry_ee_link_pose.orientation.y,
-            gantry_ee_link_pose.orientation.z,
-            gantry_ee_link_pose.orientation.w
-        );
-
-     
-
-        // pose to go to after grasping a part (lift the arm a little bit)
-        geometry_msgs::Pose postGraspPose;
-
-        part_init_pose_in_world.position.z = part_init_pose_in_world.position.z + 0.08;
-        part_init_pose_in_world.orientation.x = gantry_ee_link_pose.orientation.x;
-        part_init_pose_in_world.orientation.y = gantry_ee_link_pose.orientation.y;
-        part_init_pose_in_world.orientation.z = gantry_ee_link_pose.orientation.z;
-        part_init_pose_in_world.orientation.w = gantry_ee_link_pose.orientation.w;
-
-        // activate gripper
-        ros::Duration(3).sleep();
-        activateGripper();
-        auto state = getGripperState();
-
-
-        while (!state.enabled) {
-            activateGripper();
-            state = getGripperState();
-        }
-
-        if (!state.enabled) {
-            ROS_FATAL_STREAM("[Gripper] = Could not enable gripper...shutting down");
-            ros::shutdown();
-        }
-
-        if (state.enabled) {
-            ROS_INFO_STREAM("[Gripper] = enabled");
-            //--Move arm to part
-            arm_gantry_group_.setPoseTarget(part_init_pose_in_world);
-            arm_gantry_group_.move();
-
-            state = getGripperState();
-            // move the arm closer until the object is attached
-            while (!state.attached) {
-                part_init_pose_in_world.position.z = part_init_pose_in_world.position.z - 0.0005;
-                arm_gantry_group_.setPoseTarget(part_init_pose_in_world);
-                arm_gantry_group_.move();
-                arm_gantry_group_.setPoseTarget(gantry_ee_link_pose);
-                state = getGripperState();
-            }
-
-            ROS_INFO_STREAM("[Gripper] = object attached");
-            // ros::Duration(1.0).sleep();
-            postGraspPose = arm_gantry_group_.getCurrentPose().pose;
-            postGraspPose.position.z = postGraspPose.position.z + 0.2;
-            //--Move arm to previous position
-            arm_gantry_group_.setPoseTarget(postGraspPose);
-            arm_gantry_group_.move();
-            ros::Duration(2.0).sleep();
-            arm_gantry_group_.setPoseTarget(gantry_ee_link_pose);
-            arm_gantry_group_.move();
-            return true;
-        }
-        return false;
+        tracing::Span span("gantry", "pickPart");
+        // the gripper comes back where it is now, wrist down
+        auto rest = motioncontrol::Manipulator<Adapter>::wristDown(currentPose().position);
+        return graspFromAbove(part_type, part_init_pose_in_world, 0.2, rest);
     }
 
 
     /////////////////////////////////////////////////////
     bool Gantry::placePart(geometry_msgs::Pose part_init_pose_in_world, geometry_msgs::Pose target_pose_in_frame, std::string location)
     {
-
-        ROS_INFO_STREAM("arm: " << arm_gantry_group_.getCurrentPose().pose.orientation);
-        ROS_INFO_STREAM("full: " << full_gantry_group_.getCurrentPose().pose.orientation);
+        tracing::Span span("gantry", "placePart");
+        span.arg("location", location);
 
         // get the target pose of the part in the world frame
         auto target_in_world_frame = motioncontrol::transformtoWorldFrame(
             target_pose_in_frame,
             location);
 
-        if (location == "agv1") {
-            goToPresetLocation(home_);
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_agv1_);
-        }
-        if (location == "agv2") {
-            goToPresetLocation(home_);
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_agv2_);
-        }
-        if (location == "agv3") {
-            goToPresetLocation(home_);
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_agv3_);
-        }
-        if (location == "agv4") {
-            goToPresetLocation(home_);
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_agv4_);
-        }
-        if (location == "as1") {
-            goToPresetLocation(at_as1_);
-        }
-        if (location == "as2") {
-            goToPresetLocation(at_as2_);
-        }
-        if (location == "as3") {
-            goToPresetLocation(at_as3_);
-        }
-        if (location == "as4") {
-            goToPresetLocation(at_as4_);
-        }
+        auto tray = trays_->lock(location);
+        if (!goToLocation("at_" + location))
+            ROS_ERROR_STREAM("[Gantry][placePart] Failed to reach " << location);
 
         ROS_INFO("Target World Position: %f, %f, %f",
             target_in_world_frame.position.x,
             target_in_world_frame.position.y,
             target_in_world_frame.position.z);
 
-        ROS_INFO("Target World Orientation: %f, %f, %f, %f",
-            target_in_world_frame.orientation.x,
-            target_in_world_frame.orientation.y,
-            target_in_world_frame.orientation.z,
-            target_in_world_frame.orientation.w);
-
-        auto ee_pose = arm_gantry_group_.getCurrentPose().pose;
-
-        tf2::Quaternion q_current(
-            ee_pose.orientation.x,
-            ee_pose.orientation.y,
-            ee_pose.orientation.z,
-            ee_pose.orientation.w);
-
-        // orientation of the part in the bin, in world frame
-        tf2::Quaternion q_init_part(
-            part_init_pose_in_world.orientation.x,
-            part_init_pose_in_world.orientation.y,
-            part_init_pose_in_world.orientation.z,
-            part_init_pose_in_world.orientation.w);
-        // orientation of the part in the tray, in world frame
-        tf2::Quaternion q_target_part(
-            target_in_world_frame.orientation.x,
-            target_in_world_frame.orientation.y,
-            target_in_world_frame.orientation.z,
-            target_in_world_frame.orientation.w);
-
-        // relative rotation between init and target
-        tf2::Quaternion q_rot = q_target_part * q_init_part.inverse();
-        // apply this rotation to the current gripper rotation
-        tf2::Quaternion q_rslt = q_rot * q_current;
-        q_rslt.normalize();
-
-        // orientation of the gripper when placing the part in the tray
-        target_in_world_frame.orientation.x = q_rslt.x();
-        target_in_world_frame.orientation.y = q_rslt.y();
-        target_in_world_frame.orientation.z = q_rslt.z();
-        target_in_world_frame.orientation.w = q_rslt.w();
-        target_in_world_frame.position.z += 0.17;
-
-        //allow replanning if it fails
-
-        arm_gantry_group_.setPoseTarget(target_in_world_frame);
-        arm_gantry_group_.move();
-        ros::Duration(2.0).sleep();
-        deactivateGripper();
-        auto state = getGripperState();
-        if (state.attached)
-            return true;
-        else
-            return false;
+        // down from the height of the preset to the release pose
+        auto hand = manipulator();
+        auto release = hand.releasePose(part_init_pose_in_world, target_in_world_frame,
+            motioncontrol::GraspOffsets::site(location));
+        auto above = motioncontrol::Manipulator<Adapter>::wristDown(release.position);
+        above.position.z = currentPose().position.z;
         // TODO: check the part was actually placed in the correct pose in the agv
         // and that it is not faulty
+        bool placed = hand.place(held_type_, above, release);
+
+        // clear of the agv or of the station before the tray is given up
+        goToLocation(location.find("agv") == 0 ? "home" : "near_" + location);
+        return placed;
     }
 
 
     bool Gantry::movePart(geometry_msgs::Pose part_init_pose_in_world, geometry_msgs::Pose target_pose_in_frame, std::string location, std::string type){
+        tracing::Span span("gantry", "movePart");
+        span.arg("type", type);
 
         ROS_INFO_STREAM("in gantry movePart");
-           
-        // orientation of the part in the bin, in world frame
-        tf2::Quaternion q_init_part(
-            part_init_pose_in_world.orientation.x,
-            part_init_pose_in_world.orientation.y,
-            part_init_pose_in_world.orientation.z,
-            part_init_pose_in_world.orientation.w);
 
         // get the target pose of the part in the world frame
         auto target_in_world_frame = motioncontrol::transformtoWorldFrame(
             target_pose_in_frame,
             location);
 
-        // orientation of the part in the tray, in world frame
-        tf2::Quaternion q_target_part(
-            target_in_world_frame.orientation.x,
-            target_in_world_frame.orientation.y,
-            target_in_world_frame.orientation.z,
-            target_in_world_frame.orientation.w);
-
-        // relative rotation between init and target
-        tf2::Quaternion q_rot = q_target_part * q_init_part.inverse();
-        // apply this rotation to the current gripper rotation
-        
-        // pose of the end effector in the world frame
-        geometry_msgs::Pose gantry_ee_link_pose = arm_gantry_group_.getCurrentPose().pose;
-        
-        auto flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
-        
-        gantry_ee_link_pose.orientation.x = flat_orientation.getX();
-        gantry_ee_link_pose.orientation.y = flat_orientation.getY();
-        gantry_ee_link_pose.orientation.z = flat_orientation.getZ();
-        gantry_ee_link_pose.orientation.w = flat_orientation.getW();
-        
-        double z_add {0.07};
-
-        if (type.find("pump") != std::string::npos){
-            z_add = 0.08;
-        }
-        if (type.find("battery") != std::string::npos){
-            z_add = 0.06;
-        }
-        
-    
-        part_init_pose_in_world.orientation = gantry_ee_link_pose.orientation;
-        part_init_pose_in_world.position.z = part_init_pose_in_world.position.z + z_add;
-        // pose to go to after grasping a part (lift the arm a little bit)
-        geometry_msgs::Pose postGraspPose;
-        
-
-        // activate gripper
-        ros::Duration(0.5).sleep();
-        activateGripper();
-        auto state = getGripperState();
-
-
-        while (!state.enabled) {
-            activateGripper();
-            state = getGripperState();
-        }
-
-        if (!state.enabled) {
-            ROS_FATAL_STREAM("[Gripper] = Could not enable gripper...shutting down");
-            ros::shutdown();
-        }
-
-        if (state.enabled) {
-            ROS_INFO_STREAM("[Gripper] = enabled");
-            //--Move arm to part
-            arm_gantry_group_.setPoseTarget(part_init_pose_in_world);
-            arm_gantry_group_.move();
-
-            state = getGripperState();
-            // move the arm closer until the object is attached
-            while (!state.attached) {
-                part_init_pose_in_world.position.z = part_init_pose_in_world.position.z - 0.0005;
-                arm_gantry_group_.setPoseTarget(part_init_pose_in_world);
-                arm_gantry_group_.move();
-                arm_gantry_group_.setPoseTarget(gantry_ee_link_pose);
-                state = getGripperState();
-            }
-
-            ROS_INFO_STREAM("[Gripper] = object attached");
-            // ros::Duration(1.0).sleep();
-            postGraspPose = arm_gantry_group_.getCurrentPose().pose;
-            postGraspPose.position.z = postGraspPose.position.z + 0.2;
-            //--Move arm to previous position
-            arm_gantry_group_.setPoseTarget(postGraspPose);
-            arm_gantry_group_.move();
-            ros::Duration(2.0).sleep();
-            arm_gantry_group_.setPoseTarget(gantry_ee_link_pose);
-            arm_gantry_group_.move();
-        }
-
-        double z_t{0.0};
-
-        if (location == "agv1") {
-            goToPresetLocation(home_);
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_agv1_);
-            z_t = 0.18;
-        }
-        if (location == "agv2") {
-            goToPresetLocation(home_);
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_agv2_);
-            z_t = 0.18;
-
-        }
-        if (location == "agv3") {
-            goToPresetLocation(home_);
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_agv3_);
-            z_t = 0.18;
-
-        }
-        if (location == "agv4") {
-            goToPresetLocation(home_);
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_agv4_);
-            z_t = 0.18;
-
-        }
-        if (location == "as1") {
-            goToPresetLocation(near_as1_);
-            goToPresetLocation(at_as1_);
-            z_t = 0.05;
-
-        }
-        if (location == "as2") {
-            goToPresetLocation(near_as2_);
-            goToPresetLocation(at_as2_);
-            z_t = 0.05;
-
-        }
-        if (location == "as3") {
-            goToPresetLocation(near_as3_);
-            goToPresetLocation(at_as3_);
-            z_t = 0.05;
-
-        }
-        if (location == "as4") {
-            goToPresetLocation(near_as4_);
-            goToPresetLocation(at_as4_);
-            z_t = 0.05;
-
-        }
-
-
-        tf2::Quaternion q_current(
-            gantry_ee_link_pose.orientation.x,
-            gantry_ee_link_pose.orientation.y,
-            gantry_ee_link_pose.orientation.z,
-            gantry_ee_link_pose.orientation.w);
-         
-        tf2::Quaternion q_rslt = q_rot * q_current;
-        q_rslt.normalize();
-
-        geometry_msgs::Pose arm_pose = arm_gantry_group_.getCurrentPose().pose;
-
-        // orientation of the gripper when placing the part in the tray
-        arm_pose.orientation.x = q_rslt.x();
-        arm_pose.orientation.y = q_rslt.y();
-        arm_pose.orientation.z = q_rslt.z();
-        arm_pose.orientation.w = q_rslt.w();
-        arm_pose.position.x = target_in_world_frame.position.x;
-        arm_pose.position.y = target_in_world_frame.position.y;
-        arm_pose.position.z = target_in_world_frame.position.z + z_t;
-
-
-        arm_gantry_group_.setPoseTarget(arm_pose);
-        arm_gantry_group_.move();
-
-        ros::Duration(2.0).sleep();
-        deactivateGripper();
-
-        if (location == "as1") {
-            goToPresetLocation(at_as1_);
-            goToPresetLocation(near_as1_);
-            
-        }
-        if (location == "as2") {
-            goToPresetLocation(at_as2_);
-            goToPresetLocation(near_as2_);
-
-        }
-        if (location == "as3") {
-            goToPresetLocation(at_as3_);
-            goToPresetLocation(near_as3_);
-
-        }
-        if (location == "as4") {
-            goToPresetLocation(at_as4_);
-            goToPresetLocation(near_as4_);
-
-        }
-
-        if (location == "agv1") {
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(home_);
-
-        }
-        if (location == "agv2") {
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(home_);
-        }
-        if (location == "agv3") {
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(home_);
-        }
-        if (location == "agv4") {
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(home_);
+        // lift, then back up where the gripper is now unless it already waits right over the part
+        auto hand = manipulator();
+        std::vector<geometry_msgs::Pose> retreat{ hand.above(type, part_init_pose_in_world, 0.2) };
+        auto rest = motioncontrol::Manipulator<Adapter>::wristDown(currentPose().position);
+        if (rest.position.z > retreat.front().position.z)
+            retreat.push_back(rest);
+        if (!hand.pick(type, part_init_pose_in_world, retreat)) {
+            hand.letGo();
+            return false;
         }
 
+        // the kit trays sit lower than the station briefcases, the release height follows the site
+        auto arm_pose = hand.releasePose(part_init_pose_in_world, target_in_world_frame,
+            motioncontrol::GraspOffsets::site(location));
+        // the arm reaches over the target while the gantry drives there, clear of the parts already placed
+        auto above = arm_pose;
+        above.position.z += 0.1;
+        // the kitting arm may be working over the same tray
+        auto tray = trays_->lock(location);
+        if (!travelPreshaped("at_" + location, above))
+            ROS_ERROR_STREAM("[Gantry][movePart] Failed to reach " << location);
 
+        bool placed = hand.place(type, above, arm_pose);
 
-        auto state1 = getGripperState();
-        if (state1.attached)
-            return true;
-        else
-            return false;
+        // clear of the agv or of the station again
+        goToLocation(location.find("agv") == 0 ? "home" : "near_" + location);
 
+        return placed;
     }
 
 
     bool Gantry::movePartfrombin(geometry_msgs::Pose part_init_pose_in_world, std::string type, unsigned short int bin){
+        tracing::Span span("gantry", "movePartfrombin");
+        span.arg("type", type);
 
 
         geometry_msgs::Pose target_in_world_frame;
@@ -1601,163 +1240,42 @@ namespace gantry_motioncontrol {
         target_in_world_frame.orientation.w = place_orientation.getW();
 
 
-        // orientation of the part in the bin, in world frame
-        tf2::Quaternion q_init_part(
-            part_init_pose_in_world.orientation.x,
-            part_init_pose_in_world.orientation.y,
-            part_init_pose_in_world.orientation.z,
-            part_init_pose_in_world.orientation.w);
-
-
-        // orientation of the part in the tray, in world frame
-        tf2::Quaternion q_target_part(
-            target_in_world_frame.orientation.x,
-            target_in_world_frame.orientation.y,
-            target_in_world_frame.orientation.z,
-            target_in_world_frame.orientation.w);
-
-        // relative rotation between init and target
-        tf2::Quaternion q_rot = q_target_part * q_init_part.inverse();
-        // apply this rotation to the current gripper rotation
-        
-        // pose of the end effector in the world frame
-        geometry_msgs::Pose gantry_ee_link_pose = arm_gantry_group_.getCurrentPose().pose;
-        
-        auto flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
-        
-        gantry_ee_link_pose.orientation.x = flat_orientation.getX();
-        gantry_ee_link_pose.orientation.y = flat_orientation.getY();
-        gantry_ee_link_pose.orientation.z = flat_orientation.getZ();
-        gantry_ee_link_pose.orientation.w = flat_orientation.getW();
-        
-        double z_add {0.07};
-
-        if (type.find("pump") != std::string::npos){
-            z_add = 0.08;
-        }
-        if (type.find("battery") != std::string::npos){
-            z_add = 0.06;
-        }
-    
-        part_init_pose_in_world.orientation = gantry_ee_link_pose.orientation;
-        part_init_pose_in_world.position.z = part_init_pose_in_world.position.z + z_add;
-
-        geometry_msgs::Pose postGraspPose;
-
-        // activate gripper
-        ros::Duration(0.5).sleep();
-        activateGripper();
-        auto state = getGripperState();
-
-
-        while (!state.enabled) {
-            activateGripper();
-            state = getGripperState();
-        }
-
-        if (!state.enabled) {
-            ROS_FATAL_STREAM("[Gripper] = Could not enable gripper...shutting down");
-            ros::shutdown();
-        }
-
-        if (state.enabled) {
-            ROS_INFO_STREAM("[Gripper] = enabled");
-            //--Move arm to part
-            arm_gantry_group_.setPoseTarget(part_init_pose_in_world);
-            arm_gantry_group_.move();
-
-            state = getGripperState();
-            // move the arm closer until the object is attached
-            while (!state.attached) {
-                part_init_pose_in_world.position.z = part_init_pose_in_world.position.z - 0.0005;
-                arm_gantry_group_.setPoseTarget(part_init_pose_in_world);
-                arm_gantry_group_.move();
-                arm_gantry_group_.setPoseTarget(gantry_ee_link_pose);
-                state = getGripperState();
-            }
-
-            ROS_INFO_STREAM("[Gripper] = object attached");
-            // gantry_ee_link_pose = arm_gantry_group_.getCurrentPose().pose;
-            // ros::Duration(1.0).sleep();
-            postGraspPose = arm_gantry_group_.getCurrentPose().pose;
-            postGraspPose.position.z = postGraspPose.position.z + 0.1;
-            //--Move arm to previous position
-            arm_gantry_group_.setPoseTarget(postGraspPose);
-            arm_gantry_group_.move();
-            ros::Duration(2.0).sleep();
-            arm_gantry_group_.setPoseTarget(gantry_ee_link_pose);
-            arm_gantry_group_.move();
-        }
-
-        goToPresetLocation(home_);
-        gantry_ee_link_pose.orientation.x = flat_orientation.getX();
-        gantry_ee_link_pose.orientation.y = flat_orientation.getY();
-        gantry_ee_link_pose.orientation.z = flat_orientation.getZ();
-        gantry_ee_link_pose.orientation.w = flat_orientation.getW();
-        arm_gantry_group_.setPoseTarget(gantry_ee_link_pose);
-        arm_gantry_group_.move();
-
-        if (bin == 1) {
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_bin1_);
-        }
-        if (bin == 2) {
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_bin2_);
-        }
-        if (bin == 5) {
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_bin5_);
-        }
-        if (bin == 6) {
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_bin6_);
+        // the gripper comes back where it is now, wrist down, with the part
+        auto hand = manipulator();
+        auto rest = motioncontrol::Manipulator<Adapter>::wristDown(currentPose().position);
+        if (!hand.pick(type, part_init_pose_in_world, { hand.above(type, part_init_pose_in_world, 0.1), rest })) {
+            hand.letGo();
+            return false;
         }
-   
-
-        tf2::Quaternion q_current(
-            gantry_ee_link_pose.orientation.x,
-            gantry_ee_link_pose.orientation.y,
-            gantry_ee_link_pose.orientation.z,
-            gantry_ee_link_pose.orientation.w);
-         
-        tf2::Quaternion q_rslt = q_rot * q_current;
-        q_rslt.normalize();
-
-        geometry_msgs::Pose arm_pose = arm_gantry_group_.getCurrentPose().pose;
-        // orientation of the gripper when placing the part in the tray
-        arm_pose.orientation.x = q_rslt.x();
-        arm_pose.orientation.y = q_rslt.y();
-        arm_pose.orientation.z = q_rslt.z();
-        arm_pose.orientation.w = q_rslt.w();
-        arm_gantry_group_.setPoseTarget(arm_pose);
-        arm_gantry_group_.move();
-        
-
-        arm_pose.position.z = target_in_world_frame.position.z + 0.2;
-        arm_pose.position.x = target_in_world_frame.position.x;
-        arm_pose.position.y = target_in_world_frame.position.y-0.05;
-
-        arm_gantry_group_.setPoseTarget(arm_pose);
-        arm_gantry_group_.move();
 
-        ros::Duration(2.0).sleep();
-        deactivateGripper();
+        // turned and over the bin by the time the gantry stops, then down to a little off the target
+        auto release = hand.releasePose(part_init_pose_in_world, target_in_world_frame, motioncontrol::ReleaseSite::BIN);
+        release.position.y -= 0.05;
+        auto above = release;
+        above.position.z += 0.1;
+        if (!travelPreshaped("at_bin" + std::to_string(bin), above))
+            ROS_ERROR_STREAM("[Gantry][movePartfrombin] Failed to reach bin " << bin);
+        bool placed = hand.place(type, above, release);
         goToPresetLocation(home_);
 
-        auto state1 = getGripperState();
-        if (state1.attached)
-            return true;
-        else
-            return false;
-
+        return placed;
     }
 
-    void Gantry::flippart(Product part, std::vector<int> empty_bins, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool arm_required){
+    bool Gantry::flippart(Product part, std::vector<int> empty_bins, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool arm_required){
+        tracing::Span span("gantry", "flippart");
+        span.arg("agv", agv);
         std::string part_type = part.type;
+        held_type_ = part_type;
         geometry_msgs::Pose part_pose = part.world_pose;
         geometry_msgs::Pose ppf = part_pose_in_frame;
         ROS_INFO_STREAM("In flip");
+        if (arm_required) {
+            move_gantry_to_bin(part.bin_number);
+            if (!pickPart(part_pose, part_type)) {
+                ROS_ERROR_STREAM("[Gantry][flippart] Could not pick " << part_type);
+                return false;
+            }
+        }
         
         int bin_selected = 0;
         for(auto &bin: empty_bins){
@@ -1774,58 +1292,44 @@ namespace gantry_motioncontrol {
         geometry_msgs::Pose part_world_pose;
         if (bin_selected == 1){
             bin_origin = bin1_origin_;
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_bin1_);
         }
         if (bin_selected == 2){
             bin_origin = bin2_origin_;
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_bin2_);
-
         }
         if (bin_selected == 3){
             bin_origin = bin3_origin_;
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_bin3_);
-
         }
         if (bin_selected == 4){
             bin_origin = bin4_origin_;
-            goToPresetLocation(at_bins1234_);
-            goToPresetLocation(at_bin4_);
-
         }
         if (bin_selected == 5){
             bin_origin = bin5_origin_;
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_bin5_);
-
         }
         if (bin_selected == 6){
             bin_origin = bin6_origin_;
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_bin6_);
-
         }
         if (bin_selected == 7){
             bin_origin = bin7_origin_;
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_bin7_);
-
         }
         if (bin_selected == 8){
             bin_origin = bin8_origin_;
-            goToPresetLocation(at_bins5678_);
-            goToPresetLocation(at_bin8_);
-
         }
+        // drop next to what is already in the bins, with room on +y for the side grasp
+        motioncontrol::StagingSlot slot;
+        if (stager_->stage(part_type, empty_bins, motioncontrol::StagingRobot::GANTRY, slot,
+                motioncontrol::StagingMargin{ 0.0, 0.2 })) {
+            bin_selected = slot.bin;
+            bin_origin = { slot.pose.position.x, slot.pose.position.y, bin_origin.at(2) };
+        }
+        if (bin_selected != 0)
+            goToLocation("at_bin" + std::to_string(bin_selected));
         // ROS_INFO_STREAM("EMPTYBIN: "<<bin_selected);
 
         part.bin_number = bin_selected;
                
        
 
-        geometry_msgs::Pose arm_ee_link_pose = arm_gantry_group_.getCurrentPose().pose;
+        geometry_msgs::Pose arm_ee_link_pose = currentPose();
         auto flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
         arm_ee_link_pose.orientation.x = flat_orientation.getX();
         arm_ee_link_pose.orientation.y = flat_orientation.getY();
@@ -1866,9 +1370,9 @@ namespace gantry_motioncontrol {
       
         arm_gantry_group_.setPoseTarget(arm_ee_link_pose);
         arm_gantry_group_.move();
-        ros::Duration(2.0).sleep();
+        settle();
         deactivateGripper();
-        ros::Duration(2.0).sleep();
+        gripper_.waitReleased(ros::Time::now() + ros::Duration(2.0));
         // moveBaseTo(bin_origin.at(1)-0.4);
         part_pose.position.x = arm_ee_link_pose.position.x;
         part_pose.position.y = arm_ee_link_pose.position.y;
@@ -1884,7 +1388,7 @@ namespace gantry_motioncontrol {
         arm_gantry_group_.setPoseTarget(arm_ee_link_pose);
         arm_gantry_group_.move();
 
-        arm_ee_link_pose = arm_gantry_group_.getCurrentPose().pose;
+        arm_ee_link_pose = currentPose();
         geometry_msgs::Pose Post_grasp = arm_ee_link_pose;
         
         auto side_orientation = motioncontrol::quaternionFromEuler(0, 0, -1.57);
@@ -1895,18 +1399,13 @@ namespace gantry_motioncontrol {
         // target_pose.position.z = bin_origin.at(2)+0.2;
         arm_gantry_group_.setPoseTarget(arm_ee_link_pose);
         arm_gantry_group_.move();
-        arm_ee_link_pose = arm_gantry_group_.getCurrentPose().pose;
+        arm_ee_link_pose = currentPose();
         geometry_msgs::Pose Post_grasp1 = arm_ee_link_pose;
         
         // activate gripper
-        ros::Duration(0.5).sleep();
         activateGripper();
+        gripper_.waitEnabled(ros::Time::now() + ros::Duration(2.0));
         auto state = getGripperState();
-
-        while (!state.enabled) {
-            activateGripper();
-            state = getGripperState();
-        }
         
         arm_ee_link_pose.position.x = part_pose.position.x;
         arm_ee_link_pose.position.y = part_pose.position.y + 0.12 ;
@@ -1915,16 +1414,13 @@ namespace gantry_motioncontrol {
         arm_gantry_group_.setPoseTarget(arm_ee_link_pose);
         arm_gantry_group_.move();
 
-        state = getGripperState();
-        while (!state.attached) {
-            arm_ee_link_pose.position.y -= 0.005;
-            arm_gantry_group_.setPoseTarget(arm_ee_link_pose);
-            arm_gantry_group_.move();
-            state = getGripperState();
-            ros::Duration(sleep(0.5));
-        }
+        motioncontrol::GraspPrimitive grasp(arm_gantry_group_, gripper_, motioncontrol::graspOptions(profiles_, part_type), &joint_states_);
+        grasp.guardedMove(gantry_arm_joint_trajectory_publisher_, Eigen::Vector3d(0, -1, 0), 0.1);
+        arm_ee_link_pose = currentPose();
 
         arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.12;
+        profiles_.select(motioncontrol::MotionPhase::FLIP, part_type).apply(arm_gantry_group_);
+        profiles_.select(motioncontrol::MotionPhase::FLIP, part_type).apply(full_gantry_group_);
       
         arm_gantry_group_.setPoseTarget(arm_ee_link_pose);
         arm_gantry_group_.move();
@@ -1936,28 +1432,26 @@ namespace gantry_motioncontrol {
         arm_gantry_group_.move();
         
         const moveit::core::JointModelGroup* joint_model_group =
-            arm_gantry_group_.getCurrentState()->getJointModelGroup("gantry_arm");
-        moveit::core::RobotStatePtr current_state = arm_gantry_group_.getCurrentState();
+            arm_gantry_group_.getRobotModel()->getJointModelGroup("gantry_arm");
+        moveit::core::RobotStatePtr current_state = currentState();
 
-        // get the current set of joint values for the group.
-        current_state->copyJointGroupPositions(joint_model_group, joint_group_positions_);
+        // get the current set of joint values for the arm, joint_group_positions_ holds the full gantry
+        current_state->copyJointGroupPositions(joint_model_group, joint_arm_positions_);
 
-        // next, assign a value to only the linear_arm_actuator_joint
-        
-        ROS_INFO_STREAM("wrist3 " << joint_group_positions_.at(5));
-        joint_group_positions_.at(5) = joint_group_positions_.at(5) + M_PI;
+        // turn wrist 3 over
+        ROS_INFO_STREAM("wrist3 " << joint_arm_positions_.at(5));
+        joint_arm_positions_.at(5) = joint_arm_positions_.at(5) + M_PI;
         // move the arm
-        ROS_INFO_STREAM("wrist3 "<<joint_group_positions_.at(5));
-        arm_gantry_group_.setJointValueTarget(joint_group_positions_);
-        full_gantry_group_.move();
-        ros::Duration(2.0).sleep();
+        ROS_INFO_STREAM("wrist3 "<<joint_arm_positions_.at(5));
+        arm_gantry_group_.setJointValueTarget(joint_arm_positions_);
+        arm_gantry_group_.move();
+        settle();
         deactivateGripper();
         ROS_INFO_STREAM("dropped");
-        joint_group_positions_.at(5) = joint_group_positions_.at(5) - M_PI;
-        ROS_INFO_STREAM("wrist3 " << joint_group_positions_.at(5));
-        arm_gantry_group_.setJointValueTarget(joint_group_positions_);
-        full_gantry_group_.move();
-        ros::Duration(2.0).sleep();
+        joint_arm_positions_.at(5) = joint_arm_positions_.at(5) - M_PI;
+        ROS_INFO_STREAM("wrist3 " << joint_arm_positions_.at(5));
+        arm_gantry_group_.setJointValueTarget(joint_arm_positions_);
+        arm_gantry_group_.move();
         part.world_pose.position.x = bin_origin.at(0);
         part.world_pose.position.y = bin_origin.at(1);
         part.world_pose.position.z = 0.8;
@@ -1968,174 +1462,127 @@ namespace gantry_motioncontrol {
         part.world_pose.orientation.z = final_orientation.getZ();
         part.world_pose.orientation.w = final_orientation.getW();
         ROS_INFO_STREAM(part.world_pose);
-        try{
-            
-            flat_orientation = motioncontrol::quaternionFromEuler(0, 1.57, 0);
-            arm_ee_link_pose.orientation.x = flat_orientation.getX();
-            arm_ee_link_pose.orientation.y = flat_orientation.getY();
-            arm_ee_link_pose.orientation.z = flat_orientation.getZ();
-            arm_ee_link_pose.orientation.w = flat_orientation.getW();
-            ROS_INFO_STREAM("going to post_grasp1");
-            arm_gantry_group_.setPoseTarget(Post_grasp1);
-            arm_gantry_group_.move();
-            ROS_INFO_STREAM("Reached post_grasp1");
-            ros::Duration(2.0).sleep();
-            ROS_INFO_STREAM("going to post_grasp");
-            arm_gantry_group_.setPoseTarget(Post_grasp);
-            arm_gantry_group_.move();
-            ROS_INFO_STREAM("Reached post_grasp");
-
-            if (part.bin_number == 1){
-                ROS_INFO_STREAM("in 1");
-                goToPresetLocation(at_bin1_);
-            }
-            else if (part.bin_number == 2){
-                ROS_INFO_STREAM("in 2");
-                goToPresetLocation(at_bin2_);
-
-            }
-            else if (part.bin_number == 3){
-                ROS_INFO_STREAM("in 3");
-                goToPresetLocation(at_bin3_);
-
-            }
-            else if (part.bin_number== 4){
-                ROS_INFO_STREAM("in 4");
-                goToPresetLocation(at_bin4_);
+        // back out the way the gripper came in, the flipped part goes straight to the tray
+        arm_gantry_group_.setPoseTarget(Post_grasp1);
+        arm_gantry_group_.move();
+        arm_gantry_group_.setPoseTarget(Post_grasp);
+        arm_gantry_group_.move();
+        return movePart(part.world_pose, ppf, agv, part_type);
+    }
+    
+    void Gantry::move_gantry_to_bin(unsigned short int bin){
+        tracing::Span span("gantry", "move_gantry_to_bin");
+        span.arg("bin", bin);
+        goToLocation("at_bin" + std::to_string(bin));
+    }
 
-            }
-            else if (part.bin_number == 5){
-                ROS_INFO_STREAM("in 5");
-                goToPresetLocation(at_bin5_);
+    void Gantry::move_gantry_to_bin(unsigned short int bin, const std::string& part_type, const geometry_msgs::Pose& part){
+        tracing::Span span("gantry", "move_gantry_to_bin");
+        span.arg("bin", bin);
+        auto offset = offsets_.select(part_type);
+        travelPreshaped("at_bin" + std::to_string(bin), manipulator().above(part_type, part, offset.hover));
+    }
 
-            }
-            else if (part.bin_number == 6){
-                ROS_INFO_STREAM("in 6");
-                goToPresetLocation(at_bin6_);
+    void Gantry::move_gantry_to_assembly_station(std::string c_name){
+        tracing::Span span("gantry", "move_gantry_to_assembly_station");
+        span.arg("camera", c_name);
+        std::string station, agv;
+        for (int i{ 1 }; i <= 4; i++) {
+            if (c_name.find("as" + std::to_string(i)) != std::string::npos)
+                station = "as" + std::to_string(i);
+            if (c_name.find("agv" + std::to_string(i)) != std::string::npos)
+                agv = "agv" + std::to_string(i);
+        }
+        if (station.empty()) {
+            ROS_ERROR_STREAM("[Gantry][move_gantry_to_assembly_station] No station in " << c_name);
+            return;
+        }
+        // above the agv parked at the station, or in front of the station
+        std::string target = "at_" + agv + "_" + station;
+        goToLocation(presets_.has(target) ? target : "near_" + station);
+    }
 
-            }
-            else if (part.bin_number == 7){
-                ROS_INFO_STREAM("in 7");
-                goToPresetLocation(at_bin7_);
+    /////////////////////////////////////////////////////
+    bool Gantry::moveToPose(const geometry_msgs::Pose& pose)
+    {
+        std::vector<double> joints;
+        if (ik_table_.solve(*currentState(), "gantry_arm", pose, joints))
+            arm_gantry_group_.setJointValueTarget(joints);
+        else
+            arm_gantry_group_.setPoseTarget(pose);
+        return arm_gantry_group_.move() == moveit::planning_interface::MoveItErrorCode::SUCCESS;
+    }
 
-            }
-            else if (part.bin_number == 8){
-                ROS_INFO_STREAM("in 8");
-                goToPresetLocation(at_bin8_);
+    /////////////////////////////////////////////////////
+    bool Gantry::graspFromAbove(const std::string& part_type, const geometry_msgs::Pose& part, double lift,
+        const geometry_msgs::Pose& rest)
+    {
+        auto hand = manipulator();
+        return hand.pick(part_type, part, { hand.above(part_type, part, lift), rest });
+    }
 
-            }
-            
-            ROS_INFO_STREAM(part.bin_number);
-            goToPresetLocation(home_);
-            ROS_INFO_STREAM("Home reached");
-            ros::Duration(2.0).sleep();
-            ROS_INFO_STREAM("going to pick part");
-            move_gantry_to_bin(part.bin_number);
-        }
-        catch(std::string agv){
-            ROS_INFO_STREAM(agv);
-            movePart(part.world_pose, ppf, agv, part_type);
-        }
+    /////////////////////////////////////////////////////
+    void Gantry::activateGripper()
+    {
+        gripper_.enableAsync();
     }
-    
-    void Gantry::move_gantry_to_bin(unsigned short int bin){
-        if(bin == 1){
-            goToPresetLocation(at_bin1_);
-        }
-        if(bin == 2){
-            goToPresetLocation(at_bin2_);
-        }
-        if(bin == 3){
-            goToPresetLocation(at_bin3_);
-        }
-        if(bin == 4){
-            goToPresetLocation(at_bin4_);
-        }
-        if(bin == 5){
-            goToPresetLocation(at_bin5_);
-        }
-        if(bin == 6){
-            goToPresetLocation(at_bin6_);
-        }
-        if(bin == 7){
-            goToPresetLocation(at_bin7_);
-        }
-        if(bin == 8){
-            goToPresetLocation(at_bin8_);
-        }
+
+    /////////////////////////////////////////////////////
+    void Gantry::deactivateGripper()
+    {
+        gripper_.disable();
+        scene_.detach();
+        preset_cache_.hold("");
     }
 
-    void Gantry::move_gantry_to_assembly_station(std::string c_name){
-        if (c_name.find("as1") != std::string::npos){
-            goToPresetLocation(near_as1_);
-            if (c_name.find("agv1") != std::string::npos){
-                goToPresetLocation(at_agv1_as1_);
-            }
-            if (c_name.find("agv2") != std::string::npos){
-                goToPresetLocation(at_agv2_as1_);
-            }
-        }
-        if (c_name.find("as2") != std::string::npos){
-            goToPresetLocation(home2_);
-            goToPresetLocation(near_as2_);
-            if (c_name.find("agv1") != std::string::npos){
-                goToPresetLocation(at_agv1_as2_);
-            }
-            if (c_name.find("agv2") != std::string::npos){
-                goToPresetLocation(at_agv2_as2_);
-            }
-        }
-        if (c_name.find("as3") != std::string::npos){
-            goToPresetLocation(near_as3_);
-            if (c_name.find("agv3") != std::string::npos){
-                goToPresetLocation(at_agv3_as3_);
-            }
-            if (c_name.find("agv4") != std::string::npos){
-                goToPresetLocation(at_agv4_as3_);
-            }
-        }
-        if (c_name.find("as4") != std::string::npos){
-            goToPresetLocation(home2_);
-            goToPresetLocation(near_as4_);
-            if (c_name.find("agv3") != std::string::npos){
-                goToPresetLocation(at_agv3_as4_);
-            }
-            if (c_name.find("agv4") != std::string::npos){
-                goToPresetLocation(at_agv4_as4_);
-            }
-        }
+    /////////////////////////////////////////////////////
+    void Gantry::updateScene(const std::vector<Product>& parts)
+    {
+        if (scene_.update(parts))
+            preset_cache_.clear();
+        stager_->observe(parts);
     }
 
     /////////////////////////////////////////////////////
-    void Gantry::activateGripper()
+    void Gantry::setBinStager(const std::shared_ptr<motioncontrol::BinStager>& stager)
     {
-        nist_gear::VacuumGripperControl srv;
-        srv.request.enable = true;
-        gantry_gripper_control_client_.call(srv);
+        stager_ = stager;
+    }
 
-        ROS_INFO_STREAM("[Gantry][activateGantryGripper] DEBUG: srv.response =" << srv.response);
+    /////////////////////////////////////////////////////
+    void Gantry::setTrayLocks(const std::shared_ptr<motioncontrol::TrayLocks>& trays)
+    {
+        trays_ = trays;
     }
 
     /////////////////////////////////////////////////////
-    void Gantry::deactivateGripper()
+    void Gantry::attachHeldPart()
     {
-        nist_gear::VacuumGripperControl srv;
-        srv.request.enable = false;
-        gantry_gripper_control_client_.call(srv);
+        scene_.attach(arm_gantry_group_.getEndEffectorLink(), held_type_, currentPose());
+        preset_cache_.hold(held_type_);
+    }
 
-        ROS_INFO_STREAM("[Gantry][deactivateGantryGripper] DEBUG: srv.response =" << srv.response);
+    /////////////////////////////////////////////////////
+    bool Gantry::settle()
+    {
+        return monitor_.waitSettled(ros::Time::now() + ros::Duration(2.0));
     }
 
     /////////////////////////////////////////////////////
     nist_gear::VacuumGripperState Gantry::getGripperState()
     {
-        return gantry_gripper_state_;
+        return gripper_.state();
     }
 
     /////////////////////////////////////////////////////
     void Gantry::goToPresetLocation(GantryPresetLocation location, bool full_robot)
     {
+        tracing::Span span("gantry", "goToPresetLocation");
+        span.arg("full_robot", full_robot);
         ROS_INFO_STREAM("in preset");
+        // refill the 9 joints, a caller may have left fewer in joint_group_positions_
+        currentState()->copyJointGroupPositions(
+            full_gantry_group_.getRobotModel()->getJointModelGroup("gantry_full"), joint_group_positions_);
         if (full_robot) {
             // gantry torso
             joint_group_positions_.at(0) = location.gantry_torso_preset.at(0);
@@ -2149,13 +1596,8 @@ namespace gantry_motioncontrol {
             joint_group_positions_.at(7) = location.gantry_arm_preset.at(4);
             joint_group_positions_.at(8) = location.gantry_arm_preset.at(5);
 
-            full_gantry_group_.setJointValueTarget(joint_group_positions_);
-
-            moveit::planning_interface::MoveGroupInterface::Plan my_plan;
-            // check a plan is found first then execute the action
-            bool success = (full_gantry_group_.plan(my_plan) == moveit::planning_interface::MoveItErrorCode::SUCCESS);
-            if (success)
-                full_gantry_group_.move();
+            if (!preset_cache_.moveTo(full_gantry_group_, joint_group_positions_, transitProfile(), &joint_states_))
+                ROS_ERROR_STREAM("[Gantry][goToPresetLocation] Failed to reach the preset");
         }
         else {
             // gantry torso
@@ -2163,47 +1605,235 @@ namespace gantry_motioncontrol {
             joint_group_positions_.at(1) = location.gantry_torso_preset.at(1);
             joint_group_positions_.at(2) = location.gantry_torso_preset.at(2);
 
-            torso_gantry_group_.setJointValueTarget(joint_group_positions_);
+            // the torso group only has these 3 joints
+            std::vector<double> torso_positions(joint_group_positions_.begin(), joint_group_positions_.begin() + 3);
+            if (!preset_cache_.moveTo(torso_gantry_group_, torso_positions, transitProfile(), &joint_states_))
+                ROS_ERROR_STREAM("[Gantry][goToPresetLocation] Failed to reach the torso preset");
+        }
+
+    }
 
-            moveit::planning_interface::MoveGroupInterface::Plan my_plan;
-            // check a plan is found first then execute the action
-            bool success = (torso_gantry_group_.plan(my_plan) == moveit::planning_interface::MoveItErrorCode::SUCCESS);
-            if (success)
-                torso_gantry_group_.move();
+    /////////////////////////////////////////////////////
+    bool Gantry::goToLocation(const std::string& name)
+    {
+        tracing::Span span("gantry", "goToLocation");
+        span.arg("location", name);
+        std::string from;
+        std::vector<std::string> path;
+        if (!routeFromHere(name, from, path))
+            return false;
+        if (path.empty())
+            return true;
+        // only stream from a preset, the blends are checked but the way onto the graph is not
+        if (stream_presets_ && !from.empty()) {
+            if (streamRoute(from, path))
+                return true;
+            ROS_WARN_STREAM("[Gantry][goToLocation] Streaming to " << name << " failed, planning instead");
+        }
+        motioncontrol::MotionPipeline pipeline(&joint_states_, &preset_cache_);
+        if (!addRoute(pipeline, name))
+            return false;
+        if (!pipeline.run()) {
+            ROS_ERROR_STREAM("[Gantry][goToLocation] Failed to reach " << name);
+            return false;
         }
+        return true;
+    }
 
+    /////////////////////////////////////////////////////
+    bool Gantry::routeFromHere(const std::string& to, std::string& from, std::vector<std::string>& path)
+    {
+        if (!presets_.has(to)) {
+            ROS_ERROR_STREAM("[Gantry][routeFromHere] Unknown preset " << to);
+            return false;
+        }
+        std::vector<double> joints;
+        currentState()->copyJointGroupPositions("gantry_full", joints);
+        double distance{ 0.0 };
+        std::string closest = presets_.nearest(joints, distance);
+        if (!presets_.route(closest, to, path)) {
+            ROS_ERROR_STREAM("[Gantry][routeFromHere] No route from " << closest << " to " << to);
+            return false;
+        }
+        from = distance < 0.02 ? closest : "";
+        // off a preset (e.g. after a pick) the gantry goes straight to the next one
+        if (path.empty() && from.empty())
+            path.push_back(to);
+        return true;
     }
 
+    /////////////////////////////////////////////////////
+    bool Gantry::addRoute(motioncontrol::MotionPipeline& pipeline, const std::string& to)
+    {
+        std::string from;
+        std::vector<std::string> path;
+        if (!routeFromHere(to, from, path))
+            return false;
 
-    ///////////////////////////
-    ////// Callback Functions
-    ///////////////////////////
+        // a move that does not start at a preset is not an edge, it is not measured
+        auto started = std::make_shared<ros::Time>(ros::Time::now());
+        std::string previous = from;
+        auto profile = transitProfile();
+        for (auto& name : path) {
+            auto segment = motioncontrol::MotionSegment::joint(full_gantry_group_, presets_.preset(name).full(), profile);
+            segment.after = [this, previous, name, started]() {
+                if (!previous.empty())
+                    presets_.record(previous, name, (ros::Time::now() - *started).toSec());
+                *started = ros::Time::now();
+            };
+            pipeline.add(segment);
+            previous = name;
+        }
+        return true;
+    }
 
+    /////////////////////////////////////////////////////
+    bool Gantry::streamRoute(const std::string& from, const std::vector<std::string>& path)
+    {
+        tracing::Span span("gantry", "streamRoute");
+        span.arg("presets", path.size());
+        std::vector<std::vector<double> > waypoints;
+        for (auto& name : path)
+            waypoints.push_back(presets_.preset(name).full());
+        std::vector<double> start;
+        currentState()->copyJointGroupPositions("gantry_full", start);
+
+        trajectory_msgs::JointTrajectory trajectory;
+        std::vector<double> durations;
+        if (!streamer_.plan(start, waypoints, trajectory, durations, transitProfile()))
+            return false;
+        // the blends cut the corners at the presets, off the edges known to be free
+        if (!sweep_.check(trajectory))
+            return false;
+        if (!streamer_.execute(trajectory, joint_states_, full_gantry_group_))
+            return false;
+        // the controllers follow the timing, it is what the edges take when streamed
+        std::string previous = from;
+        for (std::size_t i{ 0 }; i < path.size(); i++) {
+            presets_.record(previous, path.at(i), durations.at(i));
+            previous = path.at(i);
+        }
+        return true;
+    }
 
     /////////////////////////////////////////////////////
-    void Gantry::gantry_gripper_state_callback(const nist_gear::VacuumGripperState::ConstPtr& gripper_state_msg)
+    bool Gantry::travelPreshaped(const std::string& to, const geometry_msgs::Pose& pose)
     {
-        gantry_gripper_state_ = *gripper_state_msg;
+        tracing::Span span("gantry", "travelPreshaped");
+        span.arg("location", to);
+        std::string from;
+        std::vector<std::string> path;
+        if (!routeFromHere(to, from, path))
+            return false;
+
+        auto state = currentState();
+        if (stream_presets_ && !path.empty()) {
+            // arm joints reaching the pose once the torso is at the preset
+            auto& preset = presets_.preset(to);
+            moveit::core::RobotState end(*state);
+            end.setJointGroupPositions("gantry_full", preset.full());
+            std::vector<double> arm;
+            if (!ik_table_.solve(end, "gantry_arm", pose, arm)) {
+                auto joint_model_group = end.getJointModelGroup("gantry_arm");
+                if (end.setFromIK(joint_model_group, pose, 0.05))
+                    end.copyJointGroupPositions(joint_model_group, arm);
+            }
+
+            trajectory_msgs::JointTrajectory trajectory;
+            std::vector<double> durations;
+            if (arm.size() == preset.arm.size()) {
+                // the route as it is, with the arm folding into its target on the last leg
+                std::vector<std::vector<double> > waypoints;
+                for (auto& name : path)
+                    waypoints.push_back(presets_.preset(name).full());
+                std::copy(arm.begin(), arm.end(), waypoints.back().begin() + preset.torso.size());
+                std::vector<double> start;
+                state->copyJointGroupPositions("gantry_full", start);
+
+                if (streamer_.plan(start, waypoints, trajectory, durations, transitProfile())) {
+                    // the blends leave the preset edges, so none of the sweep is known to be free
+                    if (sweep_.check(trajectory) &&
+                        streamer_.execute(trajectory, joint_states_, full_gantry_group_)) {
+                        std::string previous = from;
+                        for (std::size_t i{ 0 }; !previous.empty() && i + 1 < path.size(); i++) {
+                            presets_.record(previous, path.at(i), durations.at(i));
+                            previous = path.at(i);
+                        }
+                        return true;
+                    }
+                }
+            }
+            ROS_WARN_STREAM("[Gantry][travelPreshaped] Torso and arm one after the other to " << to);
+        }
+
+        // the pose is planned while the gantry drives to the preset
+        motioncontrol::MotionPipeline pipeline(&joint_states_, &preset_cache_);
+        if (!addRoute(pipeline, to))
+            return false;
+        pipeline.add(motioncontrol::MotionSegment::poseTarget(arm_gantry_group_, pose, transitProfile()));
+        if (!pipeline.run()) {
+            ROS_ERROR_STREAM("[Gantry][travelPreshaped] Failed to reach " << to);
+            return false;
+        }
+        return true;
     }
 
+    /////////////////////////////////////////////////////
+    bool Gantry::sendJointPosition(trajectory_msgs::JointTrajectory command_msg)
+    {
+        return streamer_.send(command_msg);
+    }
+
+    /////////////////////////////////////////////////////
+    motioncontrol::MotionProfile Gantry::transitProfile() const
+    {
+        if (gripper_.attached())
+            return profiles_.select(motioncontrol::MotionPhase::LOADED_TRANSIT, held_type_);
+        return profiles_.select(motioncontrol::MotionPhase::EMPTY_TRANSIT);
+    }
+
+    /////////////////////////////////////////////////////
+    moveit::core::RobotStatePtr Gantry::currentState()
+    {
+        return motioncontrol::latestState(&joint_states_, full_gantry_group_);
+    }
+
+    /////////////////////////////////////////////////////
+    geometry_msgs::Pose Gantry::currentPose()
+    {
+        geometry_msgs::Pose pose;
+        if (!joint_states_.pose(pose)) {
+            ROS_DEBUG_STREAM("[Gantry][currentPose] No recent joint state, asking MoveIt");
+            pose = arm_gantry_group_.getCurrentPose().pose;
+        }
+        return pose;
+    }
+
+
+    ///////////////////////////
+    ////// Callback Functions
+    ///////////////////////////
+
+
+    /////////////////////////////////////////////////////
     /////////////////////////////////////////////////////
     void Gantry::gantry_full_joint_states_callback_(const sensor_msgs::JointState::ConstPtr& joint_state_msg)
     {
         if (joint_state_msg->position.size() == 0) {
             ROS_ERROR("[Gantry][gantry_full_joint_states_callback_] joint_state_msg->position.size() == 0!");
         }
-        current_joint_states_ = *joint_state_msg;
+        joint_states_.update(*joint_state_msg);
     }
 
     /////////////////////////////////////////////////////
     void Gantry::gantry_arm_controller_state_callback(const control_msgs::JointTrajectoryControllerState::ConstPtr& msg)
     {
-        gantry_arm_controller_state_ = *msg;
+        monitor_.update("gantry_arm_controller", *msg);
     }
 
     /////////////////////////////////////////////////////
     void Gantry::gantry_controller_state_callback(const control_msgs::JointTrajectoryControllerState::ConstPtr& msg)
     {
-        gantry_torso_controller_state_ = *msg;
+        monitor_.update("gantry_controller", *msg);
     }
 }//namespace
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "../include/station/assembly_station.h"
+#include "../include/trace/trace.h"
+
+namespace motioncontrol {
+    AssemblyStationManager::AssemblyStationManager(ros::NodeHandle& node, LogicalCamera& camera)
+        : camera_(camera)
+    {
+        for (const std::string station : { "as1", "as2", "as3", "as4" }) {
+            clients_[station].client = node.serviceClient<nist_gear::AssemblyStationSubmitShipment>(
+                "/ariac/" + station + "/submit_shipment", true);
+        }
+    }
+
+    AssemblyStationManager::~AssemblyStationManager()
+    {
+        workers_.join();
+    }
+
+    bool AssemblyStationManager::validate(const Assembly& shipment, std::vector<std::string>& missing)
+    {
+        tracing::Span span("camera", "validate_briefcase");
+        span.arg("shipment_type", shipment.shipment_type);
+        missing.clear();
+        auto seen = camera_.get_station_parts(shipment.stations, ros::Duration(2.0));
+        if (seen.empty()) {
+            for (auto& product : shipment.products)
+                missing.push_back(product.type);
+            return false;
+        }
+
+        std::map<std::string, int> seen_count;
+        for (auto& part : seen)
+            seen_count[part.type]++;
+
+        for (auto& product : shipment.products) {
+            auto count = seen_count.find(product.type);
+            if (count == seen_count.end() || count->second == 0) {
+                missing.push_back(product.type);
+                continue;
+            }
+            count->second--;
+        }
+        return missing.empty();
+    }
+
+    std::future<bool> AssemblyStationManager::submitAsync(const Assembly& shipment)
+    {
+        auto result = std::make_shared<std::promise<bool> >();
+        std::future<bool> future = result->get_future();
+
+        workers_.start([this, result, shipment]() {
+            result->set_value(submit(shipment.stations, shipment.shipment_type));
+        });
+        return future;
+    }
+
+    bool AssemblyStationManager::submit(const std::string& station, const std::string& shipment_type)
+    {
+        tracing::Span span("service", "submit_shipment");
+        span.arg("shipment_type", shipment_type);
+        auto client = clients_.find(station);
+        if (client == clients_.end()) {
+            ROS_ERROR_STREAM("[AssemblyStationManager][submit] Unknown station: " << station);
+            return false;
+        }
+
+        nist_gear::AssemblyStationSubmitShipment srv;
+        srv.request.shipment_type = shipment_type;
+        // overlapping submissions to the station take turns on its client
+        std::lock_guard<std::mutex> lock(client->second.mutex);
+        ros::ServiceClient& service = client->second.client;
+        // a persistent client is invalidated if the connection drops, recreate it once
+        if (!service.isValid() || !service.call(srv)) {
+            ros::NodeHandle node;
+            service = node.serviceClient<nist_gear::AssemblyStationSubmitShipment>(
+                "/ariac/" + station + "/submit_shipment", true);
+            service.waitForExistence(ros::Duration(2.0));
+            if (!service.call(srv)) {
+                ROS_ERROR_STREAM("[AssemblyStationManager][submit] Failed to call " << station);
+                return false;
+            }
+        }
+
+        if (srv.response.success) {
+            ROS_INFO_STREAM("[AssemblyStationManager] Submitted " << shipment_type << " at " << station);
+            return true;
+        }
+        ROS_ERROR_STREAM("[AssemblyStationManager] Submission of " << shipment_type << " at " << station << " rejected");
+        return false;
+    }
+}//namespace
@@ -0,0 +1,233 @@
+#include "../include/planner/bin_stager.h"
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <cmath>
+
+namespace motioncontrol {
+    namespace {
+        const double epsilon{ 1e-6 };
+    }
+
+    BinStager::BinStager()
+    {
+        centers_ = {
+            { 1, { -1.898, 3.37 } }, { 2, { -1.898, 2.56 } }, { 3, { -2.651, 2.56 } }, { 4, { -2.651, 3.37 } },
+            { 5, { -1.898, -3.37 } }, { 6, { -1.898, -2.56 } }, { 7, { -2.651, -2.56 } }, { 8, { -2.651, -3.37 } }
+        };
+        part_sizes_ = {
+            { "battery", { 0.13, 0.06, 0.06 } }, { "sensor", { 0.12, 0.12, 0.08 } },
+            { "regulator", { 0.12, 0.12, 0.08 } }, { "pump", { 0.13, 0.13, 0.13 } }
+        };
+        // the kitting arm only reaches the bins next to its rail
+        reach_[StagingRobot::KITTING] = { -2.3, 0.0 };
+        reach_[StagingRobot::GANTRY] = { -4.0, 0.0 };
+    }
+
+    bool BinStager::load(const std::string& path)
+    {
+        try {
+            YAML::Node root = YAML::LoadFile(path);
+            YAML::Node bins = root["bins"];
+            if (bins) {
+                size_ = bins["size"].as<std::vector<double> >(size_);
+                wall_ = bins["wall"].as<double>(wall_);
+                std::map<int, std::vector<double> > centers;
+                for (auto bin : bins["centers"]) {
+                    // bin1 ... bin8
+                    std::string name = bin.first.as<std::string>();
+                    centers[std::stoi(name.substr(name.find_first_of("0123456789")))] = bin.second.as<std::vector<double> >();
+                }
+                if (!centers.empty())
+                    centers_ = centers;
+            }
+            if (root["parts"]) {
+                part_sizes_.clear();
+                for (auto entry : root["parts"])
+                    part_sizes_[entry.first.as<std::string>()] = entry.second.as<std::vector<double> >();
+            }
+            YAML::Node staging = root["staging"];
+            if (staging) {
+                clearance_ = staging["clearance"].as<double>(clearance_);
+                wall_margin_ = staging["wall_margin"].as<double>(wall_margin_);
+                height_ = staging["height"].as<double>(height_);
+                hold_time_ = staging["hold_time"].as<double>(hold_time_);
+                if (staging["reach"]) {
+                    reach_[StagingRobot::KITTING] = staging["reach"]["kitting"].as<std::vector<double> >(reach_[StagingRobot::KITTING]);
+                    reach_[StagingRobot::GANTRY] = staging["reach"]["gantry"].as<std::vector<double> >(reach_[StagingRobot::GANTRY]);
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            ROS_ERROR_STREAM("[BinStager][load] " << path << ": " << e.what());
+            return false;
+        }
+        return true;
+    }
+
+    void BinStager::observe(const std::vector<Product>& parts)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        seen_.clear();
+        for (auto& part : parts) {
+            double x = part.world_pose.position.x;
+            double y = part.world_pose.position.y;
+            for (auto& bin : centers_) {
+                if (std::abs(x - bin.second.at(0)) > size_.at(0) / 2.0 || std::abs(y - bin.second.at(1)) > size_.at(1) / 2.0)
+                    continue;
+                double half = footprint(part.type) / 2.0;
+                seen_[bin.first].push_back(Box{ x - half, y - half, x + half, y + half });
+                break;
+            }
+        }
+
+        // a slot is free again once its part landed (the cameras now report it) or it was never used
+        ros::Time now = ros::Time::now();
+        reserved_.erase(std::remove_if(reserved_.begin(), reserved_.end(), [this, &now](const Reservation& reservation) {
+            if ((now - reservation.stamp).toSec() > hold_time_)
+                return true;
+            for (auto& box : seen_[reservation.bin]) {
+                double x = (box.min_x + box.max_x) / 2.0;
+                double y = (box.min_y + box.max_y) / 2.0;
+                if (x > reservation.box.min_x && x < reservation.box.max_x && y > reservation.box.min_y && y < reservation.box.max_y)
+                    return true;
+            }
+            return false;
+        }), reserved_.end());
+    }
+
+    bool BinStager::stage(const std::string& part_type, const std::vector<int>& bins, StagingRobot robot,
+        StagingSlot& slot, const StagingMargin& margin)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        double side = footprint(part_type);
+        for (auto bin : bins) {
+            if (centers_.find(bin) == centers_.end())
+                continue;
+            Box box;
+            if (!fit(bin, side, side + margin.below_y + margin.above_y, robot, occupied(bin), box))
+                continue;
+            reserved_.push_back(Reservation{ bin, box, ros::Time::now() });
+
+            slot.bin = bin;
+            slot.pose = geometry_msgs::Pose();
+            slot.pose.position.x = (box.min_x + box.max_x) / 2.0;
+            slot.pose.position.y = box.min_y + margin.below_y + side / 2.0;
+            slot.pose.position.z = height_;
+            slot.pose.orientation.w = 1.0;
+            slot.kitting = reachable(StagingRobot::KITTING, slot.pose);
+            slot.gantry = reachable(StagingRobot::GANTRY, slot.pose);
+            ROS_INFO_STREAM("[BinStager][stage] " << (part_type.empty() ? "part" : part_type) << " in bin " << bin
+                << " at " << slot.pose.position.x << ", " << slot.pose.position.y << (slot.kitting ? " (kitting" : " (")
+                << (slot.kitting && slot.gantry ? ", " : "") << (slot.gantry ? "gantry)" : ")"));
+            return true;
+        }
+        ROS_WARN_STREAM("[BinStager][stage] No room for " << (part_type.empty() ? "a part" : part_type)
+            << " in " << bins.size() << " bins");
+        return false;
+    }
+
+    int BinStager::capacity(int bin, const std::string& part_type, StagingRobot robot) const
+    {
+        if (centers_.find(bin) == centers_.end())
+            return 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        double side = footprint(part_type);
+        auto taken = occupied(bin);
+        int count{ 0 };
+        Box box;
+        while (fit(bin, side, side, robot, taken, box)) {
+            taken.push_back(box);
+            count++;
+        }
+        return count;
+    }
+
+    bool BinStager::reachable(StagingRobot robot, const geometry_msgs::Pose& pose) const
+    {
+        auto reach = reach_.find(robot);
+        if (reach == reach_.end())
+            return false;
+        return pose.position.x >= reach->second.at(0) && pose.position.x <= reach->second.at(1);
+    }
+
+    bool BinStager::center(int bin, geometry_msgs::Pose& pose) const
+    {
+        auto found = centers_.find(bin);
+        if (found == centers_.end())
+            return false;
+        pose = geometry_msgs::Pose();
+        pose.position.x = found->second.at(0);
+        pose.position.y = found->second.at(1);
+        pose.position.z = height_;
+        pose.orientation.w = 1.0;
+        return true;
+    }
+
+    double BinStager::footprint(const std::string& part_type) const
+    {
+        double largest{ 0.0 };
+        for (auto& entry : part_sizes_) {
+            double side = std::max(entry.second.at(0), entry.second.at(1));
+            if (!part_type.empty() && part_type.find(entry.first) != std::string::npos)
+                return side + clearance_;
+            largest = std::max(largest, side);
+        }
+        // unknown type: room for any part
+        return largest + clearance_;
+    }
+
+    std::vector<BinStager::Box> BinStager::occupied(int bin) const
+    {
+        std::vector<Box> taken;
+        auto seen = seen_.find(bin);
+        if (seen != seen_.end())
+            taken = seen->second;
+        for (auto& reservation : reserved_) {
+            if (reservation.bin == bin)
+                taken.push_back(reservation.box);
+        }
+        return taken;
+    }
+
+    bool BinStager::fit(int bin, double size_x, double size_y, StagingRobot robot, const std::vector<Box>& taken,
+        Box& box) const
+    {
+        auto& center = centers_.at(bin);
+        // boxes already carry half the clearance on each side
+        double inset = wall_ + wall_margin_ - clearance_ / 2.0;
+        Box inner{ center.at(0) - size_.at(0) / 2.0 + inset, center.at(1) - size_.at(1) / 2.0 + inset,
+            center.at(0) + size_.at(0) / 2.0 - inset, center.at(1) + size_.at(1) / 2.0 - inset };
+
+        // a part goes against the wall or against another part
+        std::vector<double> edges_x{ inner.max_x }, edges_y{ inner.min_y };
+        for (auto& other : taken) {
+            edges_x.push_back(other.min_x);
+            edges_y.push_back(other.max_y);
+        }
+        std::sort(edges_x.rbegin(), edges_x.rend());
+        std::sort(edges_y.begin(), edges_y.end());
+
+        for (auto max_x : edges_x) {
+            for (auto min_y : edges_y) {
+                Box candidate{ max_x - size_x, min_y, max_x, min_y + size_y };
+                if (candidate.min_x < inner.min_x - epsilon || candidate.max_x > inner.max_x + epsilon ||
+                    candidate.min_y < inner.min_y - epsilon || candidate.max_y > inner.max_y + epsilon)
+                    continue;
+                bool overlaps = std::any_of(taken.begin(), taken.end(), [&candidate](const Box& other) {
+                    return candidate.min_x < other.max_x - epsilon && candidate.max_x > other.min_x + epsilon &&
+                        candidate.min_y < other.max_y - epsilon && candidate.max_y > other.min_y + epsilon;
+                });
+                if (overlaps)
+                    continue;
+                geometry_msgs::Pose middle;
+                middle.position.x = (candidate.min_x + candidate.max_x) / 2.0;
+                middle.position.y = (candidate.min_y + candidate.max_y) / 2.0;
+                if (!reachable(robot, middle))
+                    continue;
+                box = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+}//namespace
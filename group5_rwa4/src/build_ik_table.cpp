@@ -0,0 +1,121 @@
+/**
+ * @file build_ik_table.cpp
+ * @brief Offline build of the IK seed table used by Arm and Gantry
+ *
+ * Needs the robot description on the parameter server (the ARIAC launch file
+ * loads it), not the simulation itself:
+ *
+ *   rosrun group5_rwa4 build_ik_table /ariac/kitting/robot_description kitting_arm config/ik_table_kitting.yaml
+ *   rosrun group5_rwa4 build_ik_table /ariac/gantry/robot_description gantry_arm config/ik_table_gantry.yaml
+ *
+ * Options: --cell m, --yaw-step rad, --reach m, --z-min m, --z-max m
+ */
+#include <ros/ros.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <Eigen/Geometry>
+#include <cstdlib>
+#include "../include/arm/ik_table.h"
+
+namespace {
+  geometry_msgs::Pose to_msg(const Eigen::Isometry3d& transform)
+  {
+    Eigen::Quaterniond rotation(transform.rotation());
+    geometry_msgs::Pose pose;
+    pose.position.x = transform.translation().x();
+    pose.position.y = transform.translation().y();
+    pose.position.z = transform.translation().z();
+    pose.orientation.x = rotation.x();
+    pose.orientation.y = rotation.y();
+    pose.orientation.z = rotation.z();
+    pose.orientation.w = rotation.w();
+    return pose;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  ros::init(argc, argv, "build_ik_table");
+  if (argc < 4){
+    ROS_ERROR_STREAM("usage: build_ik_table <robot_description> <group> <output.yaml> "
+                     "[--cell m] [--yaw-step rad] [--reach m] [--z-min m] [--z-max m]");
+    return 1;
+  }
+  std::string description = argv[1];
+  std::string group = argv[2];
+  std::string output = argv[3];
+  double cell{0.05}, yaw_step{M_PI / 4}, reach{0.9}, z_min{-0.5}, z_max{0.3};
+  for (int i = 4; i + 1 < argc; i += 2){
+    std::string arg = argv[i];
+    double value = std::atof(argv[i + 1]);
+    if (arg == "--cell") cell = value;
+    else if (arg == "--yaw-step") yaw_step = value;
+    else if (arg == "--reach") reach = value;
+    else if (arg == "--z-min") z_min = value;
+    else if (arg == "--z-max") z_max = value;
+  }
+
+  robot_model_loader::RobotModelLoader loader(description);
+  auto model = loader.getModel();
+  if (!model){
+    ROS_ERROR_STREAM("[build_ik_table] No robot model at " << description);
+    return 1;
+  }
+  auto joint_model_group = model->getJointModelGroup(group);
+  if (joint_model_group == nullptr){
+    ROS_ERROR_STREAM("[build_ik_table] No group " << group);
+    return 1;
+  }
+  auto base = motioncontrol::IkTable::baseLink(joint_model_group);
+  if (base == nullptr){
+    ROS_ERROR_STREAM("[build_ik_table] " << group << " has no revolute joint");
+    return 1;
+  }
+
+  motioncontrol::IkTable table(cell, yaw_step);
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+  const Eigen::Isometry3d base_start = state.getGlobalLinkTransform(base);
+  const Eigen::Isometry3d wrist_down(Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitY()));
+  int yaw_bins = static_cast<int>(std::lround(2.0 * M_PI / yaw_step));
+  std::size_t tried{0};
+
+  // row by row, each solve seeded by the previous one keeps the arm in one configuration
+  for (double z = z_min; z <= z_max + 1e-9 && ros::ok(); z += cell){
+    for (double x = -reach; x <= reach + 1e-9; x += cell){
+      for (double y = -reach; y <= reach + 1e-9; y += cell){
+        double radius = std::hypot(x, y);
+        if (radius > reach || radius < 0.2){
+          continue;
+        }
+        for (int b = 0; b < yaw_bins; b++){
+          Eigen::Isometry3d local = Eigen::Translation3d(x, y, z) *
+            Eigen::AngleAxisd(b * yaw_step, Eigen::Vector3d::UnitZ()) * wrist_down;
+          tried++;
+          if (!state.setFromIK(joint_model_group, to_msg(base_start * local), 0.02)){
+            continue;
+          }
+          state.update();
+          // the rail/torso may have moved during IK, key on the pose relative to where the base ended up
+          auto reached = state.getGlobalLinkTransform(base).inverse() * base_start * local;
+          std::vector<double> joints;
+          bool arm_joint{false};
+          for (auto joint : joint_model_group->getActiveJointModels()){
+            arm_joint = arm_joint || joint->getType() == moveit::core::JointModel::REVOLUTE;
+            if (arm_joint){
+              joints.push_back(state.getVariablePosition(joint->getFirstVariableIndex()));
+            }
+          }
+          table.insert(to_msg(reached), joints);
+        }
+      }
+    }
+    ROS_INFO_STREAM("[build_ik_table] z " << z << ": " << table.size() << " entries from " << tried << " poses");
+  }
+
+  if (!table.save(output)){
+    return 1;
+  }
+  ROS_INFO_STREAM("[build_ik_table] " << table.size() << " entries written to " << output);
+  return 0;
+}
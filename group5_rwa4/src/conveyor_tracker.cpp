@@ -0,0 +1,134 @@
+#include "../include/camera/conveyor_tracker.h"
+#include <algorithm>
+
+namespace motioncontrol {
+    namespace {
+        Eigen::Isometry3d toIsometry(const geometry_msgs::Pose& pose)
+        {
+            return Eigen::Translation3d(pose.position.x, pose.position.y, pose.position.z) *
+                Eigen::Quaterniond(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+        }
+
+        geometry_msgs::Pose toPose(const Eigen::Isometry3d& transform)
+        {
+            geometry_msgs::Pose pose;
+            Eigen::Quaterniond rotation(transform.rotation());
+            pose.position.x = transform.translation().x();
+            pose.position.y = transform.translation().y();
+            pose.position.z = transform.translation().z();
+            pose.orientation.x = rotation.x();
+            pose.orientation.y = rotation.y();
+            pose.orientation.z = rotation.z();
+            pose.orientation.w = rotation.w();
+            return pose;
+        }
+
+        Eigen::Vector3d position(const geometry_msgs::Pose& pose)
+        {
+            return Eigen::Vector3d(pose.position.x, pose.position.y, pose.position.z);
+        }
+    }
+
+    geometry_msgs::Pose ConveyorTrack::predict(const ros::Time& time) const
+    {
+        geometry_msgs::Pose predicted = pose;
+        double dt = (time - stamp).toSec();
+        predicted.position.x += velocity.x() * dt;
+        predicted.position.y += velocity.y() * dt;
+        predicted.position.z += velocity.z() * dt;
+        return predicted;
+    }
+
+    void ConveyorTracker::init(ros::NodeHandle& node, const std::string& topic, double max_age)
+    {
+        max_age_ = max_age;
+        subscriber_ = node.subscribe(topic, 10, &ConveyorTracker::callback, this);
+    }
+
+    void ConveyorTracker::callback(const nist_gear::LogicalCameraImage::ConstPtr& msg)
+    {
+        // the message has no header, it is stamped on arrival
+        ros::Time now = ros::Time::now();
+        Eigen::Isometry3d camera = toIsometry(msg->pose);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<bool> matched(tracks_.size(), false);
+        for (auto& model : msg->models) {
+            auto pose = toPose(camera * toIsometry(model.pose));
+            // closest prediction of the same type, within a few centimeters
+            int closest{ -1 };
+            double best{ 0.05 };
+            for (std::size_t i{ 0 }; i < tracks_.size(); i++) {
+                if (matched.at(i) || tracks_.at(i).type != model.type)
+                    continue;
+                double d = (position(tracks_.at(i).predict(now)) - position(pose)).norm();
+                if (d < best) {
+                    best = d;
+                    closest = static_cast<int>(i);
+                }
+            }
+
+            if (closest < 0) {
+                ConveyorTrack track;
+                track.id = next_id_++;
+                track.type = model.type;
+                track.pose = pose;
+                track.stamp = now;
+                track.sightings = 1;
+                tracks_.push_back(track);
+                matched.push_back(true);
+                continue;
+            }
+
+            auto& track = tracks_.at(closest);
+            matched.at(closest) = true;
+            double dt = (now - track.stamp).toSec();
+            if (dt < 0.05)
+                continue;
+            // the belt speed is constant, smoothing only removes the camera jitter
+            Eigen::Vector3d velocity = (position(pose) - position(track.pose)) / dt;
+            track.velocity = track.sightings == 1 ? velocity : 0.7 * track.velocity + 0.3 * velocity;
+            track.pose = pose;
+            track.stamp = now;
+            track.sightings++;
+        }
+
+        tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [this, now](const ConveyorTrack& track) {
+            return (now - track.stamp).toSec() > max_age_;
+        }), tracks_.end());
+        updates_++;
+        changed_.notify_all();
+    }
+
+    std::vector<ConveyorTrack> ConveyorTracker::tracks() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<ConveyorTrack> moving;
+        for (auto& track : tracks_) {
+            if (track.sightings > 1)
+                moving.push_back(track);
+        }
+        return moving;
+    }
+
+    bool ConveyorTracker::waitForUpdate(const ros::Time& deadline) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        unsigned long updates = updates_;
+        while (updates_ == updates && ros::ok()) {
+            double left = (deadline - ros::Time::now()).toSec();
+            if (left <= 0.0)
+                return false;
+            changed_.wait_for(lock, std::chrono::milliseconds(static_cast<int>(std::min(left, 0.1) * 1000.0) + 1));
+        }
+        return updates_ != updates;
+    }
+
+    void ConveyorTracker::remove(unsigned int id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [id](const ConveyorTrack& track) {
+            return track.id == id;
+        }), tracks_.end());
+    }
+}//namespace
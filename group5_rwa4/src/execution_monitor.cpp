@@ -0,0 +1,116 @@
+#include "../include/arm/execution_monitor.h"
+#include "../include/trace/trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+namespace motioncontrol {
+    namespace {
+        double largest(const std::vector<double>& values)
+        {
+            double result{ 0.0 };
+            for (auto value : values)
+                result = std::max(result, std::abs(value));
+            return result;
+        }
+    }
+
+    void ExecutionMonitor::init(const MonitorOptions& options)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = options;
+        controllers_.clear();
+    }
+
+    void ExecutionMonitor::onFault(std::function<void(const std::string&)> callback)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fault_callback_ = callback;
+    }
+
+    void ExecutionMonitor::update(const std::string& controller, const control_msgs::JointTrajectoryControllerState& state)
+    {
+        std::string fault;
+        std::function<void(const std::string&)> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ros::Time now = ros::Time::now();
+            Controller& entry = controllers_[controller];
+            entry.stamp = now;
+            entry.error = largest(state.error.positions);
+            entry.velocity = largest(state.actual.velocities);
+            entry.desired_velocity = largest(state.desired.velocities);
+
+            bool commanded = entry.desired_velocity > options_.stall_velocity;
+            if (commanded && entry.velocity < options_.stall_velocity && entry.error > options_.settle_error) {
+                if (entry.still_since.isZero())
+                    entry.still_since = now;
+            }
+            else
+                entry.still_since = ros::Time();
+
+            Status status = classify(entry, now);
+            if ((status == Status::FAULT || status == Status::STALLED) && !entry.reported) {
+                entry.reported = true;
+                std::ostringstream reason;
+                reason << controller << (status == Status::FAULT ? " tracking error " : " stalled, error ") << entry.error;
+                fault = reason.str();
+                callback = fault_callback_;
+            }
+            // the next motion is watched again once this one is over
+            if (!commanded && entry.error < options_.settle_error)
+                entry.reported = false;
+        }
+        changed_.notify_all();
+        if (!fault.empty()) {
+            ROS_ERROR_STREAM("[ExecutionMonitor][update] " << fault);
+            if (callback)
+                callback(fault);
+        }
+    }
+
+    ExecutionMonitor::Status ExecutionMonitor::status() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ros::Time now = ros::Time::now();
+        Status result = Status::NO_STATE;
+        for (auto& entry : controllers_) {
+            Status status = classify(entry.second, now);
+            if (static_cast<int>(status) > static_cast<int>(result))
+                result = status;
+        }
+        return result;
+    }
+
+    bool ExecutionMonitor::waitSettled(const ros::Time& deadline)
+    {
+        tracing::Span span("wait", "settle");
+        while (ros::ok()) {
+            Status current = status();
+            if (current == Status::SETTLED)
+                return true;
+            if (current == Status::FAULT || current == Status::STALLED)
+                return false;
+            if (ros::Time::now() >= deadline)
+                return current == Status::NO_STATE;
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait_for(lock, std::chrono::milliseconds(20));
+        }
+        return false;
+    }
+
+    ExecutionMonitor::Status ExecutionMonitor::classify(const Controller& controller, const ros::Time& now) const
+    {
+        if (controller.stamp.isZero() || (now - controller.stamp).toSec() > options_.max_age)
+            return Status::NO_STATE;
+        if (controller.error > options_.fault_error)
+            return Status::FAULT;
+        if (!controller.still_since.isZero() && (now - controller.still_since).toSec() > options_.stall_time)
+            return Status::STALLED;
+        if (controller.error < options_.settle_error && controller.velocity < options_.settle_velocity &&
+            controller.desired_velocity < options_.settle_velocity)
+            return Status::SETTLED;
+        return Status::MOVING;
+    }
+}//namespace
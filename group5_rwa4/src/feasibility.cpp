@@ -0,0 +1,91 @@
+#include "../include/planner/feasibility.h"
+
+namespace motioncontrol {
+    const ShipmentPlan* FeasibilityPlan::find(const std::string& shipment_type) const
+    {
+        for (auto& shipment : shipments) {
+            if (shipment.shipment_type == shipment_type)
+                return &shipment;
+        }
+        return nullptr;
+    }
+
+    void FeasibilityAnalyzer::markShipped(const std::string& shipment_type)
+    {
+        shipped_.insert(shipment_type);
+    }
+
+    FeasibilityPlan FeasibilityAnalyzer::analyse(const std::vector<Order>& orders,
+        const std::map<std::string, std::vector<Product> >& inventory) const
+    {
+        // parts still usable, per type: free in the bins, spares and picked parts left out
+        std::map<std::string, int> stock;
+        for (auto& parts : inventory) {
+            for (auto& part : parts.second) {
+                if (part.status.compare("free") == 0 && part.camera.rfind("logical_camera_bins", 0) == 0)
+                    stock[parts.first]++;
+            }
+        }
+
+        // highest priority first, announcement order otherwise
+        std::vector<const Order*> by_priority;
+        for (auto& order : orders)
+            by_priority.push_back(&order);
+        std::stable_sort(by_priority.begin(), by_priority.end(),
+            [](const Order* a, const Order* b) { return a->priority > b->priority; });
+
+        FeasibilityPlan plan;
+        for (auto order : by_priority) {
+            std::vector<const Kitting*> kits;
+            for (auto& kit : order->kitting) {
+                if (shipped_.count(kit.shipment_type) == 0)
+                    kits.push_back(&kit);
+            }
+
+            // shipments needing the fewest missing parts first
+            auto missing_with = [&stock](const Kitting* kit) {
+                std::map<std::string, int> left = stock;
+                std::size_t missing{ 0 };
+                for (auto& product : kit->products) {
+                    if (!product.processed && left[product.type]-- <= 0)
+                        missing++;
+                }
+                return missing;
+            };
+            std::vector<std::pair<std::size_t, const Kitting*> > ranked;
+            for (auto kit : kits)
+                ranked.emplace_back(missing_with(kit), kit);
+            std::stable_sort(ranked.begin(), ranked.end(),
+                [](const std::pair<std::size_t, const Kitting*>& a, const std::pair<std::size_t, const Kitting*>& b) {
+                    return a.first < b.first;
+                });
+
+            for (auto& entry : ranked) {
+                ShipmentPlan shipment;
+                shipment.order_id = order->order_id;
+                shipment.shipment_type = entry.second->shipment_type;
+                for (auto& product : entry.second->products) {
+                    // already on the AGV
+                    if (product.processed) {
+                        shipment.available.push_back(true);
+                        continue;
+                    }
+                    auto& count = stock[product.type];
+                    if (count > 0) {
+                        count--;
+                        shipment.available.push_back(true);
+                    }
+                    else {
+                        shipment.available.push_back(false);
+                        shipment.missing++;
+                        plan.shortfall[product.type]++;
+                    }
+                }
+                shipment.ship = shipment.missing < shipment.available.size();
+                shipment.partial = shipment.ship && shipment.missing > 0;
+                plan.shipments.push_back(shipment);
+            }
+        }
+        return plan;
+    }
+}//namespace
@@ -0,0 +1,203 @@
+#include "../include/executor/flip_scheduler.h"
+#include "../include/trace/trace.h"
+#include <algorithm>
+
+namespace motioncontrol {
+    namespace {
+        const std::string kitting_arm{ "kitting_arm" };
+        const std::string gantry{ "gantry" };
+
+        bool kittingBin(int bin)
+        {
+            return bin == 1 || bin == 2 || bin == 5 || bin == 6;
+        }
+    }
+
+    const char* toString(FlipStrategy strategy)
+    {
+        switch (strategy) {
+        case FlipStrategy::ARM_REGRASP:
+            return "arm_regrasp";
+        case FlipStrategy::GANTRY_REGRASP:
+            return "gantry_regrasp";
+        case FlipStrategy::HANDOVER:
+            return "handover";
+        }
+        return "unknown";
+    }
+
+    FlipScheduler::FlipScheduler(Arm& arm, gantry_motioncontrol::Gantry& gantry) : arm_(arm), gantry_(gantry)
+    {
+        // pick, turn over in the bin and place, until measured
+        durations_ = {
+            { "arm_regrasp", 45.0 },
+            { "gantry_regrasp", 55.0 },
+            { "gantry_handover", 20.0 },
+            { "arm_from_handover", 35.0 }
+        };
+    }
+
+    FlipScheduler::~FlipScheduler()
+    {
+        // before the members the flips lock and notify are gone
+        workers_.join();
+    }
+
+    FlipStrategy FlipScheduler::choose(const Product& part) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ros::Time now = ros::Time::now();
+        ros::Time by_gantry = readyAt(gantry, now) + ros::Duration(estimate("gantry_regrasp"));
+        // the gantry reaches every bin, the arm only the ones next to its rail
+        if (kittingBin(part.bin_number)) {
+            ros::Time by_arm = readyAt(kitting_arm, now) + ros::Duration(estimate("arm_regrasp"));
+            return by_arm <= by_gantry ? FlipStrategy::ARM_REGRASP : FlipStrategy::GANTRY_REGRASP;
+        }
+        ros::Time handed = readyAt(gantry, now) + ros::Duration(estimate("gantry_handover"));
+        ros::Time by_handover = std::max(handed, readyAt(kitting_arm, now)) + ros::Duration(estimate("arm_from_handover"));
+        return by_handover < by_gantry ? FlipStrategy::HANDOVER : FlipStrategy::GANTRY_REGRASP;
+    }
+
+    std::shared_future<bool> FlipScheduler::start(const Product& part, const geometry_msgs::Pose& target_in_frame,
+        const std::string& agv, const std::vector<int>& empty_bins)
+    {
+        FlipStrategy strategy = choose(part);
+        std::shared_future<bool> result;
+        std::vector<Stage> stages;
+        switch (strategy) {
+        case FlipStrategy::ARM_REGRASP:
+            stages.push_back(Stage{ kitting_arm, "arm_regrasp", [this, part, target_in_frame, agv, empty_bins]() {
+                return arm_.flippart(part, empty_bins, target_in_frame, agv, true);
+            } });
+            break;
+        case FlipStrategy::GANTRY_REGRASP:
+            stages.push_back(Stage{ gantry, "gantry_regrasp", [this, part, target_in_frame, agv, empty_bins]() {
+                return gantry_.flippart(part, empty_bins, target_in_frame, agv, true);
+            } });
+            break;
+        case FlipStrategy::HANDOVER: {
+            // the bin the arm flips in when it did not pick the part itself
+            int bin_selected = 2;
+            for (auto bin : empty_bins) {
+                if (kittingBin(bin)) {
+                    bin_selected = bin;
+                    break;
+                }
+            }
+            stages.push_back(Stage{ gantry, "gantry_handover", [this, part, bin_selected]() {
+                gantry_.move_gantry_to_bin(part.bin_number);
+                return gantry_.movePartfrombin(part.world_pose, part.type, bin_selected);
+            } });
+            stages.push_back(Stage{ kitting_arm, "arm_from_handover", [this, part, target_in_frame, agv, empty_bins]() {
+                return arm_.flippart(part, empty_bins, target_in_frame, agv, false);
+            } });
+            break;
+        }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // a stage starts once the previous one is over and its robot is free
+            ros::Time end = ros::Time::now();
+            for (auto& stage : stages) {
+                end = std::max(end, readyAt(stage.robot, end)) + ros::Duration(estimate(stage.name));
+                free_at_[stage.robot] = end;
+                pending_[stage.robot]++;
+            }
+            ROS_INFO_STREAM("[FlipScheduler][start] " << part.type << " from bin " << part.bin_number << " by "
+                << toString(strategy) << ", on " << agv << " in about " << (end - ros::Time::now()).toSec() << " s");
+            auto placed = std::make_shared<std::promise<bool> >();
+            result = placed->get_future().share();
+            workers_.start([this, stages, placed]() { run(stages, *placed); });
+        }
+        return result;
+    }
+
+    void FlipScheduler::waitFor(const std::string& robot)
+    {
+        tracing::Span span("wait", "flip");
+        span.arg("robot", robot);
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this, &robot]() { return pending_[robot] == 0; });
+    }
+
+    bool FlipScheduler::idle(const std::string& robot) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = pending_.find(robot);
+        return found == pending_.end() || found->second == 0;
+    }
+
+    void FlipScheduler::waitAll()
+    {
+        tracing::Span span("wait", "flip");
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() {
+            return std::all_of(pending_.begin(), pending_.end(), [](const std::pair<const std::string, int>& entry) {
+                return entry.second == 0;
+            });
+        });
+    }
+
+    void FlipScheduler::run(const std::vector<Stage>& stages, std::promise<bool>& placed)
+    {
+        bool ok{ true };
+        for (auto& stage : stages) {
+            if (!ok) {
+                // the stages after a failed one are dropped, their robot is free
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    pending_[stage.robot]--;
+                    if (pending_[stage.robot] == 0)
+                        free_at_[stage.robot] = ros::Time::now();
+                }
+                changed_.notify_all();
+                continue;
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                changed_.wait(lock, [this, &stage]() { return !running_[stage.robot]; });
+                running_[stage.robot] = true;
+            }
+            ros::Time begin = ros::Time::now();
+            try {
+                tracing::Span span("flip", stage.name);
+                ok = stage.run();
+            }
+            catch (const std::exception& e) {
+                ROS_ERROR_STREAM("[FlipScheduler][run] " << stage.name << ": " << e.what());
+                ok = false;
+            }
+            if (!ok)
+                ROS_ERROR_STREAM("[FlipScheduler][run] " << stage.name << " failed, the part is not on its tray");
+            double took = (ros::Time::now() - begin).toSec();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                running_[stage.robot] = false;
+                pending_[stage.robot]--;
+                if (pending_[stage.robot] == 0)
+                    free_at_[stage.robot] = ros::Time::now();
+                // recent flips weigh more, the defaults are only a first guess
+                double& duration = durations_[stage.name];
+                duration = measured_[stage.name] ? 0.5 * (duration + took) : took;
+                measured_[stage.name] = true;
+            }
+            changed_.notify_all();
+        }
+        placed.set_value(ok);
+    }
+
+    double FlipScheduler::estimate(const char* stage) const
+    {
+        auto found = durations_.find(stage);
+        return found == durations_.end() ? 0.0 : found->second;
+    }
+
+    ros::Time FlipScheduler::readyAt(const std::string& robot, const ros::Time& now) const
+    {
+        auto found = free_at_.find(robot);
+        if (found == free_at_.end())
+            return now;
+        return std::max(now, found->second);
+    }
+}//namespace
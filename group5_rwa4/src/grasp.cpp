@@ -0,0 +1,220 @@
+#include "../include/arm/grasp.h"
+#include "../include/trace/trace.h"
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <trajectory_msgs/JointTrajectory.h>
+#include <chrono>
+#include <cmath>
+#include <future>
+
+namespace motioncontrol {
+    using moveit::planning_interface::MoveGroupInterface;
+    using moveit::planning_interface::MoveItErrorCode;
+
+    GraspOptions graspOptions(const MotionProfiles& profiles, const std::string& part_type, MotionPhase descent)
+    {
+        GraspOptions options;
+        options.approach = profiles.select(MotionPhase::APPROACH, part_type);
+        options.descent = profiles.select(descent, part_type);
+        options.retreat = profiles.select(MotionPhase::LOADED_TRANSIT, part_type);
+        return options;
+    }
+
+    GraspPrimitive::GraspPrimitive(MoveGroupInterface& group, Gripper& gripper, const GraspOptions& options,
+        const JointStateCache* joint_states)
+        : group_(group), gripper_(gripper), options_{ options }, joint_states_{ joint_states }
+    {
+    }
+
+    bool GraspPrimitive::cartesian(const moveit::core::RobotState& start, const std::vector<geometry_msgs::Pose>& waypoints,
+        const MotionProfile& profile, robot_trajectory::RobotTrajectory& trajectory)
+    {
+        moveit_msgs::RobotTrajectory msg;
+        group_.setStartState(start);
+        double fraction = group_.computeCartesianPath(waypoints, options_.eef_step, 0.0, msg);
+        group_.setStartStateToCurrentState();
+        if (fraction < 1.0) {
+            ROS_WARN_STREAM("[GraspPrimitive][cartesian] " << fraction * 100.0 << "% of the path achieved");
+            return false;
+        }
+        trajectory.setRobotTrajectoryMsg(start, msg);
+        // move_group times Cartesian paths at full speed, whatever the group scaling
+        trajectory_processing::IterativeParabolicTimeParameterization time_parameterization;
+        return time_parameterization.computeTimeStamps(trajectory, profile.velocity, profile.acceleration);
+    }
+
+    bool GraspPrimitive::approach(const geometry_msgs::Pose& above, const geometry_msgs::Pose& target,
+        robot_trajectory::RobotTrajectory& trajectory)
+    {
+        auto start = latestState(joint_states_, group_);
+        if (!cartesian(*start, { above }, options_.approach, trajectory)) {
+            // no straight line to the pose above, let the planner find the way
+            MoveGroupInterface::Plan plan;
+            options_.approach.apply(group_);
+            group_.setPoseTarget(above);
+            if (group_.plan(plan) != MoveItErrorCode::SUCCESS) {
+                ROS_ERROR_STREAM("[GraspPrimitive][approach] No plan to the pose above the target");
+                return false;
+            }
+            trajectory.setRobotTrajectoryMsg(*start, plan.trajectory_);
+        }
+
+        robot_trajectory::RobotTrajectory descent(group_.getRobotModel(), group_.getName());
+        if (!cartesian(trajectory.getLastWayPoint(), { target }, options_.descent, descent))
+            return false;
+        // both pieces start and end at rest, the repeated waypoint only holds the pose briefly
+        trajectory.append(descent, 0.01);
+        return true;
+    }
+
+    bool GraspPrimitive::execute(const robot_trajectory::RobotTrajectory& trajectory, bool stop_on_attach)
+    {
+        MoveGroupInterface::Plan plan;
+        trajectory.getRobotTrajectoryMsg(plan.trajectory_);
+        auto execution = std::async(std::launch::async, [this, &plan]() {
+            return group_.execute(plan) == MoveItErrorCode::SUCCESS;
+        });
+        if (stop_on_attach) {
+            while (execution.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+                if (gripper_.attached()) {
+                    group_.stop();
+                    execution.wait();
+                    return true;
+                }
+            }
+        }
+        return execution.get();
+    }
+
+    bool GraspPrimitive::pick(const geometry_msgs::Pose& pregrasp, const geometry_msgs::Pose& bottom,
+        const std::vector<geometry_msgs::Pose>& retreat)
+    {
+        tracing::Span span("grasp", "pick");
+        // suction comes on while the arm approaches
+        gripper_.enableAsync();
+        robot_trajectory::RobotTrajectory trajectory(group_.getRobotModel(), group_.getName());
+        if (!approach(pregrasp, bottom, trajectory))
+            return false;
+        execute(trajectory, true);
+
+        // the gripper state topic may lag the end of the motion
+        if (!gripper_.waitAttached(ros::Time::now() + ros::Duration(options_.attach_timeout))) {
+            ROS_WARN_STREAM("[GraspPrimitive][pick] Nothing attached at the end of the descent");
+            return false;
+        }
+
+        if (retreat.empty())
+            return true;
+        robot_trajectory::RobotTrajectory lift(group_.getRobotModel(), group_.getName());
+        if (cartesian(*latestState(joint_states_, group_), retreat, options_.retreat, lift) && execute(lift, false))
+            return true;
+        options_.retreat.apply(group_);
+        group_.setPoseTarget(retreat.back());
+        group_.move();
+        return true;
+    }
+
+    bool GraspPrimitive::place(const geometry_msgs::Pose& above, const geometry_msgs::Pose& release)
+    {
+        tracing::Span span("grasp", "place");
+        robot_trajectory::RobotTrajectory trajectory(group_.getRobotModel(), group_.getName());
+        if (!approach(above, release, trajectory))
+            return false;
+        return execute(trajectory, false);
+    }
+
+    bool GraspPrimitive::guardedMove(const ros::Publisher& command, const Eigen::Vector3d& direction, double max_distance)
+    {
+        tracing::Span span("grasp", "guarded_move");
+        auto state = latestState(joint_states_, group_);
+        auto joint_model_group = state->getJointModelGroup(group_.getName());
+        const std::string& tip = group_.getEndEffectorLink();
+        Eigen::Isometry3d pose = state->getGlobalLinkTransform(tip);
+        Eigen::Vector3d step = direction.normalized() * options_.stream_speed * options_.stream_period;
+
+        trajectory_msgs::JointTrajectory trajectory;
+        trajectory.joint_names = joint_model_group->getActiveJointModelNames();
+        trajectory.points.resize(1);
+        trajectory.points.front().time_from_start = ros::Duration(options_.stream_period);
+        for (double travelled{ 0.0 }; travelled < max_distance; travelled += step.norm()) {
+            pose.translation() += step;
+            // seeded with the previous command, the solution stays next to it
+            if (!state->setFromIK(joint_model_group, pose, tip, options_.stream_period)) {
+                ROS_WARN_STREAM("[GraspPrimitive][guardedMove] No IK " << travelled << " m along the move");
+                break;
+            }
+            state->copyJointGroupPositions(joint_model_group, trajectory.points.front().positions);
+            // each command replaces the previous one in the controller
+            command.publish(trajectory);
+            if (gripper_.waitAttached(ros::Time::now() + ros::Duration(options_.stream_period)))
+                return true;
+        }
+        return gripper_.waitAttached(ros::Time::now() + ros::Duration(options_.attach_timeout));
+    }
+
+    geometry_msgs::Pose GraspPrimitive::trackingHover(const geometry_msgs::Pose& contact, const Eigen::Vector3d& velocity) const
+    {
+        geometry_msgs::Pose hover = contact;
+        hover.position.x -= velocity.x() * options_.track_descent;
+        hover.position.y -= velocity.y() * options_.track_descent;
+        hover.position.z += options_.track_hover - velocity.z() * options_.track_descent;
+        return hover;
+    }
+
+    bool GraspPrimitive::trackingPick(const ros::Publisher& command, const geometry_msgs::Pose& contact,
+        const Eigen::Vector3d& velocity, const ros::Time& contact_time)
+    {
+        tracing::Span span("grasp", "tracking_pick");
+        auto state = latestState(joint_states_, group_);
+        auto joint_model_group = state->getJointModelGroup(group_.getName());
+        const std::string& tip = group_.getEndEffectorLink();
+        Eigen::Isometry3d contact_pose = Eigen::Translation3d(contact.position.x, contact.position.y, contact.position.z) *
+            Eigen::Quaterniond(contact.orientation.w, contact.orientation.x, contact.orientation.y, contact.orientation.z);
+
+        // times relative to the contact: down, ride along, lift
+        double start = -options_.track_descent;
+        double end = options_.track_dwell + options_.track_lift_time;
+        trajectory_msgs::JointTrajectory trajectory;
+        trajectory.joint_names = joint_model_group->getActiveJointModelNames();
+        for (double t{ start }; t < end + options_.track_period / 2.0; t += options_.track_period) {
+            double height{ 0.0 };
+            if (t < 0.0)
+                height = options_.track_hover * 0.5 * (1.0 + std::cos(M_PI * (t - start) / options_.track_descent));
+            else if (t > options_.track_dwell)
+                height = options_.track_lift * 0.5 * (1.0 - std::cos(M_PI * (t - options_.track_dwell) / options_.track_lift_time));
+            Eigen::Isometry3d pose = contact_pose;
+            pose.translation() += velocity * t + Eigen::Vector3d(0.0, 0.0, height);
+            // seeded with the previous point, the solutions stay on one branch
+            if (!state->setFromIK(joint_model_group, pose, tip, options_.track_period)) {
+                ROS_WARN_STREAM("[GraspPrimitive][trackingPick] No IK " << t << " s from the contact");
+                return false;
+            }
+            trajectory_msgs::JointTrajectoryPoint point;
+            state->copyJointGroupPositions(joint_model_group, point.positions);
+            point.time_from_start = ros::Duration(t - start);
+            trajectory.points.push_back(point);
+        }
+
+        // velocities from the neighbours, the controller then follows the part smoothly
+        auto& points = trajectory.points;
+        for (std::size_t i{ 0 }; i < points.size(); i++) {
+            points.at(i).velocities.assign(points.at(i).positions.size(), 0.0);
+            if (i == 0 || i + 1 == points.size())
+                continue;
+            for (std::size_t j{ 0 }; j < points.at(i).positions.size(); j++)
+                points.at(i).velocities.at(j) = (points.at(i + 1).positions.at(j) - points.at(i - 1).positions.at(j)) /
+                    (2.0 * options_.track_period);
+        }
+
+        trajectory.header.stamp = contact_time + ros::Duration(start);
+        if (trajectory.header.stamp < ros::Time::now()) {
+            ROS_WARN_STREAM("[GraspPrimitive][trackingPick] " << (ros::Time::now() - trajectory.header.stamp).toSec()
+                << " s late for the part");
+            return false;
+        }
+        command.publish(trajectory);
+        bool attached = gripper_.waitAttached(contact_time + ros::Duration(end + options_.attach_timeout));
+        // the lift is still running once the part is on, the next motion must not cut it
+        (contact_time + ros::Duration(end) - ros::Time::now()).sleep();
+        return attached;
+    }
+}//namespace
@@ -0,0 +1,83 @@
+#include "../include/arm/grasp_offsets.h"
+#include <ros/ros.h>
+#include <yaml-cpp/yaml.h>
+
+namespace motioncontrol {
+    namespace {
+        GraspOffset read(const YAML::Node& node, GraspOffset offset)
+        {
+            offset.contact = node["contact"].as<double>(offset.contact);
+            offset.hover = node["hover"].as<double>(offset.hover);
+            offset.search = node["search"].as<double>(offset.search);
+            offset.guard = node["guard"].as<double>(offset.guard);
+            return offset;
+        }
+    }
+
+    GraspOffsets::GraspOffsets()
+    {
+        // heights the kitting arm used before the table existed
+        parts_ = {
+            { "pump", GraspOffset{ 0.08 } }, { "regulator", GraspOffset{ 0.05 } },
+            { "sensor", GraspOffset{ 0.04 } }, { "battery", GraspOffset{ 0.03 } }
+        };
+        release_ = {
+            { ReleaseSite::TRAY, 0.15 }, { ReleaseSite::BRIEFCASE, 0.05 }, { ReleaseSite::BIN, 0.2 }
+        };
+    }
+
+    bool GraspOffsets::load(const std::string& path)
+    {
+        GraspOffset loaded_default(default_);
+        std::map<std::string, GraspOffset> loaded_parts;
+        std::map<ReleaseSite, double> loaded_release(release_);
+        try {
+            YAML::Node root = YAML::LoadFile(path);
+            if (root["default"])
+                loaded_default = read(root["default"], loaded_default);
+            for (auto part : root["parts"])
+                loaded_parts[part.first.as<std::string>()] = read(part.second, loaded_default);
+            YAML::Node release = root["release"];
+            if (release) {
+                loaded_release[ReleaseSite::TRAY] = release["tray"].as<double>(loaded_release[ReleaseSite::TRAY]);
+                loaded_release[ReleaseSite::BRIEFCASE] =
+                    release["briefcase"].as<double>(loaded_release[ReleaseSite::BRIEFCASE]);
+                loaded_release[ReleaseSite::BIN] = release["bin"].as<double>(loaded_release[ReleaseSite::BIN]);
+            }
+        }
+        catch (const YAML::Exception& e) {
+            ROS_ERROR_STREAM("[GraspOffsets][load] " << path << ": " << e.what());
+            return false;
+        }
+        default_ = loaded_default;
+        parts_ = loaded_parts;
+        release_ = loaded_release;
+        ROS_INFO_STREAM("[GraspOffsets][load] " << parts_.size() << " part types from " << path);
+        return true;
+    }
+
+    GraspOffset GraspOffsets::select(const std::string& part_type) const
+    {
+        if (!part_type.empty()) {
+            for (auto& part : parts_) {
+                if (part_type.find(part.first) != std::string::npos)
+                    return part.second;
+            }
+        }
+        return default_;
+    }
+
+    double GraspOffsets::release(ReleaseSite site) const
+    {
+        return release_.at(site);
+    }
+
+    ReleaseSite GraspOffsets::site(const std::string& location)
+    {
+        if (location.find("agv") == 0)
+            return ReleaseSite::TRAY;
+        if (location.find("bin") == 0)
+            return ReleaseSite::BIN;
+        return ReleaseSite::BRIEFCASE;
+    }
+}//namespace
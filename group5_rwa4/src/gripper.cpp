@@ -0,0 +1,118 @@
+#include "../include/arm/gripper.h"
+#include "../include/trace/trace.h"
+#include <chrono>
+
+namespace motioncontrol {
+    void Gripper::init(ros::NodeHandle& node, const std::string& prefix)
+    {
+        state_subscriber_ = node.subscribe(prefix + "/state", 10, &Gripper::state_callback, this);
+        control_client_ = node.serviceClient<nist_gear::VacuumGripperControl>(prefix + "/control");
+        control_client_.waitForExistence();
+    }
+
+    void Gripper::state_callback(const nist_gear::VacuumGripperState::ConstPtr& msg)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_ = *msg;
+            reports_++;
+        }
+        changed_.notify_all();
+    }
+
+    nist_gear::VacuumGripperState Gripper::state() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_;
+    }
+
+    bool Gripper::enabled() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_.enabled;
+    }
+
+    bool Gripper::attached() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_.attached;
+    }
+
+    bool Gripper::call(bool enable)
+    {
+        nist_gear::VacuumGripperControl srv;
+        srv.request.enable = enable;
+        if (!control_client_.call(srv)) {
+            ROS_ERROR_STREAM("[Gripper][call] " << control_client_.getService() << " failed");
+            return false;
+        }
+        return srv.response.success;
+    }
+
+    void Gripper::enableAsync()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_.enabled)
+            return;
+        if (request_.valid()) {
+            if (request_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return;
+            // answered, give the state topic time to report it before asking again
+            if (ros::Time::now() - requested_ < ros::Duration(0.5))
+                return;
+        }
+        requested_ = ros::Time::now();
+        request_ = std::async(std::launch::async, &Gripper::call, this, true);
+    }
+
+    void Gripper::disable()
+    {
+        if (!call(false))
+            return;
+        // the part drops when the call returns, do not wait for the state topic to say so
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_.enabled = false;
+            state_.attached = false;
+            reports_at_disable_ = reports_;
+        }
+        changed_.notify_all();
+    }
+
+    bool Gripper::waitEnabled(const ros::Time& deadline)
+    {
+        tracing::Span span("gripper", "wait_enabled");
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!state_.enabled) {
+            if (ros::Time::now() >= deadline) {
+                ROS_ERROR_STREAM("[Gripper][waitEnabled] Gripper still disabled");
+                return false;
+            }
+            lock.unlock();
+            // a no-op unless the previous request did not take
+            enableAsync();
+            lock.lock();
+            changed_.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        return true;
+    }
+
+    bool Gripper::waitAttached(const ros::Time& deadline)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // ros::Time may be simulated, wake up regularly to compare against it
+        while (!state_.attached && ros::Time::now() < deadline)
+            changed_.wait_for(lock, std::chrono::milliseconds(5));
+        return state_.attached;
+    }
+
+    bool Gripper::waitReleased(const ros::Time& deadline)
+    {
+        tracing::Span span("gripper", "wait_released");
+        std::unique_lock<std::mutex> lock(mutex_);
+        // disable() clears the state itself, only a report received after it tells the part has dropped
+        while ((reports_ == reports_at_disable_ || state_.attached) && ros::Time::now() < deadline)
+            changed_.wait_for(lock, std::chrono::milliseconds(5));
+        return reports_ != reports_at_disable_ && !state_.attached;
+    }
+}//namespace
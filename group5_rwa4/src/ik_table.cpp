@@ -0,0 +1,157 @@
+#include "../include/arm/ik_table.h"
+#include "../include/trace/trace.h"
+#include <ros/ros.h>
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Geometry>
+#include <cmath>
+#include <fstream>
+
+namespace motioncontrol {
+    IkTable::IkTable(double cell, double yaw_step)
+        : cell_{ cell }, yaw_step_{ yaw_step }
+    {
+    }
+
+    bool IkTable::make_key(const geometry_msgs::Pose& pose, Key& key) const
+    {
+        auto& q = pose.orientation;
+        // gripper x axis must point down, as with quaternionFromEuler(0, 1.57, yaw)
+        double x_axis_z = 2.0 * (q.x * q.z - q.w * q.y);
+        if (x_axis_z > -0.95)
+            return false;
+        double y_axis_x = 2.0 * (q.x * q.y - q.w * q.z);
+        double y_axis_y = 1.0 - 2.0 * (q.x * q.x + q.z * q.z);
+        double yaw = std::atan2(-y_axis_x, y_axis_y);
+
+        long yaw_bins = std::lround(2.0 * M_PI / yaw_step_);
+        key[0] = std::lround(pose.position.x / cell_);
+        key[1] = std::lround(pose.position.y / cell_);
+        key[2] = std::lround(pose.position.z / cell_);
+        key[3] = ((std::lround(yaw / yaw_step_) % yaw_bins) + yaw_bins) % yaw_bins;
+        return true;
+    }
+
+    const moveit::core::LinkModel* IkTable::baseLink(const moveit::core::JointModelGroup* group)
+    {
+        for (auto joint : group->getActiveJointModels()) {
+            if (joint->getType() == moveit::core::JointModel::REVOLUTE)
+                return joint->getParentLinkModel();
+        }
+        return nullptr;
+    }
+
+    bool IkTable::lookup(const geometry_msgs::Pose& pose, std::vector<double>& joints) const
+    {
+        Key key;
+        if (!make_key(pose, key))
+            return false;
+        auto entry = entries_.find(key);
+        if (entry == entries_.end())
+            return false;
+        joints = entry->second;
+        return true;
+    }
+
+    void IkTable::insert(const geometry_msgs::Pose& pose, const std::vector<double>& joints)
+    {
+        Key key;
+        if (make_key(pose, key))
+            entries_[key] = joints;
+    }
+
+    bool IkTable::solve(const moveit::core::RobotState& current, const std::string& group,
+        const geometry_msgs::Pose& pose, std::vector<double>& joints, double timeout) const
+    {
+        tracing::Span span("motion", "table_ik");
+        if (entries_.empty())
+            return false;
+        auto joint_model_group = current.getJointModelGroup(group);
+        if (joint_model_group == nullptr)
+            return false;
+        auto base = baseLink(joint_model_group);
+        if (base == nullptr)
+            return false;
+
+        moveit::core::RobotState state(current);
+        Eigen::Isometry3d world_pose = Eigen::Translation3d(pose.position.x, pose.position.y, pose.position.z) *
+            Eigen::Quaterniond(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+        Eigen::Isometry3d local = state.getGlobalLinkTransform(base).inverse() * world_pose;
+        Eigen::Quaterniond local_rotation(local.rotation());
+        geometry_msgs::Pose pose_in_base;
+        pose_in_base.position.x = local.translation().x();
+        pose_in_base.position.y = local.translation().y();
+        pose_in_base.position.z = local.translation().z();
+        pose_in_base.orientation.x = local_rotation.x();
+        pose_in_base.orientation.y = local_rotation.y();
+        pose_in_base.orientation.z = local_rotation.z();
+        pose_in_base.orientation.w = local_rotation.w();
+
+        std::vector<double> seed;
+        if (!lookup(pose_in_base, seed))
+            return false;
+
+        // seed the revolute joints, the rail/torso stay where they are
+        std::size_t k{ 0 };
+        bool arm_joint{ false };
+        for (auto joint : joint_model_group->getActiveJointModels()) {
+            arm_joint = arm_joint || joint->getType() == moveit::core::JointModel::REVOLUTE;
+            if (arm_joint && k < seed.size())
+                state.setVariablePosition(joint->getFirstVariableIndex(), seed.at(k++));
+        }
+        if (!state.setFromIK(joint_model_group, pose, timeout))
+            return false;
+        state.copyJointGroupPositions(joint_model_group, joints);
+        return true;
+    }
+
+    bool IkTable::load(const std::string& path)
+    {
+        entries_.clear();
+        YAML::Node root;
+        try {
+            root = YAML::LoadFile(path);
+            cell_ = root["cell"].as<double>();
+            yaw_step_ = root["yaw_step"].as<double>();
+            for (auto item : root["entries"]) {
+                Key key{ { item[0].as<long>(), item[1].as<long>(), item[2].as<long>(), item[3].as<long>() } };
+                std::vector<double> joints;
+                for (std::size_t i{ 4 }; i < item.size(); i++)
+                    joints.push_back(item[i].as<double>());
+                entries_[key] = joints;
+            }
+        }
+        catch (const YAML::Exception& e) {
+            ROS_ERROR_STREAM("[IkTable][load] " << path << ": " << e.what());
+            entries_.clear();
+            return false;
+        }
+        ROS_INFO_STREAM("[IkTable][load] " << entries_.size() << " entries from " << path);
+        return true;
+    }
+
+    bool IkTable::save(const std::string& path) const
+    {
+        YAML::Emitter out;
+        out << YAML::BeginMap;
+        out << YAML::Key << "cell" << YAML::Value << cell_;
+        out << YAML::Key << "yaw_step" << YAML::Value << yaw_step_;
+        out << YAML::Key << "entries" << YAML::Value << YAML::BeginSeq;
+        for (auto& entry : entries_) {
+            out << YAML::Flow << YAML::BeginSeq;
+            for (auto index : entry.first)
+                out << index;
+            for (auto joint : entry.second)
+                out << joint;
+            out << YAML::EndSeq;
+        }
+        out << YAML::EndSeq << YAML::EndMap;
+
+        std::ofstream file(path);
+        file << out.c_str() << std::endl;
+        if (!file) {
+            ROS_ERROR_STREAM("[IkTable][save] Failed writing " << path);
+            return false;
+        }
+        return true;
+    }
+}//namespace
@@ -0,0 +1,135 @@
+#include "../include/arm/joint_state_cache.h"
+#include <Eigen/Geometry>
+
+namespace motioncontrol {
+    void JointStateCache::init(const moveit::core::RobotModelConstPtr& model, const std::string& end_effector,
+        double max_age)
+    {
+        model_ = model;
+        end_effector_ = end_effector;
+        max_age_ = max_age;
+        kinematics_.reset(new moveit::core::RobotState(model_));
+        kinematics_->setToDefaultValues();
+        // joints missing from the messages keep their default positions
+        size_ = model_->getVariableCount();
+        positions_.reset(new std::atomic<double>[size_]);
+        for (std::size_t i{ 0 }; i < size_; i++)
+            positions_[i].store(kinematics_->getVariablePositions()[i], std::memory_order_relaxed);
+        stamp_.store(0.0);
+        names_.clear();
+        index_.clear();
+    }
+
+    void JointStateCache::update(const sensor_msgs::JointState& joint_state)
+    {
+        if (!positions_ || joint_state.name.size() != joint_state.position.size())
+            return;
+        // the publisher sends the same names in the same order every time
+        if (joint_state.name != names_) {
+            names_ = joint_state.name;
+            index_.clear();
+            for (auto& name : names_)
+                index_.push_back(model_->hasVariable(name) ? model_->getVariableIndex(name) : -1);
+        }
+
+        std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i{ 0 }; i < index_.size(); i++) {
+            if (index_.at(i) >= 0)
+                positions_[index_.at(i)].store(joint_state.position.at(i), std::memory_order_relaxed);
+        }
+        double stamp = joint_state.header.stamp.isZero() ? ros::Time::now().toSec() : joint_state.header.stamp.toSec();
+        stamp_.store(stamp, std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    bool JointStateCache::read(std::vector<double>& positions, double& stamp) const
+    {
+        if (!positions_)
+            return false;
+        positions.resize(size_);
+        while (true) {
+            std::uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+            for (std::size_t i{ 0 }; i < size_; i++)
+                positions.at(i) = positions_[i].load(std::memory_order_relaxed);
+            stamp = stamp_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // unchanged while copying, the copy is one whole state
+            if (sequence_.load(std::memory_order_relaxed) == before)
+                break;
+        }
+        return stamp > 0.0 && ros::Time::now().toSec() - stamp <= max_age_;
+    }
+
+    bool JointStateCache::positions(std::vector<double>& positions) const
+    {
+        double stamp{ 0.0 };
+        return read(positions, stamp);
+    }
+
+    bool JointStateCache::positions(const std::vector<std::string>& joints, std::vector<double>& positions) const
+    {
+        std::vector<double> all;
+        if (!this->positions(all))
+            return false;
+        positions.clear();
+        for (auto& joint : joints) {
+            if (!model_->hasVariable(joint))
+                return false;
+            positions.push_back(all.at(model_->getVariableIndex(joint)));
+        }
+        return true;
+    }
+
+    moveit::core::RobotStatePtr JointStateCache::state() const
+    {
+        std::vector<double> all;
+        if (!positions(all))
+            return nullptr;
+        auto state = std::make_shared<moveit::core::RobotState>(model_);
+        state->setVariablePositions(all.data());
+        state->update();
+        return state;
+    }
+
+    bool JointStateCache::pose(geometry_msgs::Pose& pose)
+    {
+        if (!kinematics_ || !positions(scratch_))
+            return false;
+        kinematics_->setVariablePositions(scratch_.data());
+        const Eigen::Isometry3d& transform = kinematics_->getGlobalLinkTransform(end_effector_);
+        Eigen::Quaterniond rotation(transform.rotation());
+        pose.position.x = transform.translation().x();
+        pose.position.y = transform.translation().y();
+        pose.position.z = transform.translation().z();
+        pose.orientation.x = rotation.x();
+        pose.orientation.y = rotation.y();
+        pose.orientation.z = rotation.z();
+        pose.orientation.w = rotation.w();
+        return true;
+    }
+
+    moveit::core::RobotStatePtr latestState(const JointStateCache* joint_states,
+        moveit::planning_interface::MoveGroupInterface& group)
+    {
+        moveit::core::RobotStatePtr state;
+        if (joint_states != nullptr)
+            state = joint_states->state();
+        if (!state) {
+            ROS_DEBUG_STREAM("[latestState] No recent joint state for " << group.getName() << ", asking MoveIt");
+            state = group.getCurrentState();
+        }
+        return state;
+    }
+
+    std::vector<double> latestJointValues(const JointStateCache* joint_states,
+        moveit::planning_interface::MoveGroupInterface& group)
+    {
+        std::vector<double> joints;
+        latestState(joint_states, group)->copyJointGroupPositions(group.getName(), joints);
+        return joints;
+    }
+}//namespace
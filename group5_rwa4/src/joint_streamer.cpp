@@ -0,0 +1,289 @@
+#include "../include/arm/joint_streamer.h"
+#include "../include/trace/trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace motioncontrol {
+    namespace {
+        // shortest rest-to-rest time over @p distance, trapezoidal or triangular velocity
+        double restToRest(double distance, double velocity, double acceleration)
+        {
+            distance = std::abs(distance);
+            if (distance > velocity * velocity / acceleration)
+                return distance / velocity + velocity / acceleration;
+            return 2.0 * std::sqrt(distance / acceleration);
+        }
+
+        double sign(double value)
+        {
+            return value < 0.0 ? -1.0 : 1.0;
+        }
+
+        // a joint after @p t seconds of constant accelerations phases
+        void evaluate(double position, const std::vector<double>& phases, const std::vector<double>& accelerations,
+            double t, double& p, double& v, double& a)
+        {
+            p = position;
+            v = 0.0;
+            a = 0.0;
+            for (std::size_t i{ 0 }; i < phases.size() && t > 0.0; i++) {
+                double dt = std::min(t, phases.at(i));
+                a = accelerations.at(i);
+                p += v * dt + 0.5 * a * dt * dt;
+                v += a * dt;
+                t -= dt;
+            }
+        }
+    }
+
+    void JointStreamer::init(const moveit::core::RobotModelConstPtr& model, const std::string& group,
+        const StreamOptions& options)
+    {
+        options_ = options;
+        joint_names_.clear();
+        max_velocity_.clear();
+        max_acceleration_.clear();
+        auto joint_model_group = model->getJointModelGroup(group);
+        if (!joint_model_group) {
+            ROS_ERROR_STREAM("[JointStreamer][init] No group " << group);
+            return;
+        }
+        for (auto joint : joint_model_group->getActiveJointModels()) {
+            auto& bounds = joint->getVariableBounds().at(0);
+            joint_names_.push_back(joint->getName());
+            max_velocity_.push_back(options_.velocity_scaling * (bounds.velocity_bounded_ ? bounds.max_velocity_ : 1.0));
+            max_acceleration_.push_back(bounds.acceleration_bounded_ && bounds.max_acceleration_ > 0.0 ?
+                bounds.max_acceleration_ : options_.acceleration);
+        }
+    }
+
+    void JointStreamer::addController(const ros::Publisher& command, const std::vector<std::string>& joints)
+    {
+        controllers_.push_back(Controller{ command, joints });
+    }
+
+    bool JointStreamer::blend(const std::vector<double>& points, const std::vector<double>& durations,
+        double acceleration, std::vector<double>& phases, std::vector<double>& accelerations) const
+    {
+        // linear segments with parabolic blends, the blend around each
+        // waypoint is as short as the acceleration limit allows
+        std::size_t n = durations.size();
+        std::vector<double> blend(n + 1, 0.0), blend_acceleration(n + 1, 0.0), velocity(n, 0.0);
+        if (n == 1) {
+            double distance = points.at(1) - points.at(0);
+            double T = durations.at(0);
+            double discriminant = acceleration * acceleration * T * T - 4.0 * acceleration * std::abs(distance);
+            if (discriminant < 0.0)
+                return false;
+            blend.at(0) = blend.at(1) = T / 2.0 - std::sqrt(discriminant) / (2.0 * acceleration);
+            blend_acceleration.at(0) = sign(distance) * acceleration;
+            blend_acceleration.at(1) = -blend_acceleration.at(0);
+            velocity.at(0) = blend.at(0) * blend_acceleration.at(0);
+        }
+        else {
+            // the first and last blends start and end at rest
+            double first = points.at(1) - points.at(0);
+            double discriminant = durations.front() * durations.front() - 2.0 * std::abs(first) / acceleration;
+            if (discriminant < 0.0)
+                return false;
+            blend.front() = durations.front() - std::sqrt(discriminant);
+            blend_acceleration.front() = sign(first) * acceleration;
+            velocity.front() = first / (durations.front() - blend.front() / 2.0);
+
+            double last = points.at(n) - points.at(n - 1);
+            discriminant = durations.back() * durations.back() - 2.0 * std::abs(last) / acceleration;
+            if (discriminant < 0.0)
+                return false;
+            blend.back() = durations.back() - std::sqrt(discriminant);
+            blend_acceleration.back() = -sign(last) * acceleration;
+            velocity.back() = last / (durations.back() - blend.back() / 2.0);
+
+            for (std::size_t k{ 1 }; k + 1 < n; k++)
+                velocity.at(k) = (points.at(k + 1) - points.at(k)) / durations.at(k);
+            for (std::size_t k{ 1 }; k < n; k++) {
+                blend_acceleration.at(k) = sign(velocity.at(k) - velocity.at(k - 1)) * acceleration;
+                blend.at(k) = std::abs(velocity.at(k) - velocity.at(k - 1)) / acceleration;
+            }
+        }
+
+        phases.clear();
+        accelerations.clear();
+        for (std::size_t k{ 0 }; k < n; k++) {
+            double linear = durations.at(k) - blend.at(k + 1) / 2.0 - blend.at(k) / 2.0;
+            // the end blends lie entirely inside their segment
+            if (k == 0)
+                linear -= blend.at(0) / 2.0;
+            if (k + 1 == n)
+                linear -= blend.at(n) / 2.0;
+            if (linear < -1e-9)
+                return false;
+            phases.push_back(blend.at(k));
+            accelerations.push_back(blend_acceleration.at(k));
+            phases.push_back(std::max(linear, 0.0));
+            accelerations.push_back(0.0);
+        }
+        phases.push_back(blend.at(n));
+        accelerations.push_back(blend_acceleration.at(n));
+        return true;
+    }
+
+    bool JointStreamer::plan(const std::vector<double>& start, const std::vector<std::vector<double> >& waypoints,
+        trajectory_msgs::JointTrajectory& trajectory, std::vector<double>& durations,
+        const MotionProfile& profile) const
+    {
+        std::size_t joints = joint_names_.size();
+        if (joints == 0 || start.size() != joints) {
+            ROS_ERROR_STREAM("[JointStreamer][plan] Expected " << joints << " joints");
+            return false;
+        }
+        // waypoints the joints actually move to, a repeated one costs no time
+        std::vector<std::vector<double> > points{ start };
+        std::vector<std::size_t> kept;
+        for (std::size_t i{ 0 }; i < waypoints.size(); i++) {
+            if (waypoints.at(i).size() != joints) {
+                ROS_ERROR_STREAM("[JointStreamer][plan] Expected " << joints << " joints");
+                return false;
+            }
+            double largest{ 0.0 };
+            for (std::size_t j{ 0 }; j < joints; j++)
+                largest = std::max(largest, std::abs(waypoints.at(i).at(j) - points.back().at(j)));
+            if (largest > 1e-6) {
+                points.push_back(waypoints.at(i));
+                kept.push_back(i);
+            }
+        }
+
+        trajectory.joint_names = joint_names_;
+        trajectory.points.clear();
+        durations.assign(waypoints.size(), 0.0);
+        if (points.size() == 1)
+            return true;
+
+        // each segment as long as its slowest joint at rest-to-rest
+        std::vector<double> segment(points.size() - 1, options_.sample_period);
+        for (std::size_t k{ 0 }; k < segment.size(); k++)
+            for (std::size_t j{ 0 }; j < joints; j++)
+                segment.at(k) = std::max(segment.at(k), restToRest(points.at(k + 1).at(j) - points.at(k).at(j),
+                    profile.velocity * max_velocity_.at(j), profile.acceleration * max_acceleration_.at(j)));
+
+        // blending needs some slack over rest-to-rest, stretch the segments until every joint fits
+        std::vector<std::vector<double> > phases(joints), accelerations(joints);
+        bool timed{ false };
+        for (int attempt{ 0 }; attempt < 30 && !timed; attempt++) {
+            timed = true;
+            for (std::size_t j{ 0 }; j < joints && timed; j++) {
+                std::vector<double> values;
+                for (auto& point : points)
+                    values.push_back(point.at(j));
+                timed = blend(values, segment, profile.acceleration * max_acceleration_.at(j), phases.at(j), accelerations.at(j));
+            }
+            if (!timed)
+                for (auto& T : segment)
+                    T *= 1.1;
+        }
+        if (!timed) {
+            ROS_ERROR_STREAM("[JointStreamer][plan] No timing within the joint limits");
+            return false;
+        }
+
+        double total{ 0.0 };
+        for (std::size_t k{ 0 }; k < segment.size(); k++) {
+            durations.at(kept.at(k)) = segment.at(k);
+            total += segment.at(k);
+        }
+        for (double t{ options_.sample_period }; t < total; t += options_.sample_period) {
+            trajectory_msgs::JointTrajectoryPoint point;
+            point.positions.resize(joints);
+            point.velocities.resize(joints);
+            point.accelerations.resize(joints);
+            for (std::size_t j{ 0 }; j < joints; j++)
+                evaluate(start.at(j), phases.at(j), accelerations.at(j), t,
+                    point.positions.at(j), point.velocities.at(j), point.accelerations.at(j));
+            point.time_from_start = ros::Duration(t);
+            trajectory.points.push_back(point);
+        }
+        trajectory_msgs::JointTrajectoryPoint goal;
+        goal.positions = points.back();
+        goal.velocities.assign(joints, 0.0);
+        goal.accelerations.assign(joints, 0.0);
+        goal.time_from_start = ros::Duration(total);
+        trajectory.points.push_back(goal);
+        return true;
+    }
+
+    bool JointStreamer::send(trajectory_msgs::JointTrajectory trajectory) const
+    {
+        if (controllers_.empty()) {
+            ROS_ERROR_STREAM("[JointStreamer][send] No controller");
+            return false;
+        }
+        if (trajectory.joint_names.empty())
+            trajectory.joint_names = joint_names_;
+        // the same start time for every controller keeps them in step
+        if (trajectory.header.stamp.isZero())
+            trajectory.header.stamp = ros::Time::now() + ros::Duration(0.1);
+
+        for (auto& controller : controllers_) {
+            std::vector<std::size_t> index;
+            for (auto& joint : controller.joints) {
+                auto found = std::find(trajectory.joint_names.begin(), trajectory.joint_names.end(), joint);
+                if (found == trajectory.joint_names.end()) {
+                    ROS_ERROR_STREAM("[JointStreamer][send] No " << joint << " in the trajectory");
+                    return false;
+                }
+                index.push_back(found - trajectory.joint_names.begin());
+            }
+            trajectory_msgs::JointTrajectory command;
+            command.header.stamp = trajectory.header.stamp;
+            command.joint_names = controller.joints;
+            for (auto& point : trajectory.points) {
+                trajectory_msgs::JointTrajectoryPoint part;
+                for (auto i : index) {
+                    part.positions.push_back(point.positions.at(i));
+                    if (!point.velocities.empty())
+                        part.velocities.push_back(point.velocities.at(i));
+                    if (!point.accelerations.empty())
+                        part.accelerations.push_back(point.accelerations.at(i));
+                }
+                part.time_from_start = point.time_from_start;
+                command.points.push_back(part);
+            }
+            controller.command.publish(command);
+        }
+        return true;
+    }
+
+    bool JointStreamer::execute(const trajectory_msgs::JointTrajectory& trajectory, const JointStateCache& joint_states,
+        moveit::planning_interface::MoveGroupInterface& group) const
+    {
+        tracing::Span span("stream", "execute");
+        if (trajectory.points.empty())
+            return true;
+        span.arg("duration", trajectory.points.back().time_from_start.toSec());
+
+        trajectory_msgs::JointTrajectory stamped = trajectory;
+        stamped.header.stamp = ros::Time::now() + ros::Duration(0.1);
+        if (!send(stamped))
+            return false;
+        (stamped.header.stamp + trajectory.points.back().time_from_start - ros::Time::now()).sleep();
+
+        auto& goal = trajectory.points.back().positions;
+        ros::Time deadline = ros::Time::now() + ros::Duration(options_.settle_timeout);
+        while (ros::ok()) {
+            std::vector<double> joints;
+            if (!joint_states.positions(joint_names_, joints))
+                joints = group.getCurrentJointValues();
+            double largest{ 0.0 };
+            for (std::size_t j{ 0 }; j < joints.size() && j < goal.size(); j++)
+                largest = std::max(largest, std::abs(joints.at(j) - goal.at(j)));
+            if (largest < options_.goal_tolerance)
+                return true;
+            if (ros::Time::now() > deadline) {
+                ROS_ERROR_STREAM("[JointStreamer][execute] Still " << largest << " from the goal");
+                return false;
+            }
+            ros::Duration(0.01).sleep();
+        }
+        return false;
+    }
+}//namespace
@@ -1,4 +1,5 @@
 #include "../include/camera/logical_camera.h"
+#include "../include/trace/trace.h"
 
 LogicalCamera::LogicalCamera(ros::NodeHandle & node) 
 : tfBuffer(), tfListener(tfBuffer)
@@ -95,6 +96,7 @@ void LogicalCamera::logical_camera_bins1_callback(
 }
 
 std::array<std::vector<Product>,19> LogicalCamera::findparts(){
+  tracing::Span span("camera", "findparts");
   ROS_INFO_STREAM("In Findparts");
   for (int i{0}; i < 18; i++){
     get_cam[i] = true;
@@ -201,6 +203,26 @@ std::vector<int> LogicalCamera::get_ebin_list(){
   return empty_bin;
 }
 
+std::vector<Product> LogicalCamera::get_station_parts(std::string station, ros::Duration timeout){
+  tracing::Span span("camera", "get_station_parts");
+  span.arg("station", station);
+  std::vector<Product> station_parts;
+  std::string topic = "/ariac/logical_camera_station" + station.substr(station.size() - 1);
+  auto image_msg = ros::topic::waitForMessage<nist_gear::LogicalCameraImage>(topic, node_, timeout);
+  if (!image_msg){
+    ROS_WARN_STREAM("No message received on " << topic);
+    return station_parts;
+  }
+  for (auto &model: image_msg->models){
+    Product product;
+    product.type = model.type;
+    product.frame_pose = model.pose;
+    product.camera = "logical_camera_station" + station.substr(station.size() - 1);
+    station_parts.push_back(product);
+  }
+  return station_parts;
+}
+
 double LogicalCamera::CheckBlackout(){
   return blackout_time_;
 }
@@ -306,6 +328,7 @@ std::vector<Product> LogicalCamera::get_faulty_part_list(){
 }
 
 void LogicalCamera::query_faulty_cam(){
+  tracing::Span span("camera", "query_faulty_cam");
   faulty_part_list_.clear();
   for (int j{0}; j <= 3; j++){  
     get_faulty_cam[j] = true;
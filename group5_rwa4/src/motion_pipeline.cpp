@@ -0,0 +1,161 @@
+#include "../include/arm/motion_pipeline.h"
+#include "../include/trace/trace.h"
+#include <cmath>
+#include <future>
+
+namespace motioncontrol {
+    using moveit::planning_interface::MoveGroupInterface;
+    using moveit::planning_interface::MoveItErrorCode;
+
+    MotionSegment MotionSegment::joint(MoveGroupInterface& group, const std::vector<double>& goal, const MotionProfile& profile)
+    {
+        return jointFromStart(group, [goal](std::vector<double>) { return goal; }, profile);
+    }
+
+    MotionSegment MotionSegment::jointFromStart(MoveGroupInterface& group,
+        std::function<std::vector<double>(std::vector<double>)> goal, const MotionProfile& profile)
+    {
+        MotionSegment segment;
+        segment.group = &group;
+        segment.type = JOINT;
+        segment.joints = goal;
+        segment.profile = profile;
+        return segment;
+    }
+
+    MotionSegment MotionSegment::poseTarget(MoveGroupInterface& group, const geometry_msgs::Pose& pose, const MotionProfile& profile)
+    {
+        MotionSegment segment;
+        segment.group = &group;
+        segment.type = POSE;
+        segment.pose = pose;
+        segment.profile = profile;
+        return segment;
+    }
+
+    MotionSegment MotionSegment::cartesian(MoveGroupInterface& group, const std::vector<geometry_msgs::Pose>& waypoints, const MotionProfile& profile)
+    {
+        MotionSegment segment;
+        segment.group = &group;
+        segment.type = CARTESIAN;
+        segment.waypoints = waypoints;
+        segment.profile = profile;
+        return segment;
+    }
+
+    MotionPipeline::MotionPipeline(const JointStateCache* joint_states, TrajectoryCache* cache, double handover_tolerance)
+        : joint_states_{ joint_states }, cache_{ cache }, handover_tolerance_{ handover_tolerance }
+    {
+    }
+
+    MotionPipeline& MotionPipeline::add(const MotionSegment& segment)
+    {
+        segments_.push_back(segment);
+        return *this;
+    }
+
+    bool MotionPipeline::plan_step(const MotionSegment& segment, const moveit::core::RobotState& start, Step& step)
+    {
+        tracing::Span span("motion", "plan");
+        auto& group = *segment.group;
+        step.start_state = std::make_shared<moveit::core::RobotState>(start);
+        start.copyJointGroupPositions(group.getName(), step.start);
+        step.planned = false;
+
+        group.setStartState(start);
+        segment.profile.apply(group);
+        if (segment.type == MotionSegment::JOINT) {
+            step.goal = segment.joints(step.start);
+            if (cache_ != nullptr && cache_->find(step.start, step.goal, segment.profile, step.plan.trajectory_)) {
+                step.planned = true;
+            }
+            else {
+                group.setJointValueTarget(step.goal);
+                step.planned = group.plan(step.plan) == MoveItErrorCode::SUCCESS;
+            }
+        }
+        else if (segment.type == MotionSegment::POSE) {
+            group.setPoseTarget(segment.pose);
+            step.planned = group.plan(step.plan) == MoveItErrorCode::SUCCESS;
+        }
+        else {
+            double fraction = group.computeCartesianPath(segment.waypoints, 0.01, 0.0, step.plan.trajectory_);
+            if (fraction < 1.0)
+                ROS_WARN_STREAM("[MotionPipeline][plan] Cartesian path " << fraction * 100.0 << "% achieved");
+            step.planned = fraction > 0.0;
+        }
+        group.setStartStateToCurrentState();
+        return step.planned;
+    }
+
+    bool MotionPipeline::starts_at(const Step& step, const moveit::core::RobotState& state) const
+    {
+        auto& trajectory = step.plan.trajectory_.joint_trajectory;
+        if (trajectory.points.empty())
+            return true;
+        auto& first = trajectory.points.front().positions;
+        for (std::size_t i{ 0 }; i < trajectory.joint_names.size() && i < first.size(); i++) {
+            if (std::abs(state.getVariablePosition(trajectory.joint_names.at(i)) - first.at(i)) > handover_tolerance_)
+                return false;
+        }
+        return true;
+    }
+
+    moveit::core::RobotState MotionPipeline::end_state(const Step& step) const
+    {
+        moveit::core::RobotState end(*step.start_state);
+        auto& trajectory = step.plan.trajectory_.joint_trajectory;
+        if (!trajectory.points.empty())
+            end.setVariablePositions(trajectory.joint_names, trajectory.points.back().positions);
+        end.update();
+        return end;
+    }
+
+    bool MotionPipeline::run()
+    {
+        tracing::Span span("motion", "pipeline");
+        std::vector<MotionSegment> segments;
+        segments.swap(segments_);
+        if (segments.empty())
+            return true;
+        span.arg("segments", segments.size());
+
+        std::vector<Step> steps(segments.size());
+        if (!plan_step(segments.front(), *latestState(joint_states_, *segments.front().group), steps.front())) {
+            ROS_ERROR_STREAM("[MotionPipeline][run] Failed to plan segment 0");
+            return false;
+        }
+
+        for (std::size_t i{ 0 }; i < segments.size(); i++) {
+            auto& group = *segments.at(i).group;
+            auto current = latestState(joint_states_, group);
+            if (!steps.at(i).planned || !starts_at(steps.at(i), *current)) {
+                // segment i-1 did not end where its plan said, or segment i could not be planned from there
+                if (!plan_step(segments.at(i), *current, steps.at(i))) {
+                    ROS_ERROR_STREAM("[MotionPipeline][run] Failed to plan segment " << i);
+                    return false;
+                }
+            }
+
+            auto& plan = steps.at(i).plan;
+            auto execution = std::async(std::launch::async, [&group, &plan]() {
+                tracing::Span execute_span("motion", "execute");
+                return group.execute(plan) == MoveItErrorCode::SUCCESS;
+            });
+            if (i + 1 < segments.size())
+                plan_step(segments.at(i + 1), end_state(steps.at(i)), steps.at(i + 1));
+
+            if (!execution.get()) {
+                ROS_ERROR_STREAM("[MotionPipeline][run] Execution of segment " << i << " failed");
+                if (cache_ != nullptr && segments.at(i).type == MotionSegment::JOINT)
+                    cache_->erase(steps.at(i).start, steps.at(i).goal, segments.at(i).profile);
+                return false;
+            }
+            if (cache_ != nullptr && segments.at(i).type == MotionSegment::JOINT)
+                cache_->store(steps.at(i).start, steps.at(i).goal, segments.at(i).profile, plan.trajectory_);
+            if (segments.at(i).after)
+                segments.at(i).after();
+        }
+        return true;
+    }
+}//namespace
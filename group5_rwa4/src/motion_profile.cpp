@@ -0,0 +1,92 @@
+#include "../include/arm/motion_profile.h"
+#include "../include/trace/trace.h"
+#include <ros/ros.h>
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace motioncontrol {
+    namespace {
+        const MotionPhase phases[] = { MotionPhase::EMPTY_TRANSIT, MotionPhase::LOADED_TRANSIT, MotionPhase::APPROACH,
+            MotionPhase::CONTACT, MotionPhase::PLACE, MotionPhase::FLIP };
+
+        MotionProfile read(const YAML::Node& node, MotionProfile profile)
+        {
+            profile.velocity = std::min(1.0, std::max(0.01, node["velocity"].as<double>(profile.velocity)));
+            profile.acceleration = std::min(1.0, std::max(0.01, node["acceleration"].as<double>(profile.acceleration)));
+            return profile;
+        }
+    }
+
+    MotionProfiles::MotionProfiles()
+    {
+        // without a file everything runs as before the profiles existed
+        for (auto phase : phases)
+            phases_[phase] = MotionProfile();
+        phases_[MotionPhase::CONTACT] = MotionProfile{ 0.05, 0.05 };
+        phases_[MotionPhase::PLACE] = MotionProfile{ 0.1, 0.1 };
+    }
+
+    const char* MotionProfiles::name(MotionPhase phase)
+    {
+        switch (phase) {
+            case MotionPhase::EMPTY_TRANSIT: return "empty_transit";
+            case MotionPhase::LOADED_TRANSIT: return "loaded_transit";
+            case MotionPhase::APPROACH: return "approach";
+            case MotionPhase::CONTACT: return "contact";
+            case MotionPhase::PLACE: return "place";
+            case MotionPhase::FLIP: return "flip";
+        }
+        return "unknown";
+    }
+
+    bool MotionProfiles::load(const std::string& path)
+    {
+        std::map<MotionPhase, MotionProfile> loaded_phases(phases_);
+        std::map<std::string, std::map<MotionPhase, MotionProfile> > loaded_parts;
+        try {
+            YAML::Node root = YAML::LoadFile(path);
+            for (auto phase : phases) {
+                if (root["phases"][name(phase)])
+                    loaded_phases[phase] = read(root["phases"][name(phase)], loaded_phases[phase]);
+            }
+            for (auto part : root["parts"]) {
+                auto& overrides = loaded_parts[part.first.as<std::string>()];
+                for (auto phase : phases) {
+                    if (part.second[name(phase)])
+                        overrides[phase] = read(part.second[name(phase)], loaded_phases[phase]);
+                }
+            }
+        }
+        catch (const YAML::Exception& e) {
+            ROS_ERROR_STREAM("[MotionProfiles][load] " << path << ": " << e.what());
+            return false;
+        }
+        phases_ = loaded_phases;
+        parts_ = loaded_parts;
+        ROS_INFO_STREAM("[MotionProfiles][load] " << parts_.size() << " part overrides from " << path);
+        return true;
+    }
+
+    MotionProfile MotionProfiles::select(MotionPhase phase, const std::string& part_type) const
+    {
+        MotionProfile profile = phases_.at(phase);
+        if (!part_type.empty()) {
+            for (auto& part : parts_) {
+                auto override_profile = part.second.find(phase);
+                if (part_type.find(part.first) != std::string::npos && override_profile != part.second.end()) {
+                    profile = override_profile->second;
+                    break;
+                }
+            }
+        }
+
+        ROS_DEBUG_STREAM_NAMED("motion_profile", name(phase) << " " << part_type
+            << ": velocity " << profile.velocity << ", acceleration " << profile.acceleration);
+        tracing::Span span("profile", name(phase));
+        char scaling[48];
+        std::snprintf(scaling, sizeof(scaling), "v%.2f a%.2f %s", profile.velocity, profile.acceleration, part_type.c_str());
+        span.arg("scaling", scaling);
+        return profile;
+    }
+}//namespace
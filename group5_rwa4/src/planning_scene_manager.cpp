@@ -0,0 +1,316 @@
+#include "../include/arm/planning_scene_manager.h"
+#include "../include/trace/trace.h"
+#include <moveit_msgs/AttachedCollisionObject.h>
+#include <shape_msgs/SolidPrimitive.h>
+#include <yaml-cpp/yaml.h>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+
+namespace motioncontrol {
+    namespace {
+        const std::string held_part_id{ "held_part" };
+
+        geometry_msgs::Pose makePose(double x, double y, double z)
+        {
+            geometry_msgs::Pose pose;
+            pose.position.x = x;
+            pose.position.y = y;
+            pose.position.z = z;
+            pose.orientation.w = 1.0;
+            return pose;
+        }
+
+        // point @p offset of the frame at @p pose, in world
+        geometry_msgs::Pose offsetPose(const geometry_msgs::Pose& pose, const std::vector<double>& offset)
+        {
+            Eigen::Quaterniond rotation(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+            Eigen::Vector3d position = Eigen::Vector3d(pose.position.x, pose.position.y, pose.position.z) +
+                rotation * Eigen::Vector3d(offset.at(0), offset.at(1), offset.at(2));
+            geometry_msgs::Pose result = pose;
+            result.position.x = position.x();
+            result.position.y = position.y();
+            result.position.z = position.z();
+            return result;
+        }
+
+        double distance(const geometry_msgs::Pose& a, const geometry_msgs::Pose& b)
+        {
+            return std::sqrt(std::pow(a.position.x - b.position.x, 2) + std::pow(a.position.y - b.position.y, 2) +
+                std::pow(a.position.z - b.position.z, 2));
+        }
+
+        double planarDistance(const geometry_msgs::Pose& a, const geometry_msgs::Pose& b)
+        {
+            return std::hypot(a.position.x - b.position.x, a.position.y - b.position.y);
+        }
+    }
+
+    bool PlanningSceneManager::init(const std::string& ns, const std::string& path)
+    {
+        std::vector<moveit_msgs::CollisionObject> objects;
+        try {
+            YAML::Node root = YAML::LoadFile(path);
+            for (auto entry : root["static"]) {
+                auto position = entry.second["position"].as<std::vector<double> >();
+                objects.push_back(box(entry.first.as<std::string>(), entry.second["size"].as<std::vector<double> >(),
+                    makePose(position.at(0), position.at(1), position.at(2))));
+            }
+
+            // open boxes: a block up to the floor of the bin, walls up to its rim
+            YAML::Node bins = root["bins"];
+            bins_.clear();
+            bin_size_.clear();
+            if (bins) {
+                auto size = bins["size"].as<std::vector<double> >();
+                double floor = bins["floor"].as<double>();
+                double rim = bins["rim"].as<double>();
+                double wall = bins["wall"].as<double>();
+                bin_size_ = size;
+                for (auto bin : bins["centers"]) {
+                    std::string name = bin.first.as<std::string>();
+                    auto center = bin.second.as<std::vector<double> >();
+                    double x = center.at(0);
+                    double y = center.at(1);
+                    bins_.push_back(makePose(x, y, 0.0));
+                    objects.push_back(box(name + "_floor", { size.at(0), size.at(1), floor }, makePose(x, y, floor / 2.0)));
+                    for (int side : { -1, 1 }) {
+                        objects.push_back(box(name + "_wall_x" + std::to_string(side + 1), { wall, size.at(1), rim },
+                            makePose(x + side * (size.at(0) - wall) / 2.0, y, rim / 2.0)));
+                        objects.push_back(box(name + "_wall_y" + std::to_string(side + 1), { size.at(0), wall, rim },
+                            makePose(x, y + side * (size.at(1) - wall) / 2.0, rim / 2.0)));
+                    }
+                }
+            }
+
+            frames_.clear();
+            for (auto entry : root["frames"]) {
+                FramedBox framed;
+                framed.frame = entry.second["frame"].as<std::string>();
+                framed.size = entry.second["size"].as<std::vector<double> >();
+                framed.offset = entry.second["offset"].as<std::vector<double> >(std::vector<double>{ 0.0, 0.0, 0.0 });
+                framed.inserted = false;
+                frames_[entry.first.as<std::string>()] = framed;
+            }
+
+            part_sizes_.clear();
+            for (auto entry : root["parts"])
+                part_sizes_[entry.first.as<std::string>()] = entry.second.as<std::vector<double> >();
+        }
+        catch (const YAML::Exception& e) {
+            ROS_ERROR_STREAM("[PlanningSceneManager][init] " << path << ": " << e.what());
+            return false;
+        }
+
+        scene_.reset(new moveit::planning_interface::PlanningSceneInterface(ns));
+        tf_buffer_.reset(new tf2_ros::Buffer());
+        tf_listener_.reset(new tf2_ros::TransformListener(*tf_buffer_));
+
+        // parts left over from a previous run are stale
+        std::vector<std::string> stale;
+        for (auto& id : scene_->getKnownObjectNames()) {
+            if (id.rfind("part_", 0) == 0 || id == held_part_id)
+                stale.push_back(id);
+        }
+        if (!stale.empty())
+            scene_->removeCollisionObjects(stale);
+        parts_.clear();
+        held_id_.clear();
+
+        if (!apply(objects))
+            return false;
+        ROS_INFO_STREAM("[PlanningSceneManager][init] " << objects.size() << " static objects in " << ns);
+        return true;
+    }
+
+    std::vector<double> PlanningSceneManager::partSize(const std::string& part_type) const
+    {
+        std::vector<double> largest{ 0.0, 0.0, 0.0 };
+        for (auto& entry : part_sizes_) {
+            if (!part_type.empty() && part_type.find(entry.first) != std::string::npos)
+                return entry.second;
+            for (std::size_t i{ 0 }; i < 3; i++)
+                largest.at(i) = std::max(largest.at(i), entry.second.at(i));
+        }
+        // unknown type: big enough for any part
+        return largest;
+    }
+
+    bool PlanningSceneManager::inBin(const geometry_msgs::Pose& pose) const
+    {
+        for (auto& bin : bins_) {
+            if (std::abs(pose.position.x - bin.position.x) < bin_size_.at(0) / 2.0 &&
+                std::abs(pose.position.y - bin.position.y) < bin_size_.at(1) / 2.0)
+                return true;
+        }
+        return false;
+    }
+
+    moveit_msgs::CollisionObject PlanningSceneManager::box(const std::string& id, const std::vector<double>& size,
+        const geometry_msgs::Pose& pose) const
+    {
+        moveit_msgs::CollisionObject object;
+        object.header.frame_id = "world";
+        object.id = id;
+        shape_msgs::SolidPrimitive primitive;
+        primitive.type = shape_msgs::SolidPrimitive::BOX;
+        primitive.dimensions = { size.at(0), size.at(1), size.at(2) };
+        object.primitives.push_back(primitive);
+        object.primitive_poses.push_back(pose);
+        // adding an existing id replaces it, which is how objects are moved
+        object.operation = moveit_msgs::CollisionObject::ADD;
+        return object;
+    }
+
+    bool PlanningSceneManager::apply(const std::vector<moveit_msgs::CollisionObject>& changes)
+    {
+        if (changes.empty())
+            return true;
+        if (!scene_->applyCollisionObjects(changes)) {
+            ROS_ERROR_STREAM("[PlanningSceneManager][apply] The planning scene rejected " << changes.size() << " changes");
+            return false;
+        }
+        return true;
+    }
+
+    void PlanningSceneManager::updateFrames(std::vector<moveit_msgs::CollisionObject>& changes)
+    {
+        for (auto& entry : frames_) {
+            auto& framed = entry.second;
+            geometry_msgs::TransformStamped transform;
+            try {
+                transform = tf_buffer_->lookupTransform("world", framed.frame, ros::Time(0));
+            }
+            catch (tf2::TransformException& ex) {
+                ROS_DEBUG_STREAM("[PlanningSceneManager][updateFrames] " << ex.what());
+                continue;
+            }
+            geometry_msgs::Pose frame_pose;
+            frame_pose.position.x = transform.transform.translation.x;
+            frame_pose.position.y = transform.transform.translation.y;
+            frame_pose.position.z = transform.transform.translation.z;
+            frame_pose.orientation = transform.transform.rotation;
+            auto pose = offsetPose(frame_pose, framed.offset);
+            if (framed.inserted && distance(pose, framed.pose) < 0.01)
+                continue;
+            changes.push_back(box(entry.first, framed.size, pose));
+            framed.pose = pose;
+            framed.inserted = true;
+        }
+    }
+
+    bool PlanningSceneManager::update(const std::vector<Product>& parts)
+    {
+        if (!scene_)
+            return false;
+        tracing::Span span("scene", "update");
+        std::vector<moveit_msgs::CollisionObject> changes;
+        updateFrames(changes);
+        bool on_routes = !changes.empty();
+
+        // a part seen close to one already in the scene is the same part
+        std::map<std::string, bool> seen;
+        for (auto& part : parts) {
+            if (part.camera.find("belt") != std::string::npos)
+                continue;
+            auto size = partSize(part.type);
+            auto center = offsetPose(part.world_pose, { 0.0, 0.0, size.at(2) / 2.0 });
+            std::string id;
+            double closest{ 0.03 };
+            for (auto& entry : parts_) {
+                double d = distance(entry.second.pose, center);
+                if (entry.second.type == part.type && !seen[entry.first] && d < closest) {
+                    closest = d;
+                    id = entry.first;
+                }
+            }
+            if (id.empty())
+                id = "part_" + std::to_string(next_part_++);
+            else if (distance(parts_.at(id).pose, center) < 0.01) {
+                seen[id] = true;
+                continue;
+            }
+            seen[id] = true;
+            parts_[id] = SceneObject{ part.type, center };
+            changes.push_back(box(id, size, center));
+            on_routes = on_routes || !inBin(center);
+        }
+
+        for (auto entry = parts_.begin(); entry != parts_.end();) {
+            if (seen[entry->first]) {
+                ++entry;
+                continue;
+            }
+            moveit_msgs::CollisionObject removed;
+            removed.header.frame_id = "world";
+            removed.id = entry->first;
+            removed.operation = moveit_msgs::CollisionObject::REMOVE;
+            changes.push_back(removed);
+            on_routes = on_routes || !inBin(entry->second.pose);
+            entry = parts_.erase(entry);
+        }
+
+        span.arg("changes", static_cast<int>(changes.size()));
+        apply(changes);
+        return on_routes;
+    }
+
+    void PlanningSceneManager::clearPart(const std::string& part_type, const geometry_msgs::Pose& pose)
+    {
+        if (!scene_)
+            return;
+        std::string id;
+        double closest{ 0.1 };
+        for (auto& entry : parts_) {
+            double d = planarDistance(entry.second.pose, pose);
+            if ((part_type.empty() || entry.second.type == part_type) && d < closest) {
+                closest = d;
+                id = entry.first;
+            }
+        }
+        if (id.empty())
+            return;
+        scene_->removeCollisionObjects({ id });
+        parts_.erase(id);
+    }
+
+    bool PlanningSceneManager::attach(const std::string& link, const std::string& part_type,
+        const geometry_msgs::Pose& link_pose)
+    {
+        if (!scene_)
+            return false;
+        // the suction cup holds the part from the top, whatever its yaw
+        auto size = partSize(part_type);
+        double footprint = std::max(size.at(0), size.at(1));
+        auto center = makePose(link_pose.position.x, link_pose.position.y, link_pose.position.z - size.at(2) / 2.0);
+
+        moveit_msgs::AttachedCollisionObject held;
+        held.link_name = link;
+        held.object = box(held_part_id, { footprint, footprint, size.at(2) }, center);
+        held.touch_links = { link };
+        if (!scene_->applyAttachedCollisionObject(held)) {
+            ROS_ERROR_STREAM("[PlanningSceneManager][attach] Could not attach " << part_type << " to " << link);
+            return false;
+        }
+        held_id_ = held_part_id;
+        held_link_ = link;
+        return true;
+    }
+
+    bool PlanningSceneManager::detach()
+    {
+        if (!scene_ || held_id_.empty())
+            return true;
+        moveit_msgs::AttachedCollisionObject held;
+        held.link_name = held_link_;
+        held.object.id = held_id_;
+        held.object.operation = moveit_msgs::CollisionObject::REMOVE;
+        // detaching puts the object back in the world, where it does not belong anymore
+        bool detached = scene_->applyAttachedCollisionObject(held);
+        scene_->removeCollisionObjects({ held_id_ });
+        held_id_.clear();
+        if (!detached)
+            ROS_ERROR_STREAM("[PlanningSceneManager][detach] Could not detach the held part from " << held_link_);
+        return detached;
+    }
+}//namespace
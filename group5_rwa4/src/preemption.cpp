@@ -0,0 +1,46 @@
+#include "../include/executor/preemption.h"
+
+namespace motioncontrol {
+    ExecutorContext makeContext(const std::string& robot, const std::string& shipment_type,
+        const std::string& destination, const std::vector<Product>& parts)
+    {
+        ExecutorContext context;
+        context.robot = robot;
+        context.shipment_type = shipment_type;
+        context.destination = destination;
+        for (auto& part : parts) {
+            if (part.processed)
+                context.placed.push_back(part);
+            else
+                context.pending.push_back(part);
+        }
+        return context;
+    }
+
+    PreemptionManager::PreemptionManager(Trigger trigger, Handler handler)
+        : trigger_(trigger), handler_(handler)
+    {
+    }
+
+    bool PreemptionManager::checkpoint(const ExecutorContext& context)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (running_ || !trigger_())
+                return false;
+            running_ = true;
+        }
+
+        ROS_INFO_STREAM("[PreemptionManager] " << context.robot << " preempted"
+            << (context.shipment_type.empty() ? "" : " in " + context.shipment_type)
+            << ", " << context.placed.size() << " placed, " << context.pending.size() << " pending");
+        auto start = ros::Time::now();
+        handler_();
+        ROS_INFO_STREAM("[PreemptionManager] high-priority order done in "
+            << (ros::Time::now() - start).toSec() << " s, resuming " << context.robot);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        return true;
+    }
+}//namespace
@@ -0,0 +1,153 @@
+#include "../include/arm/preset_graph.h"
+#include <ros/ros.h>
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace motioncontrol {
+    bool PresetGraph::load(const std::string& path)
+    {
+        presets_.clear();
+        neighbours_.clear();
+        times_.clear();
+        measured_.clear();
+        try {
+            YAML::Node root = YAML::LoadFile(path);
+            if (root["speeds"]) {
+                linear_speed_ = root["speeds"]["linear"].as<double>(linear_speed_);
+                angular_speed_ = root["speeds"]["angular"].as<double>(angular_speed_);
+                settle_ = root["speeds"]["settle"].as<double>(settle_);
+            }
+            for (auto item : root["presets"]) {
+                Preset preset;
+                preset.torso = item.second["torso"].as<std::vector<double> >();
+                preset.arm = item.second["arm"].as<std::vector<double> >();
+                if (preset.torso.size() != 3 || preset.arm.size() != 6) {
+                    ROS_ERROR_STREAM("[PresetGraph][load] " << item.first.as<std::string>() << " needs 3 torso and 6 arm joints");
+                    continue;
+                }
+                presets_[item.first.as<std::string>()] = preset;
+            }
+            for (auto item : root["edges"]) {
+                auto a = item[0].as<std::string>();
+                auto b = item[1].as<std::string>();
+                if (!has(a) || !has(b)) {
+                    ROS_ERROR_STREAM("[PresetGraph][load] Edge " << a << " - " << b << " names an unknown preset");
+                    continue;
+                }
+                add_edge(a, b, item.size() > 2 ? item[2].as<double>() : estimate(presets_.at(a), presets_.at(b)));
+            }
+        }
+        catch (const YAML::Exception& e) {
+            ROS_ERROR_STREAM("[PresetGraph][load] " << path << ": " << e.what());
+            presets_.clear();
+            neighbours_.clear();
+            times_.clear();
+            return false;
+        }
+        ROS_INFO_STREAM("[PresetGraph][load] " << presets_.size() << " presets, " << times_.size() / 2 << " edges from " << path);
+        return true;
+    }
+
+    void PresetGraph::add_edge(const std::string& a, const std::string& b, double seconds)
+    {
+        neighbours_[a].push_back(b);
+        neighbours_[b].push_back(a);
+        times_[Edge(a, b)] = seconds;
+        times_[Edge(b, a)] = seconds;
+    }
+
+    double PresetGraph::estimate(const Preset& a, const Preset& b) const
+    {
+        // the torso joints and the arm move together, the slowest one sets the time
+        double slowest = std::max(std::abs(a.torso.at(0) - b.torso.at(0)), std::abs(a.torso.at(1) - b.torso.at(1))) / linear_speed_;
+        slowest = std::max(slowest, std::abs(a.torso.at(2) - b.torso.at(2)) / angular_speed_);
+        for (std::size_t i{ 0 }; i < a.arm.size(); i++)
+            slowest = std::max(slowest, std::abs(a.arm.at(i) - b.arm.at(i)) / angular_speed_);
+        return settle_ + slowest;
+    }
+
+    std::string PresetGraph::nearest(const std::vector<double>& joints, double& distance) const
+    {
+        std::string best;
+        distance = std::numeric_limits<double>::max();
+        for (auto& preset : presets_) {
+            double largest{ 0.0 };
+            for (std::size_t i{ 0 }; i < joints.size() && i < 9; i++) {
+                double value = i < 3 ? preset.second.torso.at(i) : preset.second.arm.at(i - 3);
+                largest = std::max(largest, std::abs(joints.at(i) - value));
+            }
+            if (largest < distance) {
+                distance = largest;
+                best = preset.first;
+            }
+        }
+        return best;
+    }
+
+    double PresetGraph::time(const std::string& from, const std::string& to) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto edge = times_.find(Edge(from, to));
+        return edge == times_.end() ? std::numeric_limits<double>::infinity() : edge->second;
+    }
+
+    void PresetGraph::record(const std::string& from, const std::string& to, double seconds)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto edge = times_.find(Edge(from, to));
+        if (edge == times_.end())
+            return;
+        // the first measurement replaces the estimate, later ones are averaged in
+        double value = measured_[Edge(from, to)] ? 0.7 * edge->second + 0.3 * seconds : seconds;
+        edge->second = value;
+        times_[Edge(to, from)] = value;
+        measured_[Edge(from, to)] = true;
+        measured_[Edge(to, from)] = true;
+    }
+
+    bool PresetGraph::route(const std::string& from, const std::string& to, std::vector<std::string>& path) const
+    {
+        path.clear();
+        if (!has(from) || !has(to))
+            return false;
+        if (from == to)
+            return true;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        typedef std::pair<double, std::string> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+        std::map<std::string, double> cost{ { from, 0.0 } };
+        std::map<std::string, std::string> previous;
+        open.push(Entry(0.0, from));
+        while (!open.empty()) {
+            auto current = open.top();
+            open.pop();
+            if (current.second == to)
+                break;
+            if (current.first > cost.at(current.second))
+                continue;
+            auto neighbours = neighbours_.find(current.second);
+            if (neighbours == neighbours_.end())
+                continue;
+            for (auto& next : neighbours->second) {
+                double next_cost = current.first + times_.at(Edge(current.second, next));
+                auto known = cost.find(next);
+                if (known == cost.end() || next_cost < known->second) {
+                    cost[next] = next_cost;
+                    previous[next] = current.second;
+                    open.push(Entry(next_cost, next));
+                }
+            }
+        }
+        if (previous.count(to) == 0)
+            return false;
+        for (std::string node = to; node != from; node = previous.at(node))
+            path.push_back(node);
+        std::reverse(path.begin(), path.end());
+        return true;
+    }
+}//namespace
@@ -0,0 +1,69 @@
+#include "../include/arm/robot_models.h"
+#include "../include/trace/trace.h"
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace motioncontrol {
+    namespace {
+        std::mutex models_mutex;
+        // description -> model, ready once its load is over
+        std::map<std::string, std::shared_future<moveit::core::RobotModelConstPtr> > models;
+
+        moveit::core::RobotModelConstPtr load(const std::string& description)
+        {
+            tracing::Span span("startup", "robot_model");
+            span.arg("description", description);
+            robot_model_loader::RobotModelLoader::Options options(description);
+            options.load_kinematics_solvers_ = true;
+            auto loader = std::make_shared<robot_model_loader::RobotModelLoader>(options);
+            if (!loader->getModel()) {
+                ROS_ERROR_STREAM("[RobotModels][load] Could not load " << description);
+                return moveit::core::RobotModelConstPtr();
+            }
+            // the model keeps its loader alive, it owns the kinematics plugins
+            return moveit::core::RobotModelConstPtr(loader, loader->getModel().get());
+        }
+    }
+
+    moveit::core::RobotModelConstPtr sharedRobotModel(const std::string& description)
+    {
+        std::promise<moveit::core::RobotModelConstPtr> loaded;
+        std::shared_future<moveit::core::RobotModelConstPtr> model;
+        bool first{ false };
+        {
+            std::lock_guard<std::mutex> lock(models_mutex);
+            auto found = models.find(description);
+            if (found == models.end()) {
+                model = loaded.get_future().share();
+                models[description] = model;
+                first = true;
+            }
+            else
+                model = found->second;
+        }
+        // the load runs outside the lock so other descriptions load at the same time
+        if (first) {
+            try {
+                loaded.set_value(load(description));
+            }
+            catch (...) {
+                // every caller waiting on this description gets the real cause
+                loaded.set_exception(std::current_exception());
+            }
+        }
+        return model.get();
+    }
+
+    moveit::planning_interface::MoveGroupInterface::Options groupOptions(const std::string& group,
+        const std::string& description, const ros::NodeHandle& node)
+    {
+        moveit::planning_interface::MoveGroupInterface::Options options(group, description, node);
+        // left null, the move group falls back to loading the model itself
+        options.robot_model_ = sharedRobotModel(description);
+        return options;
+    }
+}//namespace
@@ -0,0 +1,153 @@
+#include "../include/executor/ros_cell.h"
+#include "../include/trace/trace.h"
+
+namespace motioncontrol {
+    void updatePlanningScenes(const std::array<std::vector<Product>, 19>& list, Arm& arm, gantry_motioncontrol::Gantry& gantry)
+    {
+        std::vector<Product> parts;
+        for (auto& camera : list)
+            parts.insert(parts.end(), camera.begin(), camera.end());
+        arm.updateScene(parts);
+        gantry.updateScene(parts);
+    }
+
+    RosCell::RosCell(MyCompetitionClass& competition, LogicalCamera& cam, Arm& arm, gantry_motioncontrol::Gantry& gantry,
+        FlipScheduler& flips, AgvFleet& fleet, AssemblyStationManager& stations, PartMap& parts,
+        std::vector<int>& empty_bins)
+        : competition_(competition), cam_(cam), arm_(arm), gantry_(gantry), flips_(flips), fleet_(fleet),
+        stations_(stations), parts_(parts), empty_bins_(empty_bins)
+    {
+    }
+
+    std::vector<Order> RosCell::orders()
+    {
+        return competition_.get_order_list();
+    }
+
+    bool RosCell::placeWithArm(const Product& part, const Product& product, const std::string& agv)
+    {
+        return arm_.movePart(product.type, part.world_pose, product.frame_pose, agv);
+    }
+
+    bool RosCell::placeWithGantry(const Product& part, const Product& product, const std::string& agv)
+    {
+        if (part.camera.compare("logical_camera_bins0") == 0)
+            gantry_.goToPresetLocation(gantry_.at_bins1234_);
+        else
+            gantry_.goToPresetLocation(gantry_.at_bins5678_);
+        gantry_.move_gantry_to_bin(part.bin_number, product.type, part.world_pose);
+        bool placed = gantry_.movePart(part.world_pose, product.frame_pose, agv, product.type);
+        gantry_.goToPresetLocation(gantry_.home_);
+        return placed;
+    }
+
+    std::shared_future<bool> RosCell::startFlip(const Product& part, const Product& product, const std::string& agv)
+    {
+        return flips_.start(part, product.frame_pose, agv, empty_bins_);
+    }
+
+    void RosCell::prepositionArm(const geometry_msgs::Pose& pick)
+    {
+        arm_.prepositionBase(pick.position.y - 0.3);
+    }
+
+    bool RosCell::blackout()
+    {
+        if (ros::Time::now().toSec() - competition_.CheckBlackout() > 2) {
+            ROS_INFO_STREAM("[RosCell][blackout] Sensor blackout");
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<Product> RosCell::faultyParts()
+    {
+        cam_.query_faulty_cam();
+        {
+            tracing::Span span("wait", "quality_control");
+            ros::Duration(4.0).sleep();
+        }
+        return cam_.faulty_part_list_;
+    }
+
+    geometry_msgs::Pose RosCell::slot(const Product& product, const std::string& agv)
+    {
+        return transformtoWorldFrame(product.frame_pose, agv);
+    }
+
+    bool RosCell::replaceFaulty(const Product& product, const geometry_msgs::Pose& faulty, const geometry_msgs::Pose& spare,
+        const std::string& agv)
+    {
+        return arm_.replaceFaultyPart(product.type, faulty, spare, product.frame_pose, agv);
+    }
+
+    void RosCell::discardFaulty(const Product& product, const geometry_msgs::Pose& faulty)
+    {
+        arm_.pickfaulty(product.type, faulty);
+        arm_.goToPresetLocation("home2");
+        arm_.deactivateGripper();
+    }
+
+    void RosCell::ship(const Kitting& kit)
+    {
+        shipments_[kit.station_id].push_back(
+            Shipment{ kit, fleet_.shipAsync(kit.agv_id, kit.shipment_type, kit.station_id).share() });
+    }
+
+    bool RosCell::waitForDeliveries(const std::string& station)
+    {
+        bool shipped{ true };
+        for (auto& shipment : shipments_[station]) {
+            if (shipment.shipped.get())
+                continue;
+            // most often the AGV was not ready to deliver yet
+            ROS_WARN_STREAM("[RosCell][waitForDeliveries] " << shipment.kit.shipment_type << " on "
+                << shipment.kit.agv_id << " was rejected, shipping it again");
+            if (!fleet_.shipAsync(shipment.kit.agv_id, shipment.kit.shipment_type, station).get()) {
+                ROS_ERROR_STREAM("[RosCell][waitForDeliveries] " << shipment.kit.shipment_type << " could not be shipped");
+                shipped = false;
+            }
+        }
+        shipments_.erase(station);
+        return fleet_.waitForDeliveries(station, ros::Duration(15.0)) && shipped;
+    }
+
+    PartMap RosCell::scan()
+    {
+        auto list = cam_.findparts();
+        updatePlanningScenes(list, arm_, gantry_);
+        cam_.segregate_parts(list);
+        PartMap parts = cam_.get_camera_map();
+        // pause before the gantry reaches into the stations
+        {
+            tracing::Span span("wait", "list_delay");
+            ros::Duration(5.0).sleep();
+        }
+        return parts;
+    }
+
+    bool RosCell::placeInBriefcase(const Product& part, const Product& product, const std::string& station)
+    {
+        gantry_.move_gantry_to_assembly_station(part.camera);
+        return gantry_.movePart(part.world_pose, product.frame_pose, station, product.type);
+    }
+
+    std::vector<std::string> RosCell::checkBriefcase(const Assembly& assembly)
+    {
+        {
+            tracing::Span span("wait", "settle");
+            ros::Duration(1.0).sleep();
+        }
+        std::vector<std::string> missing;
+        stations_.validate(assembly, missing);
+        return missing;
+    }
+
+    void RosCell::submit(const Assembly& assembly)
+    {
+        // the service call runs on the manager thread
+        stations_.submitAsync(assembly);
+        // through home2 when coming back from as2/as4
+        gantry_.goToLocation("home");
+    }
+}//namespace
@@ -0,0 +1,185 @@
+#include "../include/sim/sim_cell.h"
+#include <algorithm>
+
+namespace sim {
+    namespace {
+        bool kitting_arm_bin(int bin)
+        {
+            return bin == 1 || bin == 2 || bin == 5 || bin == 6;
+        }
+    }
+
+    SimCell::SimCell(SimWorld& world, SimArm& arm, SimGantry& gantry, SimLogicalCamera& cam,
+        std::map<std::string, SimAgv>& agvs, std::map<std::string, std::vector<Product> >& parts,
+        std::vector<int>& empty_bins)
+        : world_(world), arm_(arm), gantry_(gantry), cam_(cam), agvs_(agvs), parts_(parts), empty_bins_(empty_bins)
+    {
+    }
+
+    bool SimCell::placeWithArm(const Product& part, const Product& product, const std::string& agv)
+    {
+        return arm_.movePart(product.type, part.world_pose, product.frame_pose, agv);
+    }
+
+    bool SimCell::placeWithGantry(const Product& part, const Product& product, const std::string& agv)
+    {
+        gantry_.goToPresetLocation(part.camera.compare("logical_camera_bins0") == 0 ? "at_bins1234" : "at_bins5678");
+        gantry_.move_gantry_to_bin(part.bin_number, product.type, part.world_pose);
+        bool placed = gantry_.movePart(part.world_pose, product.frame_pose, agv, product.type);
+        gantry_.goToPresetLocation("home");
+        return placed;
+    }
+
+    std::shared_future<bool> SimCell::startFlip(const Product& part, const Product& product, const std::string& agv)
+    {
+        auto placed = std::make_shared<std::promise<bool> >();
+        flips_.push_back(Flip{ part, product, agv, !kitting_arm_bin(part.bin_number), world_.now(), placed });
+        return placed->get_future().share();
+    }
+
+    void SimCell::waitFor(const std::string& robot)
+    {
+        run_flips(robot);
+    }
+
+    bool SimCell::idle(const std::string& robot) const
+    {
+        if (robot.compare("gantry") != 0)
+            return flips_.empty();
+        return std::none_of(flips_.begin(), flips_.end(), [](const Flip& flip) { return flip.handover; });
+    }
+
+    void SimCell::waitAll()
+    {
+        run_flips("");
+    }
+
+    void SimCell::run_flips(const std::string& robot)
+    {
+        std::size_t last{ 0 };
+        for (std::size_t i = 0; i < flips_.size(); i++) {
+            if (robot.empty() || robot.compare("kitting_arm") == 0 || flips_.at(i).handover)
+                last = i + 1;
+        }
+        std::vector<Flip> due(flips_.begin(), flips_.begin() + last);
+        flips_.erase(flips_.begin(), flips_.begin() + last);
+
+        for (auto& flip : due) {
+            // from its start, or once the flip before it is over, it ran beside the clock
+            double start = std::max(flip.started, flips_free_);
+            world_.overlap(std::max(0.0, world_.now() - start));
+            bool placed;
+            if (flip.handover) {
+                // the bin the arm flips in when it did not pick the part itself
+                unsigned short int staging = 2;
+                for (auto bin : empty_bins_) {
+                    if (kitting_arm_bin(bin)) {
+                        staging = bin;
+                        break;
+                    }
+                }
+                gantry_.move_gantry_to_bin(flip.part.bin_number);
+                placed = gantry_.movePartfrombin(flip.part.world_pose, flip.part.type, staging)
+                    && arm_.flippart(flip.part, empty_bins_, flip.product.frame_pose, flip.agv, false);
+            }
+            else {
+                placed = arm_.flippart(flip.part, empty_bins_, flip.product.frame_pose, flip.agv, true);
+            }
+            // credit not used up: the flip was over before now
+            flips_free_ = world_.now() - world_.overlap(0);
+            flip.placed->set_value(placed);
+        }
+    }
+
+    void SimCell::prepositionArm(const geometry_msgs::Pose& pick)
+    {
+        arm_.prepositionBase(pick.position.y - 0.3);
+    }
+
+    std::vector<Product> SimCell::faultyParts()
+    {
+        world_.spend(world_.timing().qc_delay);
+        cam_.query_faulty_cam();
+        return cam_.faulty_part_list_;
+    }
+
+    geometry_msgs::Pose SimCell::slot(const Product& product, const std::string& agv)
+    {
+        return world_.trayPose(agv, product.frame_pose);
+    }
+
+    bool SimCell::replaceFaulty(const Product& product, const geometry_msgs::Pose& faulty, const geometry_msgs::Pose& spare,
+        const std::string& agv)
+    {
+        return arm_.replaceFaultyPart(product.type, faulty, spare, product.frame_pose, agv);
+    }
+
+    void SimCell::discardFaulty(const Product& product, const geometry_msgs::Pose& faulty)
+    {
+        arm_.pickfaulty(product.type, faulty);
+        arm_.goToPresetLocation("home2");
+        arm_.deactivateGripper();
+    }
+
+    void SimCell::ship(const Kitting& kit)
+    {
+        shipments_[kit.station_id].push_back(Shipment{ kit, agvs_.at(kit.agv_id).shipAgv(kit.shipment_type, kit.station_id) });
+    }
+
+    bool SimCell::waitForDeliveries(const std::string& station)
+    {
+        bool shipped{ true };
+        std::vector<std::string> expected;
+        for (auto& shipment : shipments_[station]) {
+            if (!shipment.shipped && !agvs_.at(shipment.kit.agv_id).shipAgv(shipment.kit.shipment_type, station)) {
+                ROS_ERROR_STREAM("[SimCell][waitForDeliveries] " << shipment.kit.shipment_type << " could not be shipped");
+                shipped = false;
+                continue;
+            }
+            expected.push_back(shipment.kit.agv_id);
+        }
+        shipments_.erase(station);
+        bool arrived = world_.waitFor([this, &station, &expected]() {
+            for (auto& agv : expected) {
+                if (world_.agvLocation(agv) != station)
+                    return false;
+            }
+            return true;
+        }, 15.0);
+        return arrived && shipped;
+    }
+
+    std::map<std::string, std::vector<Product> > SimCell::scan()
+    {
+        cam_.segregate_parts(cam_.findparts());
+        return cam_.get_camera_map();
+    }
+
+    bool SimCell::placeInBriefcase(const Product& part, const Product& product, const std::string& station)
+    {
+        gantry_.move_gantry_to_assembly_station(part.camera);
+        return gantry_.movePart(part.world_pose, product.frame_pose, station, product.type);
+    }
+
+    std::vector<std::string> SimCell::checkBriefcase(const Assembly& assembly)
+    {
+        // the settle of the last part, as on the robots
+        world_.spend(1.0);
+        std::map<std::string, int> seen;
+        for (auto& part : cam_.get_station_parts(assembly.stations))
+            seen[part.type]++;
+        std::vector<std::string> missing;
+        for (auto& product : assembly.products) {
+            if (seen[product.type]-- <= 0)
+                missing.push_back(product.type);
+        }
+        return missing;
+    }
+
+    void SimCell::submit(const Assembly& assembly)
+    {
+        world_.spend(world_.timing().station_submit);
+        world_.submitAssembly(assembly.stations, assembly.shipment_type);
+        gantry_.goToLocation("home");
+    }
+}//namespace
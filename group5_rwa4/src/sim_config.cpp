@@ -0,0 +1,217 @@
+#include "../include/sim/sim_config.h"
+#include <yaml-cpp/yaml.h>
+#include <cmath>
+
+namespace sim {
+    namespace {
+        // same origins as the kitting arm
+        const std::array<std::array<double, 3>, 8> bin_origins{ {
+            { -1.898, 3.37, 0.751 }, { -1.898, 2.56, 0.751 }, { -2.651, 2.56, 0.751 }, { -2.651, 3.37, 0.751 },
+            { -1.898, -3.37, 0.751 }, { -1.898, -2.56, 0.751 }, { -2.651, -2.56, 0.751 }, { -2.651, -3.37, 0.751 } } };
+
+        // trial files write angles as numbers or as "pi", "-pi/2", ...
+        double parse_angle(const YAML::Node& node)
+        {
+            std::string text = node.as<std::string>();
+            double sign = 1.0;
+            if (!text.empty() && text[0] == '-') {
+                sign = -1.0;
+                text = text.substr(1);
+            }
+            if (text.compare(0, 2, "pi") != 0)
+                return sign * std::stod(text);
+            double value = M_PI;
+            auto slash = text.find('/');
+            if (slash != std::string::npos)
+                value /= std::stod(text.substr(slash + 1));
+            return sign * value;
+        }
+
+        geometry_msgs::Pose make_pose(const YAML::Node& pose)
+        {
+            geometry_msgs::Pose result;
+            result.orientation.w = 1.0;
+            if (pose["xyz"]) {
+                result.position.x = pose["xyz"][0].as<double>();
+                result.position.y = pose["xyz"][1].as<double>();
+                result.position.z = pose["xyz"][2].as<double>();
+            }
+            if (pose["rpy"]) {
+                double r = parse_angle(pose["rpy"][0]) / 2, p = parse_angle(pose["rpy"][1]) / 2, y = parse_angle(pose["rpy"][2]) / 2;
+                result.orientation.x = std::sin(r) * std::cos(p) * std::cos(y) - std::cos(r) * std::sin(p) * std::sin(y);
+                result.orientation.y = std::cos(r) * std::sin(p) * std::cos(y) + std::sin(r) * std::cos(p) * std::sin(y);
+                result.orientation.z = std::cos(r) * std::cos(p) * std::sin(y) - std::sin(r) * std::sin(p) * std::cos(y);
+                result.orientation.w = std::cos(r) * std::cos(p) * std::cos(y) + std::sin(r) * std::sin(p) * std::sin(y);
+            }
+            return result;
+        }
+
+        std::vector<Product> parse_products(const YAML::Node& products)
+        {
+            std::vector<Product> result;
+            for (auto item : products) {
+                Product product;
+                product.type = item.second["type"].as<std::string>();
+                product.frame_pose = make_pose(item.second["pose"]);
+                product.processed = false;
+                result.push_back(product);
+            }
+            return result;
+        }
+    }
+
+    bool SimTiming::load(const std::string& path)
+    {
+        YAML::Node root;
+        try {
+            root = YAML::LoadFile(path);
+        }
+        catch (const YAML::Exception& e) {
+            ROS_ERROR_STREAM("[SimTiming][load] " << path << ": " << e.what());
+            return false;
+        }
+        auto read = [&root](const char* key, double& value) {
+            if (root[key])
+                value = root[key].as<double>();
+        };
+        read("arm_rail_speed", arm_rail_speed);
+        read("arm_pick", arm_pick);
+        read("arm_place", arm_place);
+        read("arm_preset", arm_preset);
+        read("arm_discard", arm_discard);
+        read("arm_flip", arm_flip);
+        read("gantry_speed", gantry_speed);
+        read("gantry_pick", gantry_pick);
+        read("gantry_place", gantry_place);
+        read("gantry_preset", gantry_preset);
+        read("gantry_pregrasp", gantry_pregrasp);
+        read("agv_transit", agv_transit);
+        read("qc_delay", qc_delay);
+        read("camera_refresh", camera_refresh);
+        read("station_submit", station_submit);
+        read("conveyor_pick", conveyor_pick);
+        read("jitter", jitter);
+        read("fault_rate", fault_rate);
+        return true;
+    }
+
+    bool TrialConfig::load(const std::string& path)
+    {
+        YAML::Node root;
+        try {
+            root = YAML::LoadFile(path);
+        }
+        catch (const YAML::Exception& e) {
+            ROS_ERROR_STREAM("[TrialConfig][load] " << path << ": " << e.what());
+            return false;
+        }
+
+        // ARIAC numbers the models of each type from 1 in spawn order
+        std::map<std::string, int> type_count;
+        auto name_part = [&type_count](TrialPart& part) {
+            part.name = part.type + "_" + std::to_string(++type_count[part.type]);
+        };
+
+        for (auto agv : root["agv_infos"]) {
+            auto agv_id = agv.first.as<std::string>();
+            agv_locations[agv_id] = agv.second["location"].as<std::string>();
+            for (auto item : agv.second["products"]) {
+                TrialPart part;
+                part.type = item.second["type"].as<std::string>();
+                part.agv = agv_id;
+                part.world_pose = make_pose(item.second["pose"]);
+                name_part(part);
+                parts.push_back(part);
+            }
+        }
+
+        for (auto bin : root["models_over_bins"]) {
+            int bin_number = std::stoi(bin.first.as<std::string>().substr(3));
+            if (bin_number < 1 || bin_number > 8)
+                continue;
+            auto& origin = bin_origins.at(bin_number - 1);
+            for (auto model : bin.second["models"]) {
+                int nx = model.second["num_models_x"] ? model.second["num_models_x"].as<int>() : 1;
+                int ny = model.second["num_models_y"] ? model.second["num_models_y"].as<int>() : 1;
+                auto start = model.second["xyz_start"];
+                auto end = model.second["xyz_end"];
+                for (int i = 0; i < nx; i++) {
+                    for (int j = 0; j < ny; j++) {
+                        TrialPart part;
+                        part.type = model.first.as<std::string>();
+                        part.bin_number = bin_number;
+                        double fx = nx > 1 ? double(i) / (nx - 1) : 0.0;
+                        double fy = ny > 1 ? double(j) / (ny - 1) : 0.0;
+                        YAML::Node pose;
+                        if (model.second["rpy"])
+                            pose["rpy"] = model.second["rpy"];
+                        part.world_pose = make_pose(pose);
+                        part.world_pose.position.x = origin[0] + start[0].as<double>() + fx * (end[0].as<double>() - start[0].as<double>());
+                        part.world_pose.position.y = origin[1] + start[1].as<double>() + fy * (end[1].as<double>() - start[1].as<double>());
+                        part.world_pose.position.z = origin[2];
+                        name_part(part);
+                        parts.push_back(part);
+                    }
+                }
+            }
+        }
+
+        for (auto model : root["belt_models"]) {
+            for (auto spawn : model.second) {
+                TrialPart part;
+                part.type = model.first.as<std::string>();
+                part.belt_time = spawn.first.as<double>();
+                part.world_pose = make_pose(spawn.second["pose"]);
+                name_part(part);
+                parts.push_back(part);
+            }
+        }
+
+        for (auto item : root["orders"]) {
+            TrialOrder trial_order;
+            auto& order = trial_order.order;
+            auto node = item.second;
+            order.order_id = item.first.as<std::string>();
+            order.priority = node["priority"] ? node["priority"].as<unsigned short>() : 1;
+            order.order_processed = false;
+            trial_order.condition = node["announcement_condition"] ? node["announcement_condition"].as<std::string>() : "time";
+            trial_order.condition_value = node["announcement_condition_value"] ? node["announcement_condition_value"].as<std::string>() : "0";
+
+            if (node["kitting"]) {
+                auto products = parse_products(node["kitting"]["products"]);
+                int count = node["kitting"]["shipment_count"].as<int>();
+                for (int i = 0; i < count; i++) {
+                    Kitting kit;
+                    kit.shipment_type = order.order_id + "_kitting_shipment_" + std::to_string(i);
+                    kit.agv_id = node["kitting"]["agvs"][i].as<std::string>();
+                    kit.station_id = node["kitting"]["destinations"][i].as<std::string>();
+                    kit.products = products;
+                    kit.kitting_done = false;
+                    order.kitting.push_back(kit);
+                }
+            }
+            if (node["assembly"]) {
+                auto products = parse_products(node["assembly"]["products"]);
+                int count = node["assembly"]["shipment_count"].as<int>();
+                for (int i = 0; i < count; i++) {
+                    Assembly assembly;
+                    assembly.shipment_type = order.order_id + "_assembly_shipment_" + std::to_string(i);
+                    assembly.stations = node["assembly"]["stations"][i].as<std::string>();
+                    assembly.products = products;
+                    assembly.asssembly_done = false;
+                    order.assembly.push_back(assembly);
+                }
+            }
+            orders.push_back(trial_order);
+        }
+
+        for (auto name : root["faulty_products"])
+            faulty_products.push_back(name.as<std::string>());
+
+        if (root["sensor_blackout"]) {
+            blackout_product_count = root["sensor_blackout"]["product_count"].as<int>();
+            blackout_duration = root["sensor_blackout"]["duration"].as<double>();
+        }
+        return true;
+    }
+}//namespace
@@ -0,0 +1,31 @@
+#include "../include/sim/event_queue.h"
+#include <algorithm>
+
+namespace sim {
+    void EventQueue::schedule(double time, Action action)
+    {
+        events_.push(Event{ std::max(time, now_), sequence_++, action });
+    }
+
+    void EventQueue::runUntil(double time)
+    {
+        while (!events_.empty() && events_.top().time <= time) {
+            // copy out before popping, the action may schedule more events
+            Event event = events_.top();
+            events_.pop();
+            now_ = event.time;
+            event.action();
+        }
+        now_ = std::max(now_, time);
+    }
+
+    void EventQueue::runAll()
+    {
+        while (!events_.empty()) {
+            Event event = events_.top();
+            events_.pop();
+            now_ = event.time;
+            event.action();
+        }
+    }
+}//namespace
@@ -0,0 +1,83 @@
+#include "../include/sim/sim_trial.h"
+#include "../include/sim/sim_cell.h"
+#include "../include/executor/preemption.h"
+#include <algorithm>
+#include <set>
+
+namespace sim {
+    TrialResult runTrial(const TrialConfig& trial, const SimTiming& timing, unsigned int seed, const Policy& policy)
+    {
+        SimWorld world(trial, timing, seed);
+        SimArm arm(world);
+        SimGantry gantry(world);
+        SimLogicalCamera cam(world);
+        std::map<std::string, SimAgv> agvs;
+        for (const std::string agv_id : { "agv1", "agv2", "agv3", "agv4" })
+            agvs.emplace(agv_id, SimAgv(world, agv_id));
+
+        // conveyor parts go to an empty bin first
+        auto empty_bins = cam.get_ebin_list();
+        bool belt_expected = std::any_of(trial.parts.begin(), trial.parts.end(),
+            [](const TrialPart& part) { return part.belt_time >= 0 && part.belt_time <= 25.0; });
+        if (belt_expected)
+            empty_bins = arm.pick_from_conveyor(empty_bins, 4);
+        cam.segregate_parts(cam.findparts());
+        auto cam_map = cam.get_camera_map();
+
+        std::set<std::string> done_orders;
+        std::function<void()> process_high_priority;
+        SimCell cell(world, arm, gantry, cam, agvs, cam_map, empty_bins);
+        motioncontrol::PreemptionManager preemption(
+            [&]() {
+                if (!policy.preemption)
+                    return false;
+                for (auto& order : world.announcedOrders()) {
+                    if (order.priority > 1 && done_orders.count(order.order_id) == 0)
+                        return true;
+                }
+                return false;
+            },
+            [&]() {
+                cell.waitAll();
+                process_high_priority();
+            });
+        motioncontrol::OrderSequencer<SimCell> sequencer(cell, preemption, policy.sequencer);
+        sequencer.reserveSpares();
+
+        auto process_order = [&](const Order& order) {
+            done_orders.insert(order.order_id);
+            sequencer.processOrder(order);
+        };
+        process_high_priority = [&]() {
+            for (auto& order : world.announcedOrders()) {
+                if (order.priority > 1 && done_orders.count(order.order_id) == 0) {
+                    sequencer.reserveSpares();
+                    process_order(order);
+                }
+            }
+        };
+
+        const double give_up{ 3600.0 };
+        while (!world.allSubmitted() && world.now() < give_up) {
+            bool progressed{ false };
+            for (auto& order : world.announcedOrders()) {
+                if (done_orders.count(order.order_id) == 0) {
+                    process_order(order);
+                    progressed = true;
+                    break;
+                }
+            }
+            if (!progressed) {
+                std::size_t announced = world.announcedOrders().size();
+                if (!world.waitFor([&]() { return world.announcedOrders().size() > announced; }, 60.0))
+                    break;
+            }
+        }
+
+        TrialResult result;
+        result.score = world.score();
+        result.makespan = world.makespan();
+        result.completed = world.allSubmitted();
+        return result;
+    }
+}//namespace
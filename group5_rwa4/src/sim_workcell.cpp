@@ -0,0 +1,709 @@
+#include "../include/sim/sim_workcell.h"
+#include <algorithm>
+#include <cmath>
+
+namespace sim {
+    namespace {
+        // tray centres along the rail, same y as the kitting arm agv presets
+        const std::map<std::string, double> agv_rail_y{
+            { "agv1", 3.83 }, { "agv2", 0.83 }, { "agv3", -1.83 }, { "agv4", -4.33 } };
+        const double tray_x{ -2.265 };
+
+        const std::array<std::array<double, 2>, 8> bin_xy{ {
+            { -1.898, 3.37 }, { -1.898, 2.56 }, { -2.651, 2.56 }, { -2.651, 3.37 },
+            { -1.898, -3.37 }, { -1.898, -2.56 }, { -2.651, -2.56 }, { -2.651, -3.37 } } };
+
+        // gantry preset locations in world x/y
+        const std::map<std::string, std::array<double, 2> > gantry_locations{
+            { "home", { -2.5, 0.0 } }, { "home2", { -9.5, 0.0 } },
+            { "at_bins1234", { -2.3, 2.9 } }, { "at_bins5678", { -2.3, -2.9 } },
+            { "as1", { -7.3, 3.0 } }, { "as2", { -12.3, 3.0 } },
+            { "as3", { -7.3, -3.0 } }, { "as4", { -12.3, -3.0 } } };
+
+        double roll_of(const geometry_msgs::Pose& pose)
+        {
+            auto& q = pose.orientation;
+            return std::atan2(2.0 * (q.w * q.x + q.y * q.z), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+        }
+
+        bool same_roll(double a, double b)
+        {
+            return std::abs(std::remainder(a - b, 2 * M_PI)) < 0.5;
+        }
+
+        // world pose of a part on the tray of an AGV parked at @p location (ks or as)
+        geometry_msgs::Pose tray_pose(const std::string& agv, const geometry_msgs::Pose& frame_pose, const std::string& location = "ks")
+        {
+            geometry_msgs::Pose pose = frame_pose;
+            auto station = gantry_locations.find(location);
+            if (station != gantry_locations.end()) {
+                pose.position.x += station->second[0];
+                pose.position.y += station->second[1];
+                return pose;
+            }
+            auto y = agv_rail_y.find(agv);
+            pose.position.x += tray_x;
+            pose.position.y += y == agv_rail_y.end() ? 0.0 : y->second;
+            return pose;
+        }
+
+        std::string station_of(const std::string& text)
+        {
+            for (const std::string station : { "as1", "as2", "as3", "as4" }) {
+                if (text.find(station) != std::string::npos)
+                    return station;
+            }
+            return "";
+        }
+    }
+
+    SimWorld::SimWorld(const TrialConfig& trial, const SimTiming& timing, unsigned int seed)
+        : timing_(timing), rng_(seed), trial_orders_(trial.orders), agv_locations_(trial.agv_locations),
+        blackout_product_count_(trial.blackout_product_count), blackout_duration_(trial.blackout_duration)
+    {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for (auto& part : trial.parts) {
+            PartState state;
+            state.part = part;
+            state.world_pose = part.world_pose;
+            state.faulty = std::find(trial.faulty_products.begin(), trial.faulty_products.end(), part.name) != trial.faulty_products.end()
+                || (part.agv.empty() && uniform(rng_) < timing_.fault_rate);
+            if (!part.agv.empty()) {
+                state.location = "agv";
+                state.holder = part.agv;
+                state.frame_pose = part.world_pose;
+                auto location = trial.agv_locations.find(part.agv);
+                state.world_pose = tray_pose(part.agv, part.world_pose, location == trial.agv_locations.end() ? "ks" : location->second);
+            }
+            else if (part.belt_time >= 0) {
+                state.location = "incoming";
+            }
+            else {
+                state.location = "bin";
+            }
+            parts_.push_back(state);
+        }
+
+        for (std::size_t i = 0; i < parts_.size(); i++) {
+            if (parts_[i].location.compare("incoming") == 0)
+                events_.schedule(parts_[i].part.belt_time, [this, i]() { parts_[i].location = "belt"; });
+        }
+
+        for (auto& order : trial_orders_) {
+            if (order.condition.compare("time") == 0) {
+                events_.schedule(std::stod(order.condition_value), [this, order]() { announce(order); });
+            }
+            else {
+                pending_.push_back(order);
+            }
+        }
+        events_.runUntil(0.0);
+    }
+
+    void SimWorld::spend(double seconds)
+    {
+        std::uniform_real_distribution<double> noise(-timing_.jitter, timing_.jitter);
+        double duration = std::max(0.0, seconds * (1.0 + noise(rng_)));
+        // the part of it already done beside the clock
+        double credited = std::min(overlap_, duration);
+        overlap_ -= credited;
+        events_.runUntil(now() + duration - credited);
+    }
+
+    double SimWorld::overlap(double seconds)
+    {
+        double left = overlap_;
+        overlap_ = std::max(0.0, seconds);
+        return left;
+    }
+
+    bool SimWorld::waitFor(std::function<bool()> condition, double timeout)
+    {
+        double deadline = now() + timeout;
+        while (!condition()) {
+            if (now() >= deadline)
+                return false;
+            events_.runUntil(std::min(deadline, now() + 0.5));
+        }
+        return true;
+    }
+
+    bool SimWorld::highPriorityAnnounced() const
+    {
+        for (auto& order : announced_) {
+            if (order.priority > 1)
+                return true;
+        }
+        return false;
+    }
+
+    int SimWorld::partNear(const geometry_msgs::Pose& pose, const std::string& location, const std::string& holder) const
+    {
+        int best{ -1 };
+        double best_distance{ 0 };
+        for (std::size_t i = 0; i < parts_.size(); i++) {
+            auto& part = parts_[i];
+            if (part.location != location || (!holder.empty() && part.holder != holder))
+                continue;
+            double distance = std::hypot(part.world_pose.position.x - pose.position.x, part.world_pose.position.y - pose.position.y);
+            if (best < 0 || distance < best_distance) {
+                best = static_cast<int>(i);
+                best_distance = distance;
+            }
+        }
+        return best;
+    }
+
+    void SimWorld::place(int index, const std::string& location, const std::string& holder,
+        const geometry_msgs::Pose& frame_pose, const geometry_msgs::Pose& world_pose)
+    {
+        auto& part = parts_.at(index);
+        // the gripper only turns the part about z, the roll it had is kept
+        double roll = roll_of(part.world_pose);
+        part.location = location;
+        part.holder = holder;
+        part.frame_pose = frame_pose;
+        part.world_pose = world_pose;
+        if (!same_roll(roll, roll_of(world_pose))) {
+            part.world_pose.orientation = geometry_msgs::Quaternion();
+            part.world_pose.orientation.x = std::sin(roll / 2);
+            part.world_pose.orientation.w = std::cos(roll / 2);
+        }
+
+        if (location.compare("agv") == 0 || location.compare("station") == 0) {
+            placed_count_++;
+            if (placed_count_ == blackout_product_count_)
+                blackout_end_ = now() + blackout_duration_;
+            check_conditions();
+        }
+    }
+
+    std::string SimWorld::agvLocation(const std::string& agv) const
+    {
+        auto location = agv_locations_.find(agv);
+        return location == agv_locations_.end() ? "" : location->second;
+    }
+
+    geometry_msgs::Pose SimWorld::trayPose(const std::string& agv, const geometry_msgs::Pose& frame_pose) const
+    {
+        return tray_pose(agv, frame_pose, agvLocation(agv));
+    }
+
+    bool SimWorld::shipAgv(const std::string& agv, const std::string& shipment_type, const std::string& station)
+    {
+        if (agvLocation(agv).compare(0, 2, "ks") != 0)
+            return false;
+        auto order = find_order(shipment_type);
+        if (order != nullptr) {
+            for (auto& kit : order->order.kitting) {
+                if (kit.shipment_type == shipment_type)
+                    score_ += shipment_score(kit.products, "agv", agv, order->order.priority);
+            }
+        }
+        submitted_++;
+        makespan_ = now();
+
+        agv_locations_[agv] = "transit";
+        events_.schedule(now() + timing_.agv_transit, [this, agv, station]() {
+            agv_locations_[agv] = station;
+            for (auto& part : parts_) {
+                if (part.location.compare("agv") == 0 && part.holder == agv) {
+                    auto orientation = part.world_pose.orientation;
+                    part.world_pose = tray_pose(agv, part.frame_pose, station);
+                    part.world_pose.orientation = orientation;
+                }
+            }
+            agv_arrivals_[agv + "_at_" + station] = station;
+            check_conditions();
+        });
+        return true;
+    }
+
+    bool SimWorld::submitAssembly(const std::string& station, const std::string& shipment_type)
+    {
+        auto order = find_order(shipment_type);
+        if (order != nullptr) {
+            for (auto& assembly : order->order.assembly) {
+                if (assembly.shipment_type == shipment_type)
+                    score_ += shipment_score(assembly.products, "station", station, order->order.priority);
+            }
+        }
+        submitted_++;
+        makespan_ = now();
+        return true;
+    }
+
+    bool SimWorld::allSubmitted() const
+    {
+        if (!pending_.empty())
+            return false;
+        std::size_t total{ 0 };
+        for (auto& order : trial_orders_)
+            total += order.order.kitting.size() + order.order.assembly.size();
+        return submitted_ >= total;
+    }
+
+    void SimWorld::announce(const TrialOrder& order)
+    {
+        announced_.push_back(order.order);
+    }
+
+    void SimWorld::check_conditions()
+    {
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            bool met{ false };
+            if (it->condition.compare("agv_station_reached") == 0)
+                met = agv_arrivals_.count(it->condition_value) > 0;
+            else if (it->condition.compare("wanted_products") == 0 || it->condition.compare("unwanted_products") == 0)
+                met = placed_count_ >= std::stod(it->condition_value);
+            if (met) {
+                announce(*it);
+                it = pending_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    double SimWorld::shipment_score(const std::vector<Product>& products, const std::string& location,
+        const std::string& holder, unsigned short priority) const
+    {
+        // one point per right part, one per right pose, all-correct bonus of one per product
+        std::vector<bool> used(parts_.size(), false);
+        double points{ 0 };
+        std::size_t complete{ 0 };
+        for (auto& product : products) {
+            for (std::size_t i = 0; i < parts_.size(); i++) {
+                auto& part = parts_[i];
+                if (used[i] || part.location != location || part.holder != holder || part.part.type != product.type || part.faulty)
+                    continue;
+                used[i] = true;
+                points += 1;
+                if (same_roll(roll_of(part.world_pose), roll_of(product.frame_pose))) {
+                    points += 1;
+                    complete++;
+                }
+                break;
+            }
+        }
+        if (complete == products.size())
+            points += products.size();
+        return points * priority;
+    }
+
+    const TrialOrder* SimWorld::find_order(const std::string& shipment_type) const
+    {
+        for (auto& order : trial_orders_) {
+            for (auto& kit : order.order.kitting) {
+                if (kit.shipment_type == shipment_type)
+                    return &order;
+            }
+            for (auto& assembly : order.order.assembly) {
+                if (assembly.shipment_type == shipment_type)
+                    return &order;
+            }
+        }
+        return nullptr;
+    }
+
+    /////////////////////////////////////////////////////
+    void SimArm::finishPreposition()
+    {
+        if (preposition_start_ < 0)
+            return;
+        double moved = (world_.now() - preposition_start_) * world_.timing().arm_rail_speed;
+        double left = preposition_y_ - rail_y_;
+        rail_y_ += std::abs(left) <= moved ? left : std::copysign(moved, left);
+        preposition_start_ = -1;
+    }
+
+    void SimArm::moveBaseTo(double linear_arm_actuator_joint_position)
+    {
+        finishPreposition();
+        world_.spend(std::abs(linear_arm_actuator_joint_position - rail_y_) / world_.timing().arm_rail_speed);
+        rail_y_ = linear_arm_actuator_joint_position;
+    }
+
+    bool SimArm::prepositionBase(double linear_arm_actuator_joint_position)
+    {
+        if (held_ >= 0)
+            return false;
+        finishPreposition();
+        preposition_y_ = linear_arm_actuator_joint_position;
+        preposition_start_ = world_.now();
+        return true;
+    }
+
+    void SimArm::goToPresetLocation(std::string location_name)
+    {
+        double y{ 0 };
+        auto agv = agv_rail_y.find(location_name);
+        if (agv != agv_rail_y.end())
+            y = agv->second;
+        else if (location_name.compare("on") == 0 || location_name.compare("above") == 0)
+            y = 1.76;
+        else if (location_name.compare("flip") == 0)
+            y = -3.97;
+        world_.spend(world_.timing().arm_preset);
+        moveBaseTo(y);
+    }
+
+    bool SimArm::pickPart(std::string part_type, geometry_msgs::Pose part_pose)
+    {
+        moveBaseTo(part_pose.position.y - 0.3);
+        world_.spend(world_.timing().arm_pick);
+        int index = world_.partNear(part_pose, "bin");
+        if (index < 0 || world_.parts().at(index).part.type != part_type)
+            return false;
+        world_.parts().at(index).location = "gripper";
+        held_ = index;
+        return true;
+    }
+
+    bool SimArm::pickfaulty(std::string part_type, geometry_msgs::Pose part_pose)
+    {
+        moveBaseTo(part_pose.position.y - 0.3);
+        world_.spend(world_.timing().arm_pick);
+        int index = world_.partNear(part_pose, "agv");
+        if (index < 0)
+            return false;
+        world_.parts().at(index).location = "gripper";
+        held_ = index;
+        return true;
+    }
+
+    bool SimArm::placePart(geometry_msgs::Pose part_init_pose, geometry_msgs::Pose part_goal_pose, std::string agv)
+    {
+        goToPresetLocation(agv);
+        world_.spend(world_.timing().arm_place);
+        if (held_ < 0)
+            return false;
+        world_.place(held_, "agv", agv, part_goal_pose, tray_pose(agv, part_goal_pose));
+        held_ = -1;
+        goToPresetLocation("home2");
+        return true;
+    }
+
+    bool SimArm::replaceFaultyPart(std::string part_type, geometry_msgs::Pose faulty_pose, geometry_msgs::Pose spare_pose, geometry_msgs::Pose goal_in_tray_frame, std::string agv)
+    {
+        if (!pickfaulty(part_type, faulty_pose))
+            return false;
+        world_.spend(world_.timing().arm_discard);
+        deactivateGripper();
+        if (!pickPart(part_type, spare_pose))
+            return false;
+        return placePart(spare_pose, goal_in_tray_frame, agv);
+    }
+
+    bool SimArm::movePart(std::string part_type, geometry_msgs::Pose pose_in_world_frame, geometry_msgs::Pose goal_in_tray_frame, std::string agv)
+    {
+        if (!pickPart(part_type, pose_in_world_frame))
+            return false;
+        return placePart(pose_in_world_frame, goal_in_tray_frame, agv);
+    }
+
+    void SimArm::deactivateGripper()
+    {
+        if (held_ >= 0)
+            world_.parts().at(held_).location = "discarded";
+        held_ = -1;
+    }
+
+    std::vector<int> SimArm::pick_from_conveyor(std::vector<int> ebin, unsigned short int count,
+        const std::vector<std::string>& wanted)
+    {
+        // same preference as the real arm: a bin it can reach from the rail
+        int bin{ 0 };
+        for (auto candidate : ebin) {
+            if (candidate == 1 || candidate == 2 || candidate == 5 || candidate == 6) {
+                bin = candidate;
+                break;
+            }
+        }
+        if (bin == 0)
+            return ebin;
+
+        auto on_belt = [this, &wanted]() {
+            for (auto& part : world_.parts()) {
+                if (part.location.compare("belt") == 0
+                    && (wanted.empty() || std::find(wanted.begin(), wanted.end(), part.part.type) != wanted.end()))
+                    return true;
+            }
+            return false;
+        };
+        for (unsigned short int picked = 0; picked < count; picked++) {
+            if (!world_.waitFor(on_belt, 30.0) || !interceptFromBelt(wanted))
+                break;
+            moveBaseTo(bin_xy.at(bin - 1)[1]);
+            world_.spend(world_.timing().arm_place);
+            auto& part = world_.parts().at(held_);
+            part.location = "bin";
+            part.part.bin_number = bin;
+            part.world_pose.position.x = bin_xy.at(bin - 1)[0];
+            part.world_pose.position.y = bin_xy.at(bin - 1)[1] + 0.1 * picked;
+            held_ = -1;
+            goToPresetLocation("above");
+        }
+        ebin.erase(std::remove(ebin.begin(), ebin.end(), bin), ebin.end());
+        return ebin;
+    }
+
+    bool SimArm::interceptFromBelt(const std::vector<std::string>& wanted)
+    {
+        for (std::size_t i = 0; i < world_.parts().size(); i++) {
+            auto& part = world_.parts().at(i);
+            if (part.location.compare("belt") != 0
+                || (!wanted.empty() && std::find(wanted.begin(), wanted.end(), part.part.type) == wanted.end()))
+                continue;
+            // the belt camera tracks it, the arm meets it where the rail reaches the belt
+            moveBaseTo(1.76);
+            world_.spend(world_.timing().conveyor_pick);
+            part.location = "gripper";
+            held_ = static_cast<int>(i);
+            return true;
+        }
+        return false;
+    }
+
+    bool SimArm::flippart(Product part, std::vector<int> rbin, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool pick)
+    {
+        if (pick) {
+            if (!pickPart(part.type, part.world_pose))
+                return false;
+        }
+        else {
+            // the gantry left the part in a staging bin
+            int index = world_.partNear(part.world_pose, "staged");
+            if (index < 0)
+                return false;
+            moveBaseTo(world_.parts().at(index).world_pose.position.y - 0.3);
+            world_.spend(world_.timing().arm_pick);
+            world_.parts().at(index).location = "gripper";
+            held_ = index;
+        }
+        world_.spend(world_.timing().arm_flip);
+        // flipped: the part takes the roll of the target
+        auto& held = world_.parts().at(held_);
+        held.world_pose.orientation = part_pose_in_frame.orientation;
+        return placePart(part.world_pose, part_pose_in_frame, agv);
+    }
+
+    /////////////////////////////////////////////////////
+    void SimGantry::travel_to(double x, double y)
+    {
+        world_.spend(world_.timing().gantry_preset + std::hypot(x - x_, y - y_) / world_.timing().gantry_speed);
+        x_ = x;
+        y_ = y;
+    }
+
+    double SimGantry::pick_time(const geometry_msgs::Pose& part_pose)
+    {
+        double pick = world_.timing().gantry_pick;
+        if (preshaped_ && std::hypot(part_pose.position.x - preshaped_for_.position.x,
+            part_pose.position.y - preshaped_for_.position.y) < 0.05)
+            pick -= world_.timing().gantry_pregrasp;
+        preshaped_ = false;
+        return std::max(0.0, pick);
+    }
+
+    void SimGantry::goToPresetLocation(std::string location_name)
+    {
+        preshaped_ = false;
+        auto location = gantry_locations.find(location_name);
+        if (location == gantry_locations.end()) {
+            world_.spend(world_.timing().gantry_preset);
+            return;
+        }
+        travel_to(location->second[0], location->second[1]);
+    }
+
+    bool SimGantry::goToLocation(const std::string& name)
+    {
+        preshaped_ = false;
+        auto location = gantry_locations.find(name);
+        if (location == gantry_locations.end())
+            return false;
+        travel_to(location->second[0], location->second[1]);
+        return true;
+    }
+
+    void SimGantry::move_gantry_to_bin(unsigned short int bin)
+    {
+        preshaped_ = false;
+        if (bin < 1 || bin > 8)
+            return;
+        travel_to(bin_xy.at(bin - 1)[0], bin_xy.at(bin - 1)[1]);
+    }
+
+    void SimGantry::move_gantry_to_bin(unsigned short int bin, const std::string& part_type, const geometry_msgs::Pose& part)
+    {
+        move_gantry_to_bin(bin);
+        preshaped_ = bin >= 1 && bin <= 8;
+        preshaped_for_ = part;
+    }
+
+    void SimGantry::move_gantry_to_assembly_station(std::string camera)
+    {
+        goToPresetLocation(station_of(camera));
+    }
+
+    bool SimGantry::movePart(geometry_msgs::Pose part_init_pose, geometry_msgs::Pose target_pose, std::string location, std::string part_type)
+    {
+        travel_to(part_init_pose.position.x, part_init_pose.position.y);
+        world_.spend(pick_time(part_init_pose));
+        // from a bin when kitting, from an AGV parked at a station when assembling
+        int index = world_.partNear(part_init_pose, "bin");
+        int on_agv = world_.partNear(part_init_pose, "agv");
+        auto distance = [this, &part_init_pose](int i) {
+            return i < 0 ? 1e9 : std::hypot(world_.parts().at(i).world_pose.position.x - part_init_pose.position.x,
+                world_.parts().at(i).world_pose.position.y - part_init_pose.position.y);
+        };
+        if (distance(on_agv) < distance(index))
+            index = on_agv;
+        if (index < 0 || world_.parts().at(index).part.type != part_type)
+            return false;
+
+        if (location.compare(0, 3, "agv") == 0) {
+            auto world_target = tray_pose(location, target_pose);
+            travel_to(world_target.position.x, world_target.position.y);
+            world_.spend(world_.timing().gantry_place);
+            world_.place(index, "agv", location, target_pose, world_target);
+        }
+        else {
+            goToPresetLocation(location);
+            world_.spend(world_.timing().gantry_place);
+            auto world_target = target_pose;
+            world_target.position.x += x_;
+            world_target.position.y += y_;
+            world_.place(index, "station", location, target_pose, world_target);
+        }
+        return true;
+    }
+
+    bool SimGantry::movePartfrombin(geometry_msgs::Pose part_init_pose, std::string part_type, unsigned short int bin)
+    {
+        travel_to(part_init_pose.position.x, part_init_pose.position.y);
+        world_.spend(pick_time(part_init_pose));
+        int index = world_.partNear(part_init_pose, "bin");
+        if (index < 0 || world_.parts().at(index).part.type != part_type)
+            return false;
+        move_gantry_to_bin(bin);
+        world_.spend(world_.timing().gantry_place);
+        auto& part = world_.parts().at(index);
+        part.location = "staged";
+        part.world_pose.position.x = x_;
+        part.world_pose.position.y = y_;
+        return true;
+    }
+
+    /////////////////////////////////////////////////////
+    bool SimAgv::shipAgv(std::string shipment_type, std::string station)
+    {
+        return world_.shipAgv(agv_name_, shipment_type, station);
+    }
+
+    bool SimAgv::getAGVStatus()
+    {
+        return world_.agvLocation(agv_name_).compare(0, 2, "ks") == 0;
+    }
+
+    /////////////////////////////////////////////////////
+    std::array<std::vector<Product>, 19> SimLogicalCamera::findparts()
+    {
+        static const std::vector<std::string> agv_cameras{
+            "agv1as1", "agv1as2", "agv1ks1", "agv2as1", "agv2as2", "agv2ks2",
+            "agv3as3", "agv3as4", "agv3ks3", "agv4as3", "agv4as4", "agv4ks4" };
+        world_.spend(world_.timing().camera_refresh);
+
+        std::array<std::vector<Product>, 19> list;
+        for (auto& state : world_.parts()) {
+            Product product;
+            product.type = state.part.type;
+            product.id = state.part.name;
+            product.world_pose = state.world_pose;
+            product.frame_pose = state.frame_pose;
+            product.status = "free";
+            product.processed = false;
+            product.bin_number = state.part.bin_number;
+
+            if (state.location.compare("bin") == 0) {
+                int slot = state.part.bin_number <= 4 ? 0 : 1;
+                product.camera = "logical_camera_bins" + std::to_string(slot);
+                list.at(slot).push_back(product);
+            }
+            else if (state.location.compare("belt") == 0) {
+                product.camera = "logical_camera_belt";
+                list.at(18).push_back(product);
+            }
+            else if (state.location.compare("agv") == 0) {
+                auto where = world_.agvLocation(state.holder);
+                auto camera = std::find(agv_cameras.begin(), agv_cameras.end(), state.holder + where);
+                if (camera == agv_cameras.end())
+                    continue;
+                // the real camera names drop the kitting station number
+                product.camera = "logical_camera_" + state.holder + (where.compare(0, 2, "ks") == 0 ? "ks" : where);
+                list.at(6 + (camera - agv_cameras.begin())).push_back(product);
+            }
+            else if (state.location.compare("station") == 0) {
+                product.camera = "logical_camera_station" + state.holder.substr(2);
+                list.at(1 + std::stoi(state.holder.substr(2))).push_back(product);
+            }
+        }
+        return list;
+    }
+
+    void SimLogicalCamera::segregate_parts(std::array<std::vector<Product>, 19> list)
+    {
+        camera_map_.clear();
+        for (auto& parts : list) {
+            for (auto& part : parts)
+                camera_map_[part.type].push_back(part);
+        }
+    }
+
+    std::vector<int> SimLogicalCamera::get_ebin_list()
+    {
+        std::vector<int> empty;
+        for (int bin = 1; bin <= 8; bin++) {
+            bool used{ false };
+            for (auto& part : world_.parts())
+                used = used || (part.location.compare("bin") == 0 && part.part.bin_number == bin);
+            if (!used)
+                empty.push_back(bin);
+        }
+        return empty;
+    }
+
+    void SimLogicalCamera::query_faulty_cam()
+    {
+        faulty_part_list_.clear();
+        if (world_.blackout())
+            return;
+        for (auto& state : world_.parts()) {
+            if (!state.faulty || state.location.compare("agv") != 0 || world_.agvLocation(state.holder).compare(0, 2, "ks") != 0)
+                continue;
+            Product product;
+            product.type = state.part.type;
+            product.world_pose = state.world_pose;
+            product.faulty_cam_agv = state.holder;
+            product.faulty = true;
+            faulty_part_list_.push_back(product);
+        }
+    }
+
+    std::vector<Product> SimLogicalCamera::get_station_parts(std::string station)
+    {
+        std::vector<Product> parts;
+        for (auto& state : world_.parts()) {
+            if (state.location.compare("station") != 0 || state.holder != station)
+                continue;
+            Product product;
+            product.type = state.part.type;
+            product.frame_pose = state.frame_pose;
+            product.camera = "logical_camera_station" + station.substr(2);
+            parts.push_back(product);
+        }
+        return parts;
+    }
+}//namespace
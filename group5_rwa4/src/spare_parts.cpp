@@ -0,0 +1,92 @@
+#include "../include/planner/spare_parts.h"
+#include <cmath>
+
+namespace motioncontrol {
+    namespace {
+        bool reachable_by_kitting_arm(const Product& part)
+        {
+            if (part.camera.compare("logical_camera_bins0") != 0 && part.camera.compare("logical_camera_bins1") != 0)
+                return false;
+            return part.bin_number == 1 || part.bin_number == 2 || part.bin_number == 5 || part.bin_number == 6;
+        }
+    }
+
+    int SparePartPool::reserve(const std::vector<Order>& orders, PartMap& cam_map)
+    {
+        release(cam_map);
+
+        std::map<std::string, std::size_t> demand;
+        for (auto& order : orders) {
+            for (auto& kit : order.kitting) {
+                for (auto& product : kit.products)
+                    demand[product.type]++;
+            }
+        }
+
+        int count{ 0 };
+        for (auto& required : demand) {
+            auto parts = cam_map.find(required.first);
+            if (parts == cam_map.end())
+                continue;
+
+            std::size_t free_parts{ 0 };
+            for (auto& part : parts->second) {
+                if (part.status.compare("free") == 0)
+                    free_parts++;
+            }
+            if (free_parts <= required.second)
+                continue;
+
+            // take the last reachable instance, the scan picks from the front
+            for (std::size_t i = parts->second.size(); i-- > 0;) {
+                auto& part = parts->second.at(i);
+                if (part.status.compare("free") == 0 && reachable_by_kitting_arm(part)) {
+                    part.status = "reserved";
+                    reserved_[required.first].push_back(i);
+                    count++;
+                    break;
+                }
+            }
+        }
+        ROS_INFO_STREAM("[SparePartPool] " << count << " spares reserved for " << demand.size() << " part types");
+        return count;
+    }
+
+    bool SparePartPool::take(const std::string& part_type, const geometry_msgs::Pose& near, Product& spare, PartMap& cam_map)
+    {
+        auto reserved = reserved_.find(part_type);
+        auto parts = cam_map.find(part_type);
+        if (reserved == reserved_.end() || reserved->second.empty() || parts == cam_map.end())
+            return false;
+
+        auto best = reserved->second.end();
+        double best_distance{ 0 };
+        for (auto it = reserved->second.begin(); it != reserved->second.end(); ++it) {
+            double distance = std::abs(parts->second.at(*it).world_pose.position.y - near.position.y);
+            if (best == reserved->second.end() || distance < best_distance) {
+                best = it;
+                best_distance = distance;
+            }
+        }
+
+        auto& part = parts->second.at(*best);
+        part.status = "processed";
+        spare = part;
+        reserved->second.erase(best);
+        return true;
+    }
+
+    void SparePartPool::release(PartMap& cam_map)
+    {
+        for (auto& reserved : reserved_) {
+            auto parts = cam_map.find(reserved.first);
+            if (parts == cam_map.end())
+                continue;
+            for (auto index : reserved.second) {
+                if (index < parts->second.size() && parts->second.at(index).status.compare("reserved") == 0)
+                    parts->second.at(index).status = "free";
+            }
+        }
+        reserved_.clear();
+    }
+}//namespace
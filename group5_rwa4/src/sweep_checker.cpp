@@ -0,0 +1,63 @@
+#include "../include/arm/sweep_checker.h"
+#include "../include/trace/trace.h"
+#include <moveit_msgs/GetStateValidity.h>
+#include <cmath>
+
+namespace motioncontrol {
+    namespace {
+        const std::string service{ "check_state_validity" };
+    }
+
+    void SweepChecker::init(const ros::NodeHandle& node, const std::string& group, double step)
+    {
+        node_ = node;
+        group_ = group;
+        step_ = step;
+        // one connection for every sample of every sweep
+        client_ = node_.serviceClient<moveit_msgs::GetStateValidity>(service, true);
+    }
+
+    bool SweepChecker::check(const trajectory_msgs::JointTrajectory& trajectory)
+    {
+        tracing::Span span("sweep", "check");
+        if (!client_.isValid())
+            client_ = node_.serviceClient<moveit_msgs::GetStateValidity>(service, true);
+
+        auto& points = trajectory.points;
+        std::vector<double> last;
+        int samples{ 0 };
+        for (std::size_t i{ 0 }; i < points.size(); i++) {
+            // the first and last points are always checked, the others once the joints moved enough
+            bool far = last.empty() || i + 1 == points.size();
+            for (std::size_t j{ 0 }; j < last.size() && !far; j++)
+                far = std::abs(points.at(i).positions.at(j) - last.at(j)) > step_;
+            if (!far)
+                continue;
+            last = points.at(i).positions;
+
+            moveit_msgs::GetStateValidity srv;
+            srv.request.group_name = group_;
+            // the other joints and the attached part come from the scene of move_group
+            srv.request.robot_state.is_diff = true;
+            srv.request.robot_state.joint_state.name = trajectory.joint_names;
+            srv.request.robot_state.joint_state.position = points.at(i).positions;
+            if (!client_.call(srv)) {
+                ROS_ERROR_STREAM("[SweepChecker][check] " << client_.getService() << " failed");
+                return false;
+            }
+            samples++;
+            if (!srv.response.valid) {
+                std::string contact;
+                if (!srv.response.contacts.empty())
+                    contact = " between " + srv.response.contacts.front().contact_body_1 + " and " +
+                        srv.response.contacts.front().contact_body_2;
+                ROS_WARN_STREAM("[SweepChecker][check] Collision" << contact << " at "
+                    << points.at(i).time_from_start.toSec() << " s");
+                span.arg("samples", samples);
+                return false;
+            }
+        }
+        span.arg("samples", samples);
+        return true;
+    }
+}//namespace
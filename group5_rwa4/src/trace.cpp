@@ -0,0 +1,133 @@
+#include "../include/trace/trace.h"
+#include <ros/ros.h>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tracing {
+    namespace {
+        const std::size_t buffer_size{ 8192 };  // spans kept per thread
+
+        struct ThreadBuffer {
+            std::array<Event, buffer_size> events;
+            std::atomic<std::uint64_t> head{ 0 };
+            int tid{ 0 };
+        };
+
+        std::atomic<bool> enabled_{ false };
+        const std::int64_t origin_ns{ now_ns() };
+
+        // buffers outlive their thread so the spans of finished workers still get written
+        std::mutex registry_mutex;
+        std::vector<std::unique_ptr<ThreadBuffer> > registry;
+
+        ThreadBuffer* thread_buffer()
+        {
+            thread_local ThreadBuffer* buffer{ nullptr };
+            if (buffer == nullptr) {
+                std::lock_guard<std::mutex> lock(registry_mutex);
+                registry.emplace_back(new ThreadBuffer);
+                buffer = registry.back().get();
+                buffer->tid = static_cast<int>(registry.size());
+            }
+            return buffer;
+        }
+
+        void write_escaped(std::ostream& out, const char* text)
+        {
+            for (; *text != '\0'; text++) {
+                if (*text == '"' || *text == '\\')
+                    out << '\\' << *text;
+                else if (static_cast<unsigned char>(*text) < 0x20)
+                    out << ' ';
+                else
+                    out << *text;
+            }
+        }
+    }
+
+    void enable()
+    {
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    void disable()
+    {
+        enabled_.store(false, std::memory_order_relaxed);
+    }
+
+    bool enabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    void record(const Event& event)
+    {
+        ThreadBuffer* buffer = thread_buffer();
+        auto head = buffer->head.load(std::memory_order_relaxed);
+        buffer->events[head % buffer_size] = event;
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    void Span::arg(const char* key, const std::string& value)
+    {
+        if (!active_)
+            return;
+        event_.arg_key = key;
+        std::strncpy(event_.arg_value, value.c_str(), sizeof(event_.arg_value) - 1);
+        event_.arg_value[sizeof(event_.arg_value) - 1] = '\0';
+    }
+
+    void Span::arg(const char* key, double value)
+    {
+        if (!active_)
+            return;
+        event_.arg_key = key;
+        std::snprintf(event_.arg_value, sizeof(event_.arg_value), "%g", value);
+    }
+
+    bool write(const std::string& path)
+    {
+        std::ofstream out(path);
+        if (!out) {
+            ROS_ERROR_STREAM("[tracing][write] Cannot open " << path);
+            return false;
+        }
+
+        std::size_t count{ 0 };
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (auto& buffer : registry) {
+            auto head = buffer->head.load(std::memory_order_acquire);
+            auto first = head > buffer_size ? head - buffer_size : 0;
+            for (auto i = first; i < head; i++) {
+                const Event& event = buffer->events[i % buffer_size];
+                out << (count++ == 0 ? "\n" : ",\n");
+                out << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                    << ",\"cat\":\"" << event.category << "\",\"name\":\"" << event.name
+                    << "\",\"ts\":" << (event.start_ns - origin_ns) / 1000.0
+                    << ",\"dur\":" << event.duration_ns / 1000.0;
+                if (event.arg_key != nullptr) {
+                    out << ",\"args\":{\"" << event.arg_key << "\":\"";
+                    write_escaped(out, event.arg_value);
+                    out << "\"}";
+                }
+                out << "}";
+            }
+        }
+        out << "\n]}\n";
+        if (!out) {
+            ROS_ERROR_STREAM("[tracing][write] Failed writing " << path);
+            return false;
+        }
+        ROS_INFO_STREAM("[tracing][write] " << count << " spans written to " << path);
+        return true;
+    }
+}//namespace
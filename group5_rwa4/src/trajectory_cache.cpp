@@ -0,0 +1,88 @@
+#include "../include/arm/trajectory_cache.h"
+#include "../include/trace/trace.h"
+#include <cmath>
+#include <sstream>
+
+namespace motioncontrol {
+    TrajectoryCache::TrajectoryCache(double tolerance, double bucket)
+        : tolerance_{ tolerance }, bucket_{ bucket }
+    {
+    }
+
+    std::string TrajectoryCache::make_key(const std::vector<double>& start, const std::vector<double>& goal, const MotionProfile& profile) const
+    {
+        std::ostringstream key;
+        for (auto value : start)
+            key << std::lround(value / bucket_) << ',';
+        key << '|';
+        // goals are fixed presets, the rounding only absorbs float noise
+        for (auto value : goal)
+            key << std::lround(value * 1000.0) << ',';
+        key << '|' << std::lround(profile.velocity * 100.0) << ',' << std::lround(profile.acceleration * 100.0);
+        key << '|' << held_;
+        return key.str();
+    }
+
+    bool TrajectoryCache::find(const std::vector<double>& start, const std::vector<double>& goal, const MotionProfile& profile,
+        moveit_msgs::RobotTrajectory& trajectory)
+    {
+        auto entry = entries_.find(make_key(start, goal, profile));
+        if (entry == entries_.end() || entry->second.start.size() != start.size()) {
+            misses_++;
+            return false;
+        }
+        for (std::size_t i{ 0 }; i < start.size(); i++) {
+            if (std::abs(entry->second.start.at(i) - start.at(i)) > tolerance_) {
+                misses_++;
+                return false;
+            }
+        }
+        trajectory = entry->second.trajectory;
+        hits_++;
+        return true;
+    }
+
+    void TrajectoryCache::store(const std::vector<double>& start, const std::vector<double>& goal, const MotionProfile& profile,
+        const moveit_msgs::RobotTrajectory& trajectory)
+    {
+        if (trajectory.joint_trajectory.points.empty())
+            return;
+        auto& entry = entries_[make_key(start, goal, profile)];
+        entry.start = start;
+        entry.trajectory = trajectory;
+    }
+
+    void TrajectoryCache::erase(const std::vector<double>& start, const std::vector<double>& goal, const MotionProfile& profile)
+    {
+        entries_.erase(make_key(start, goal, profile));
+    }
+
+    bool TrajectoryCache::moveTo(moveit::planning_interface::MoveGroupInterface& group, const std::vector<double>& goal, const MotionProfile& profile,
+        const JointStateCache* joint_states)
+    {
+        using moveit::planning_interface::MoveItErrorCode;
+        auto start = latestJointValues(joint_states, group);
+        profile.apply(group);
+        moveit::planning_interface::MoveGroupInterface::Plan plan;
+        if (find(start, goal, profile, plan.trajectory_)) {
+            tracing::Span span("motion", "execute_cached");
+            if (group.execute(plan) == MoveItErrorCode::SUCCESS)
+                return true;
+            ROS_WARN_STREAM("[TrajectoryCache][moveTo] Cached trajectory failed, planning again");
+            erase(start, goal, profile);
+            start = latestJointValues(joint_states, group);
+        }
+
+        group.setJointValueTarget(goal);
+        {
+            tracing::Span span("motion", "plan");
+            if (group.plan(plan) != MoveItErrorCode::SUCCESS)
+                return false;
+        }
+        tracing::Span span("motion", "execute");
+        if (group.execute(plan) != MoveItErrorCode::SUCCESS)
+            return false;
+        store(start, goal, profile, plan.trajectory_);
+        return true;
+    }
+}//namespace
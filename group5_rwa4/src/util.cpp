@@ -1,4 +1,5 @@
 #include "../include/util/util.h"
+#include "../include/trace/trace.h"
 #include <stdlib.h>
 
 namespace motioncontrol {
@@ -82,6 +83,8 @@ namespace motioncontrol {
     }
 
     geometry_msgs::Pose transformToWorldFrame(std::string part_in_camera_frame) {
+        tracing::Span span("tf", "transformToWorldFrame");
+        span.arg("frame", part_in_camera_frame);
         tf2_ros::Buffer tfBuffer;
         tf2_ros::TransformListener tfListener(tfBuffer);
         ros::Rate rate(10);
@@ -120,6 +123,8 @@ namespace motioncontrol {
     geometry_msgs::Pose transformtoWorldFrame(
         const geometry_msgs::Pose& target,
         std::string location) {
+        tracing::Span span("tf", "transformtoWorldFrame");
+        span.arg("location", location);
         static tf2_ros::StaticTransformBroadcaster br;
         geometry_msgs::TransformStamped transformStamped;
 
@@ -190,6 +195,8 @@ namespace motioncontrol {
     geometry_msgs::Pose gettransforminWorldFrame(
         const geometry_msgs::Pose& target,
         std::string frame) {
+        tracing::Span span("tf", "gettransforminWorldFrame");
+        span.arg("frame", frame);
         static tf2_ros::StaticTransformBroadcaster br;
         geometry_msgs::TransformStamped transformStamped;
 
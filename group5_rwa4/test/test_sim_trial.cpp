@@ -0,0 +1,68 @@
+/**
+ * @file test_sim_trial.cpp
+ * @brief Regression runs of OrderSequencer<SimCell> on trial files of config/trial_config
+ *
+ * A scheduling change that drops a shipment or a part shows up here as a
+ * lower score or an incomplete run, without Gazebo.
+ */
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include "../include/sim/sim_trial.h"
+
+namespace {
+    sim::TrialConfig load(const std::string& name)
+    {
+        sim::TrialConfig trial;
+        EXPECT_TRUE(trial.load(std::string(SIM_TRIAL_DIR) + "/" + name));
+        return trial;
+    }
+}
+
+TEST(SimTrial, KitsOfOneOrderAreShipped)
+{
+    auto result = sim::runTrial(load("kitting_sample.yaml"), sim::SimTiming(), 1, sim::Policy());
+    EXPECT_TRUE(result.completed);
+    EXPECT_DOUBLE_EQ(result.score, 6.0);
+}
+
+TEST(SimTrial, FaultyPartsAndBlackoutKeepTheScore)
+{
+    // two faulty parts, a sensor blackout after the first part and a high-priority order
+    auto trial = load("rwa3.yaml");
+    sim::Policy no_spares;
+    no_spares.sequencer.spares = false;
+    for (auto& policy : { sim::Policy(), no_spares }) {
+        auto result = sim::runTrial(trial, sim::SimTiming(), 1, policy);
+        EXPECT_TRUE(result.completed);
+        EXPECT_DOUBLE_EQ(result.score, 21.0);
+    }
+}
+
+TEST(SimTrial, HighPriorityOrderIsServed)
+{
+    auto trial = load("final.yaml");
+    sim::Policy no_preemption;
+    no_preemption.preemption = false;
+    for (auto& policy : { sim::Policy(), no_preemption }) {
+        auto result = sim::runTrial(trial, sim::SimTiming(), 1, policy);
+        EXPECT_TRUE(result.completed);
+        EXPECT_DOUBLE_EQ(result.score, 26.0);
+    }
+}
+
+TEST(SimTrial, SameSeedReplaysTheSameRun)
+{
+    auto trial = load("final.yaml");
+    auto first = sim::runTrial(trial, sim::SimTiming(), 7, sim::Policy());
+    auto second = sim::runTrial(trial, sim::SimTiming(), 7, sim::Policy());
+    EXPECT_DOUBLE_EQ(first.makespan, second.makespan);
+    EXPECT_DOUBLE_EQ(first.score, second.score);
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    // ros::Time is used by the shared planners, run it on the wall clock without a master
+    ros::Time::init();
+    return RUN_ALL_TESTS();
+}